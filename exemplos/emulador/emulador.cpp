@@ -0,0 +1,73 @@
+/*
+ * Exemplo: dois chips emulados (PTX e PRX) no computador, sem hardware.
+ *
+ * Compilar na pasta da biblioteca:
+ *   g++ -I. nrf.cpp nrf_emu.cpp exemplos/emulador/emulador.cpp -o emulador
+ */
+#include<stdio.h>
+#include "nrf.h"
+#include "nrf_emu.h"
+
+/* device addresses */
+const uint8_t ptx_addr[5]={12,48,68,99,14};
+const uint8_t prx_addr[5]={17,11,22,134,192};
+
+static void configure(nrf *rfmodule){
+  rfmodule->set_rf_datarate(NRF_2MBPS);
+  rfmodule->set_rf_channel(25);
+  rfmodule->set_rf_power(NRF_0DBM);
+  rfmodule->set_address_width(NRF_AW_5BYTES);
+  rfmodule->enable_rx_pipe(NRF_PIPE0,true);
+  rfmodule->enable_rx_pipe(NRF_PIPE1,true);
+  rfmodule->set_dynamic_payload(NRF_PIPE0,true);
+  rfmodule->set_dynamic_payload(NRF_PIPE1,true);
+  rfmodule->set_retr_param(15,1);
+}
+
+int main(void){
+  nrf_air air;
+  nrf_emu ptx_chip(&air), prx_chip(&air);
+  nrf ptx(&ptx_chip), prx(&prx_chip);
+  uint8_t buff[33],length,pipe;
+  int sent=0,received=0;
+
+  printf("<< Teste com chips emulados >>\n\n");
+
+  /* aguarda o 'power on reset' dos chips (relogio virtual) */
+  while(!ptx.is_ready())
+    air.advance(1000);
+  while(!prx.is_ready())
+    air.advance(1000);
+
+  configure(&ptx);
+  ptx.set_rx_address(NRF_PIPE0,(uint8_t*)prx_addr,5);
+  ptx.set_rx_address(NRF_PIPE1,(uint8_t*)ptx_addr,5);
+  ptx.set_tx_address((uint8_t*)prx_addr,5);
+
+  configure(&prx);
+  prx.set_rx_address(NRF_PIPE0,(uint8_t*)ptx_addr,5);
+  prx.set_rx_address(NRF_PIPE1,(uint8_t*)prx_addr,5);
+  prx.set_mode(NRF_RX_MODE);
+
+  /* 10% de perdas no canal: os pacotes perdidos sao retransmitidos (auto-ack) */
+  air.set_loss(25,10);
+
+  for(int i=0;i<100;i++){
+    length=sprintf((char*)buff,"pacote %d",i);
+    ptx.write_tx_payload(buff,length);
+    ptx.set_mode(NRF_TX_MODE);
+    if(ptx.wait_packet_sent())
+      sent++;
+    ptx.set_mode(NRF_STANDBY);
+
+    while(prx.available()){
+      prx.read_received_payload(buff,&length,&pipe);
+      received++;
+    }
+  }
+
+  printf("Enviados: %d\nRecebidos: %d\n",sent,received);
+  printf("Tempo (virtual): %lu us\n",(unsigned long)prx_chip.micros());
+  printf("Transacoes SPI (PTX): %lu\n",(unsigned long)ptx_chip.get_transactions());
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "nrf.h"
+#include "nrf_bus.h"
+#include<SPI.h>
+
+/* radio de recepcao */
+const int rxCePin=9;
+const int rxCsnPin=10;
+const int rxIrqPin=2;
+
+/* radio de transmissao */
+const int txCePin=7;
+const int txCsnPin=8;
+const int txIrqPin=3;
+
+/* device addresses */
+const uint8_t node_addr[5]={12,48,68,99,14};
+const uint8_t server_addr[5]={17,11,22,134,192};
+
+nrf *rx_radio, *tx_radio;
+nrf_bus bus;
+
+/* pacotes recebidos aguardando envio */
+uint8_t queue[8][32];
+uint8_t queue_length[8];
+uint8_t head=0, tail=0;
+unsigned long forwarded=0, failed=0;
+
+void received(const uint8_t *buff, uint8_t length, uint8_t pipe){
+  if((uint8_t)(head-tail) < 8){
+    memcpy(queue[head&7],buff,length);
+    queue_length[head&7]=length;
+    head++;
+  }
+}
+
+void sent(uint8_t handle){
+  forwarded++;
+}
+
+void send_failed(uint8_t handle, uint8_t retries){
+  failed++;
+}
+
+void setup(){
+  Serial.begin(9600);
+  Serial.print("<< Gateway com dois radios (recepcao e transmissao simultaneas) >>\n\n");
+  
+  rx_radio = new nrf(rxCePin,rxCsnPin);
+  tx_radio = new nrf(txCePin,txCsnPin);
+  bus.attach(rx_radio);
+  bus.attach(tx_radio);
+  while(!bus.is_ready()){}  //aguarda o 'power on reset' dos chips
+  
+  /* radio de recepcao: canal 25, permanece no modo RX */
+  rx_radio->set_rf_datarate(NRF_2MBPS);
+  rx_radio->set_rf_channel(25);
+  rx_radio->set_address_width(NRF_AW_5BYTES);
+  rx_radio->enable_rx_pipe(NRF_PIPE1,true);
+  rx_radio->set_dynamic_payload(NRF_PIPE1,true);
+  rx_radio->set_rx_address(NRF_PIPE1,(uint8_t*)node_addr,5);
+  rx_radio->set_irq_pin(rxIrqPin);
+  rx_radio->enable_rx_interrupt();
+  rx_radio->on_received(received);
+  rx_radio->set_mode(NRF_RX_MODE);
+  
+  /* radio de transmissao: canal 80, envia ao servidor */
+  tx_radio->set_rf_datarate(NRF_2MBPS);
+  tx_radio->set_rf_channel(80);
+  tx_radio->set_address_width(NRF_AW_5BYTES);
+  tx_radio->enable_rx_pipe(NRF_PIPE0,true);
+  tx_radio->set_dynamic_payload(NRF_PIPE0,true);
+  tx_radio->set_rx_address(NRF_PIPE0,(uint8_t*)server_addr,5);
+  tx_radio->set_tx_address((uint8_t*)server_addr,5);
+  tx_radio->set_irq_pin(txIrqPin);
+  tx_radio->on_sent(sent);
+  tx_radio->on_failed(send_failed);
+}
+
+void loop(){
+  static unsigned long last=0;
+  
+  /* atende os dois radios: entrega os pacotes recebidos e os resultados dos envios */
+  bus.poll();
+  
+  /* repassa os pacotes recebidos enquanto houver espaco na fila de transmissao */
+  while(head!=tail && tx_radio->send_async(queue[tail&7],queue_length[tail&7])!=NRF_NO_HANDLE)
+    tail++;
+  
+  if(millis()-last > 1000){
+    last=millis();
+    Serial.print("Repassados: ");
+    Serial.print(forwarded);
+    Serial.print(" Falhas: ");
+    Serial.println(failed);
+  }
+}
@@ -16,6 +16,7 @@ void setup(){
 
 void loop(){
   nrf rfmodule(cePin,csnPin);
+  while(!rfmodule.is_ready()){}  //aguarda o 'power on reset' do chip
   
   /* configura modulo rf 
   *
@@ -0,0 +1,60 @@
+#include "nrf.h"
+#include "nrf_hub.h"
+#include<SPI.h>
+
+/* rf module pins */
+const int cePin=9;
+const int csnPin=10;
+
+/* enderecos da rede: base dos nos (o primeiro byte e o LSB de cada no) e endereco de entrada */
+const uint8_t base_addr[5]={0,0xC3,0xC3,0xC3,0xC3};
+const uint8_t join_addr[5]={0xE7,0xE7,0xE7,0xE7,0xE7};
+
+nrf *rfmodule;
+nrf_hub *hub;
+
+void setup(){
+  Serial.begin(9600);
+  Serial.print("<< Concentrador de rede em estrela >>\n\n");
+  
+  rfmodule = new nrf(cePin,csnPin);
+  while(!rfmodule->is_ready()){}  //aguarda o 'power on reset' do chip
+  rfmodule->set_rf_datarate(NRF_2MBPS);
+  rfmodule->set_rf_channel(25);
+  rfmodule->set_rf_power(NRF_0DBM);
+  
+  hub = new nrf_hub(rfmodule);
+  hub->begin(base_addr,join_addr);
+  hub->set_schedule(200);  //troca os nos dos pipes a cada 200ms
+}
+
+void loop(){
+  static unsigned long last=0;
+  uint8_t buff[33],length,node;
+  
+  hub->poll();
+  while(hub->read(buff,&length,&node)){
+    if(node==NRF_HUB_NO_NODE)
+      continue;
+    buff[length]=0;
+    Serial.print(node);
+    Serial.print(": ");
+    Serial.print((char*)buff);
+    Serial.print("\n");
+  }
+  
+  if(millis()-last > 10000){
+    last=millis();
+    for(uint8_t i=0;i<NRF_HUB_MAX_NODES;i++){
+      const nrf_hub_node_t *info=hub->get_node(i);
+      if(info==NULL)
+        continue;
+      Serial.print("No ");
+      Serial.print(i);
+      Serial.print(" recebidos: ");
+      Serial.print(info->received);
+      Serial.print(" descartados: ");
+      Serial.println(info->dropped);
+    }
+  }
+}
@@ -0,0 +1,77 @@
+#include "nrf.h"
+#include "nrf_hub.h"
+#include<SPI.h>
+
+/* rf module pins */
+const int cePin=9;
+const int csnPin=10;
+
+/* endereco de entrada do concentrador e identificador deste no (unico na rede, diferente de 0) */
+const uint8_t join_addr[5]={0xE7,0xE7,0xE7,0xE7,0xE7};
+const uint32_t uid=0x7A000001UL;
+
+uint8_t node_addr[5];
+nrf *rfmodule;
+
+/* envia um pacote ao endereco, com auto-ack (o pipe0 recebe o ACK) */
+bool send(const uint8_t *addr, uint8_t *buff, uint8_t length){
+  rfmodule->set_tx_address((uint8_t*)addr,5);
+  rfmodule->set_rx_address(NRF_PIPE0,(uint8_t*)addr,5);
+  rfmodule->write_tx_payload(buff,length);
+  rfmodule->set_mode(NRF_TX_MODE);
+  bool sent=rfmodule->wait_packet_sent();
+  rfmodule->set_mode(NRF_STANDBY);
+  return sent;
+}
+
+/* pede o endereco ao concentrador: a resposta chega no ACK do pedido seguinte */
+void join(){
+  uint8_t request[5]={NRF_HUB_JOIN,(uint8_t)uid,(uint8_t)(uid>>8),(uint8_t)(uid>>16),(uint8_t)(uid>>24)};
+  uint8_t reply[32],length;
+  while(true){
+    if(send(join_addr,request,5)){
+      while(rfmodule->read_ack_payload(reply,&length)){
+        if(length==10 && reply[0]==NRF_HUB_ASSIGN && !memcmp(&reply[1],&request[1],4)){
+          memcpy(node_addr,&reply[5],5);
+          return;
+        }
+      }
+    }
+    delay(2);
+  }
+}
+
+void setup(){
+  Serial.begin(9600);
+  Serial.print("<< Sensor de rede em estrela >>\n\n");
+  
+  rfmodule = new nrf(cePin,csnPin);
+  while(!rfmodule->is_ready()){}  //aguarda o 'power on reset' do chip
+  rfmodule->set_rf_datarate(NRF_2MBPS);
+  rfmodule->set_rf_channel(25);
+  rfmodule->set_rf_power(NRF_0DBM);
+  rfmodule->set_address_width(NRF_AW_5BYTES);
+  rfmodule->set_retr_param(5,1);  //5 retransmissoes a cada 500us
+  rfmodule->enable_rx_pipe(NRF_PIPE0,true);
+  rfmodule->enable_ack_payload(true);
+  
+  join();
+  Serial.print("Endereco atribuido: ");
+  Serial.println(node_addr[0]);
+}
+
+void loop(){
+  char message[]="leitura";
+  uint8_t ack[32],length;
+  
+  if(!send(node_addr,(uint8_t*)message,sizeof(message)-1)){
+    /* fora dos pipes do concentrador: pede um pipe e repete */
+    uint8_t wake[2]={NRF_HUB_WAKE,node_addr[0]};
+    send(join_addr,wake,2);
+    delay(2);
+    if(!send(node_addr,(uint8_t*)message,sizeof(message)-1))
+      Serial.print("Falha no envio\n");
+  }
+  while(rfmodule->read_ack_payload(ack,&length));
+  delay(1000);
+}
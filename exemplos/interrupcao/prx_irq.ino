@@ -0,0 +1,55 @@
+#include "nrf.h"
+#include<SPI.h>
+
+/* rf module pins */
+const int cePin=9;
+const int csnPin=10;
+const int irqPin=2;
+
+/* device addresses */
+const uint8_t ptx_addr[5]={12,48,68,99,14};
+const uint8_t prx_addr[5]={17,11,22,134,192};
+
+nrf *rfmodule;
+
+void setup(){
+  Serial.begin(9600);
+  Serial.print("<< Teste de dispositivo no modo PRX (interrupcao) >>\n\n");
+  
+  rfmodule = new nrf(cePin,csnPin);
+  while(!rfmodule->is_ready()){}  //aguarda o 'power on reset' do chip
+  
+  /* configura modulo rf (mesma configuracao do exemplo helloWorld) */
+  rfmodule->set_rf_datarate(NRF_2MBPS);
+  rfmodule->set_rf_channel(25);
+  rfmodule->set_rf_power(NRF_0DBM);
+  rfmodule->set_address_width(NRF_AW_5BYTES);
+  rfmodule->enable_rx_pipe(NRF_PIPE0,true);
+  rfmodule->enable_rx_pipe(NRF_PIPE1,true);
+  rfmodule->set_dynamic_payload(NRF_PIPE0,true);
+  rfmodule->set_dynamic_payload(NRF_PIPE1,true);
+  rfmodule->set_rx_address(NRF_PIPE0,(uint8_t*)ptx_addr,5);
+  rfmodule->set_rx_address(NRF_PIPE1,(uint8_t*)prx_addr,5);
+  
+  /* pacotes sao copiados para a memoria a cada interrupcao */
+  rfmodule->set_irq_pin(irqPin);
+  rfmodule->enable_rx_interrupt();
+  rfmodule->set_mode(NRF_RX_MODE);
+}
+
+void loop(){
+  uint8_t buff[33],length,pipe;
+  /* apenas leituras da memoria, sem acesso a interface SPI */
+  while(rfmodule->read_received_payload(buff,&length,&pipe)){
+    buff[length]=0;
+    Serial.print(pipe);
+    Serial.print(": ");
+    Serial.print((char*)buff);
+    Serial.print("\n");
+  }
+  if(rfmodule->get_rx_overruns()){
+    Serial.print("Pacotes descartados: ");
+    Serial.println(rfmodule->get_rx_overruns());
+  }
+  delay(100);
+}
@@ -81,7 +81,7 @@
 #define ERX_P0  BIT(0)
 
 /* SETUP_AW register */
-#define AW 0x02
+#define AW 0x03
                     
 /* SETUP_RETR register */
 #define ARD 0xF0
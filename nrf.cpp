@@ -6,35 +6,398 @@
  * \brief código-fonte da classe 'nrf'
  * */
 
+#include<string.h>
 #include "nrf.h"
+#if defined(ARDUINO)
+#include "nrf_arduino.h"
+#endif
 
+/* barreira do compilador: os acessos ao buffer circular não atravessam as escritas dos índices */
+#define NRF_BARRIER()   __asm__ __volatile__("" ::: "memory")
+
+#if !defined(ARDUINO)
+#define PROGMEM                 // tabelas em RAM fora do Arduino
+#define memcpy_P    memcpy
+#define pgm_read_byte(address)  (*(const uint8_t *)(address))
+#define PSTR(text)  (text)
+#endif
+
+nrf *nrf::_isr_instances[NRF_MAX_RADIOS];
+
+/* rotinas de interrupção: attachInterrupt não informa a instância */
+void (* const nrf::isr_table[NRF_MAX_RADIOS])(void) = {
+    nrf::rx_isr<0>,
+#if NRF_MAX_RADIOS > 1
+    nrf::rx_isr<1>,
+#endif
+#if NRF_MAX_RADIOS > 2
+    nrf::rx_isr<2>,
+#endif
+#if NRF_MAX_RADIOS > 3
+    nrf::rx_isr<3>,
+#endif
+};
+
+#if defined(ARDUINO)
 /**
  * \brief Construtor da classe
  * 
  * \param[in] ce Pino do Arduino atribuído ao 'chip enable' (CE)
  * \param[in] csn Pino do Arduino atribuído ao 'chip select' (CSN)
+ * \param[in] spi_clock Frequência do clock SPI em Hz (máximo de 10MHz)
+ * 
+ * O construtor não acessa o chip. Aguarde \ref is_ready antes de configurá-lo: os métodos que
+ * acessam o chip antes disso bloqueiam até o fim do 'power on reset' (\ref NRF_POR_DELAY).
+ * 
+ * O acesso ao hardware (\ref nrf_arduino_backend) é alocado dinamicamente e liberado pelo
+ * destrutor; as instâncias criadas com \ref nrf::nrf(nrf_backend *) não o alocam.
+ * 
+ * \warning Após a classe ser instanciada, o dispositivo é colocado no modo 'POWER_DOWN'. 
+ */
+nrf::nrf(uint8_t ce, uint8_t csn, uint32_t spi_clock){
+    nrf_arduino_backend *arduino = new nrf_arduino_backend;
+    arduino->begin(ce, csn, spi_clock);   // configura pinos e interface SPI
+    _bus = arduino;
+    _owns_bus = true;
+    nrf::init();
+}
+#endif
+
+/**
+ * \brief Construtor da classe
+ * 
+ * Utilize este construtor para acessar o chip através de outra plataforma (ver \ref nrf_backend).
+ * 
+ * \param[in] *backend Acesso ao hardware, já configurado.
+ * 
+ * O construtor não acessa o chip. Aguarde \ref is_ready antes de configurá-lo: os métodos que
+ * acessam o chip antes disso bloqueiam até o fim do 'power on reset' (\ref NRF_POR_DELAY).
  * 
  * \warning Após a classe ser instanciada, o dispositivo é colocado no modo 'POWER_DOWN'. 
  */
-nrf::nrf(uint8_t ce, uint8_t csn){
-    nrf::_ce = ce;
-	nrf::_csn = csn;
+nrf::nrf(nrf_backend *backend){
+    _bus = backend;
+    _owns_bus = false;
+    nrf::init();
+}
+
+/**
+ * \brief Destrutor da classe
+ * 
+ * Desabilita a recepção por interrupção (ver \ref enable_rx_interrupt) e libera o acesso ao
+ * hardware alocado pelo construtor com pinos. O acesso informado em \ref nrf::nrf(nrf_backend *)
+ * pertence à aplicação e não é liberado.
+ */
+nrf::~nrf(){
+    nrf::disable_rx_interrupt();
+    if(_owns_bus)
+        delete _bus;
+}
+
+/**
+ * \brief Inicializa o dispositivo
+ * 
+ * Não há acesso à interface SPI: o chip só responde após o 'power on reset' (ver
+ * \ref NRF_POR_DELAY). A inicialização é concluída por \ref is_ready , \ref poll ou pelo
+ * primeiro método que acessar o chip (ver \ref complete_init); neste último caso, o método
+ * bloqueia até o fim do 'power on reset'.
+ */
+void nrf::init(void){
+#if NRF_TRACE
+    nrf::_trace_id = NRF_TRACE_NONE;
+    nrf::reset_trace();
+#endif
+#if NRF_STATS
+    nrf::_dest_count = 0;
+    nrf::_dest = NRF_STATS_NO_DESTINATION;
+    nrf::_plos = 0;
+    nrf::reset_stats();
+#endif
+    nrf::_irq = NRF_NO_IRQ;
+    nrf::_status = RX_P_NO;
+    nrf::_rx_interrupt = false;
+    nrf::_ring_head = 0;
+    nrf::_ring_tail = 0;
+    nrf::_ring_overruns = 0;
+    nrf::_beacon_active = false;
+    nrf::_beacon_masks = 0;
+    nrf::_async_count = 0;
+    nrf::_async_next = 0;
+    nrf::_on_sent = NULL;
+    nrf::_on_failed = NULL;
+    nrf::_on_received = NULL;
+    nrf::_power_up_delay = NRF_POWER_UP_DELAY;
+    nrf::_settle_delay = NRF_SETTLE_DELAY;
 	
-	pinMode(_ce, OUTPUT);   // setup ce pin
     nrf::chip_disable();    // chip no modo 'POWER_DOWN'
                             // após o 'power on reset'
-        
-    spi_begin(_csn);    // configura e inicia a interface SPI
-    
-    nrf::spi_write_register(CONFIG,EN_CRC); // bits PWR_UP=0 e PRIM_RX=0
     _current_mode = NRF_POWER_DOWN;
     _last_mode = _current_mode;
     
-    delay(100);  // assegura atraso no 'power on reset'
+    _ready_at = _bus->micros() + NRF_POR_DELAY;
+    _init_pending = true;
+}
+
+/**
+ * \brief Conclui a inicialização do dispositivo
+ * 
+ * Aguarda o fim do 'power on reset', coloca o chip no modo 'POWER_DOWN', descarrega os
+ * FIFOs e carrega a cópia local dos registradores. Executada uma única vez, antes do
+ * primeiro acesso ao chip.
+ */
+void nrf::complete_init(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_INIT);
+    _init_pending = false;
+    nrf::wait_ready();  // assegura atraso no 'power on reset'
     
+    nrf::spi_write_register(CONFIG,EN_CRC); // bits PWR_UP=0 e PRIM_RX=0
     nrf::flush_rx_fifo();   // limpa buffer de recepção
     nrf::flush_tx_fifo();   // limpa buffer de transmissão
     nrf::clear_all_int_flags(); // limpa flags de interrupção
+    nrf::sync_registers();  // carrega a cópia local dos registradores
+}
+
+/**
+ * \brief Verifica se o dispositivo está pronto
+ * 
+ * Após o construtor e após as transições de modo (ver \ref begin_mode), o chip precisa de um
+ * tempo de estabilização. Esta função não bloqueia: utilize-a para executar outras tarefas
+ * enquanto o chip estabiliza. A inicialização é concluída assim que o chip estiver pronto.
+ * 
+ * \return true se o tempo de estabilização foi atingido
+ */
+bool nrf::is_ready(void){
+    if((int32_t)(_bus->micros() - _ready_at) < 0)
+        return false;
+    if(_init_pending)
+        nrf::complete_init();
+    return true;
+}
+
+/**
+ * \brief Executa as tarefas pendentes do dispositivo
+ * 
+ * Deve ser chamada periodicamente no loop principal. Não bloqueia: conclui a inicialização,
+ * informa o resultado dos envios assíncronos (ver \ref send_async) e os pacotes recebidos
+ * (ver \ref on_received). Com \ref is_ready , é o único método que nunca aguarda o chip: os
+ * métodos de configuração, envio e recepção bloqueiam durante o 'power on reset' e
+ * \ref set_mode aguarda a estabilização do novo modo. A interface SPI só é acessada quando o
+ * pino de IRQ (ver \ref set_irq_pin) ou o último STATUS indicam eventos.
+ */
+void nrf::poll(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_POLL);
+    if(!nrf::is_ready())
+        return;
+    if(_async_count > 0)
+        nrf::poll_async();
+    if(_on_received != NULL && _current_mode != NRF_POWER_DOWN){
+        uint8_t buff[32], length, pipe;
+        while(nrf::read_received_payload(buff, &length, &pipe))
+            _on_received(buff, length, pipe);
+    }
+}
+
+/**
+ * \brief Configura os tempos de estabilização do chip
+ * 
+ * Os valores padrão são os do datasheet (ver \ref NRF_POWER_UP_DELAY e \ref NRF_SETTLE_DELAY).
+ * 
+ * \param[in] power_up Tempo de partida do oscilador, do modo 'power down' ao 'standby' (us)
+ * \param[in] settle Tempo de estabilização do PLL, do modo 'standby' aos modos 'rx' e 'tx' (us)
+ */
+void nrf::set_settle_times(uint16_t power_up, uint16_t settle){
+    _power_up_delay = power_up;
+    _settle_delay = settle;
+}
+
+/* bloqueia até o chip estar pronto */
+void nrf::wait_ready(void){
+    int32_t remaining = (int32_t)(_ready_at - _bus->micros());
+    if(remaining > 0)
+        _bus->delay_us(remaining);
+}
+
+/**
+ * \brief Retorna a posição do registrador na cópia local (cache)
+ * 
+ * Os registradores de configuração CONFIG a RF_SETUP, RX_ADDR_P2 a RX_ADDR_P5, RX_PW_P0 a
+ * RX_PW_P5, DYNPD e FEATURE possuem uma cópia na memória do microcontrolador, atualizada a
+ * cada escrita. Os endereços de 5 bytes possuem cópia à parte (ver \ref address_shadow).
+ * 
+ * \param[in] register_addr Endereço do registrador
+ * \return Índice na cópia local ou \c NRF_NOT_SHADOWED
+ */
+uint8_t nrf::shadow_index(uint8_t register_addr){
+    if(register_addr <= RF_SETUP)
+        return register_addr;
+    if(register_addr >= RX_ADDR_P2 && register_addr <= RX_ADDR_P5)
+        return register_addr - RX_ADDR_P2 + (RF_SETUP + 1);
+    if(register_addr >= RX_PW_P0 && register_addr <= RX_PW_P5)
+        return register_addr - RX_PW_P0 + (RF_SETUP + 5);
+    if(register_addr == DYNPD)
+        return NRF_SHADOW_SIZE - 2;
+    if(register_addr == FEATURE)
+        return NRF_SHADOW_SIZE - 1;
+    return NRF_NOT_SHADOWED;
+}
+
+/**
+ * \brief Retorna a cópia local de um endereço de 5 bytes
+ * 
+ * \param[in] register_addr RX_ADDR_P0, RX_ADDR_P1 ou TX_ADDR
+ * \return Cópia do endereço (byte menos significativo primeiro) ou NULL para os demais registradores
+ */
+uint8_t *nrf::address_shadow(uint8_t register_addr){
+    if(register_addr == RX_ADDR_P0 || register_addr == RX_ADDR_P1)
+        return _address_shadow[register_addr - RX_ADDR_P0];
+    if(register_addr == TX_ADDR)
+        return _address_shadow[2];
+    return NULL;
+}
+
+/**
+ * \brief Retorna o valor do registrador armazenado na cópia local
+ * 
+ * Não há acesso à interface SPI.
+ * 
+ * \param[in] register_addr Endereço do registrador (deve possuir cópia local)
+ * \return Último valor escrito no registrador
+ */
+uint8_t nrf::shadow(uint8_t register_addr){
+    if(_init_pending)
+        nrf::complete_init();
+    return _shadow[nrf::shadow_index(register_addr)];
+}
+
+/**
+ * \brief Recarrega a cópia local dos registradores de configuração
+ * 
+ * Os métodos de configuração e consulta utilizam uma cópia local dos registradores,
+ * evitando leituras pela interface SPI. Utilize esta função caso o chip tenha sido
+ * configurado por outro meio (outra instância, reset do chip, etc.).
+ */
+void nrf::sync_registers(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_SYNC_REGISTERS);
+    for(uint8_t reg=CONFIG; reg<=FEATURE; reg++){
+        uint8_t i = nrf::shadow_index(reg);
+        if(i != NRF_NOT_SHADOWED)
+            nrf::spi_read_register(reg, &_shadow[i]);
+        uint8_t *address = nrf::address_shadow(reg);
+        if(address != NULL)
+            nrf::spi_read_multibyte_register(reg, address, 5);
+    }
+}
+
+/**
+ * \brief Aplica uma configuração completa do rádio
+ * 
+ * Calcula o valor final de cada registrador de configuração e escreve apenas os registradores
+ * que diferem da cópia local (ver \ref sync_registers), uma transação SPI por registrador.
+ * Os endereços são escritos apenas quando informados (ponteiros diferentes de NULL) e
+ * diferentes da cópia local: reaplicar a mesma configuração não gera transações.
+ * 
+ * Os bits PWR_UP e PRIM_RX (modo de operação) são preservados. O bit EN_DPL é calculado a
+ * partir dos pipes com payload dinâmico e de EN_ACK_PAY, que também exige payload dinâmico
+ * no PIPE0. O tamanho estático de pipes desabilitados ou com payload dinâmico não é alterado.
+ * 
+ * \param[in] *profile Configuração (ver \ref nrf_profile_t)
+ * 
+ * \warning Aplique a configuração com o dispositivo no modo 'standby' ou 'power down'.
+ */
+void nrf::apply_profile(const nrf_profile_t *profile){
+    NRF_TRACE_SCOPE(NRF_TRACE_APPLY_PROFILE);
+    if(_init_pending)
+        nrf::complete_init();   // a imagem parte da cópia local carregada do chip
+    uint8_t image[NRF_SHADOW_SIZE];
+    memcpy(image, _shadow, sizeof(image));
+    
+    uint8_t masks = profile->irq_masks & (MASK_RX_DR|MASK_TX_DS|MASK_MAX_RT);
+    if(_rx_interrupt){
+        _config_masks = masks;  // restauradas por disable_rx_interrupt
+        masks = MASK_TX_DS | MASK_MAX_RT;
+    }
+    image[CONFIG] = (image[CONFIG] & (PWR_UP|PRIM_RX)) | EN_CRC | masks |
+                    ((profile->crc == NRF_CRC_2BYTES)? CRCO : 0);
+    
+    uint8_t en_aa = 0, en_rxaddr = 0, dynpd = 0;
+    for(uint8_t pipe=0; pipe<6; pipe++){
+        const nrf_pipe_profile_t *p = &profile->pipes[pipe];
+        if(!p->enabled)
+            continue;
+        en_rxaddr |= BIT(pipe);
+        if(p->auto_ack)
+            en_aa |= BIT(pipe);
+        if(p->width == 0)
+            dynpd |= BIT(pipe);
+        else
+            image[nrf::shadow_index(RX_PW_P0 + pipe)] = (p->width > 32)? 32 : p->width;
+    }
+    uint8_t feature = profile->features & (EN_ACK_PAY|EN_DYN_ACK);
+    if(feature & EN_ACK_PAY)
+        dynpd |= BIT(0);
+    if(dynpd)
+        feature |= EN_DPL;
+    
+    image[EN_AA] = en_aa;
+    image[EN_RXADDR] = en_rxaddr;
+    image[SETUP_AW] = (uint8_t)profile->address_width;
+    image[SETUP_RETR] = ((profile->retr_delay & 0x0F)<<4) | (profile->retr_count & 0x0F);
+    image[RF_CH] = profile->channel & 0x7F;
+    image[RF_SETUP] &= ~(RF_DR_LOW|RF_DR_HIGH|RF_PWR);
+    image[RF_SETUP] |= ((uint8_t)profile->power) << 1;
+    if(profile->datarate == NRF_250KBPS)
+        image[RF_SETUP] |= RF_DR_LOW;
+    else if(profile->datarate == NRF_2MBPS)
+        image[RF_SETUP] |= RF_DR_HIGH;
+    image[nrf::shadow_index(DYNPD)] = dynpd;
+    image[nrf::shadow_index(FEATURE)] = feature;
+    for(uint8_t pipe=2; pipe<6; pipe++){
+        if(profile->pipes[pipe].address != NULL)
+            image[nrf::shadow_index(RX_ADDR_P0 + pipe)] = profile->pipes[pipe].address[0];
+    }
+    
+    for(uint8_t reg=CONFIG; reg<=FEATURE; reg++){
+        uint8_t i = nrf::shadow_index(reg);
+        if(i != NRF_NOT_SHADOWED && image[i] != _shadow[i])
+            nrf::spi_write_register(reg, image[i]);
+    }
+    
+    uint8_t width = (uint8_t)profile->address_width + 2;
+    const uint8_t *addresses[3] = {profile->pipes[0].address, profile->pipes[1].address, profile->tx_address};
+    for(uint8_t i=0; i<3; i++){
+        uint8_t reg = (i < 2)? RX_ADDR_P0 + i : TX_ADDR;
+        if(addresses[i] != NULL && memcmp(nrf::address_shadow(reg), addresses[i], width) != 0)
+            nrf::spi_write_multibyte_register(reg, addresses[i], width);
+    }
+}
+
+/**
+ * \brief Verifica se a cópia local confere com os registradores do chip
+ * 
+ * \return true ou false
+ * \retval true Todos os registradores conferem
+ * \retval false Algum registrador foi alterado externamente. Utilize \ref sync_registers .
+ */
+bool nrf::verify_registers(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_VERIFY_REGISTERS);
+    for(uint8_t reg=CONFIG; reg<=FEATURE; reg++){
+        uint8_t i = nrf::shadow_index(reg);
+        if(i != NRF_NOT_SHADOWED){
+            uint8_t value;
+            nrf::spi_read_register(reg, &value);
+            if(value != _shadow[i])
+                return false;
+        }
+        uint8_t *address = nrf::address_shadow(reg);
+        if(address != NULL){
+            uint8_t value[5];
+            uint8_t width = nrf::shadow(SETUP_AW) + 2;
+            nrf::spi_read_multibyte_register(reg, value, width);
+            if(memcmp(value, address, width) != 0)
+                return false;
+        }
+    }
+    return true;
 }
 
 /**
@@ -43,7 +406,7 @@ nrf::nrf(uint8_t ce, uint8_t csn){
  * Utilize esta função colocar o pino CE em '1'. 
  */
 void nrf::chip_enable(void){
-	digitalWrite(_ce,HIGH);
+	_bus->write_ce(true);
 }
 
 /**
@@ -53,14 +416,51 @@ void nrf::chip_enable(void){
  * 
  */
 void nrf::chip_disable(void){
-	digitalWrite(_ce,LOW);
+	_bus->write_ce(false);
+}
+
+/**
+ * \brief Executa um comando SPI
+ * 
+ * O comando e os dados são transferidos numa única seleção do chip, diretamente de/para
+ * os buffers informados, sem cópias intermediárias.
+ * 
+ * \param[in] command Comando (ver nordic.h)
+ * \param[in] *tx Dados enviados após o comando. Se NULL, envia NOP.
+ * \param[out] *rx Dados recebidos após o comando. Se NULL, são descartados.
+ * \param[in] length Número de bytes de dados
+ * \return Estado do dispositivo (conteúdo do registrador STATUS)
+ */
+uint8_t nrf::spi_command(uint8_t command, const uint8_t *tx, uint8_t *rx, uint8_t length){
+    if(_init_pending)
+        nrf::complete_init();
+    spi_segment_t segments[2];
+    segments[0].tx = &command;
+    segments[0].rx = &_status;
+    segments[0].length = 1;
+    segments[1].tx = tx;
+    segments[1].rx = rx;
+    segments[1].length = length;
+#if NRF_TRACE
+    uint32_t start = _bus->micros();
+    _bus->transfer(segments, (length > 0)? 2:1);
+    if(_trace_id != NRF_TRACE_NONE){
+        nrf_trace_t *t = &_trace[_trace_id];
+        t->transactions++;
+        t->bytes += 1 + length;
+        t->spi_us += _bus->micros() - start;
+    }
+#else
+    _bus->transfer(segments, (length > 0)? 2:1);
+#endif
+    return _status;
 }
 
 /**
  * \brief Escreve um valor no registrador
  * 
  * Utilize esta função escrever determinado valor no registrador do
- * dispositivo.
+ * dispositivo. Caso o registrador possua cópia local, ela é atualizada.
  * 
  * \param[in] register_addr Endereço do registrador 
  * \param[in] data Valor
@@ -68,17 +468,24 @@ void nrf::chip_disable(void){
  * 
  */
 uint8_t nrf::spi_write_register(uint8_t register_addr, uint8_t data){
-	uint8_t buff[2];
-	buff[0] = W_REGISTER | (register_addr & 0x1F);
-	buff[1]=data; 
-    spi_transfer(_csn, buff, sizeof(buff));
-    return buff[0]; //retorna estado
+    uint8_t status = nrf::spi_command(W_REGISTER | (register_addr & 0x1F), &data, NULL, 1);
+    uint8_t i = nrf::shadow_index(register_addr);
+    if(i != NRF_NOT_SHADOWED)
+        _shadow[i] = data;
+    if((register_addr & 0x1F) == STATUS)
+        _status &= ~(data & (RX_DR|TX_DS|MAX_RT)); // flags limpos pela escrita
+#if NRF_STATS
+    if((register_addr & 0x1F) == RF_CH)
+        _plos = 0;  // PLOS_CNT zerado pela escrita
+#endif
+    return status; //retorna estado
 }
 
 /**
  * \brief Escreve um bloco de dados no registrador
  * 
- * Utilize esta função escrever um vários bytes no registrador
+ * Utilize esta função escrever um vários bytes no registrador. A cópia local dos endereços
+ * RX_ADDR_P0, RX_ADDR_P1 e TX_ADDR é atualizada.
  * 
  * \param[in] register_addr Endereço do registrador 
  * \param[in] *buff Ponteiro para o bloco de dados
@@ -87,13 +494,12 @@ uint8_t nrf::spi_write_register(uint8_t register_addr, uint8_t data){
  * \return Estado do dispositivo (conteúdo do registrador STATUS)
  *
  */
-uint8_t nrf::spi_write_multibyte_register(uint8_t register_addr, uint8_t *buff, uint8_t length){
-	uint8_t tmp[length+1];
-	tmp[0]= W_REGISTER | (register_addr & 0x1F);
-	for(int i=0;i<length;i++)
-        tmp[i+1]=*buff++; 
-    spi_transfer(_csn, tmp, sizeof(tmp));
-    return tmp[0];
+uint8_t nrf::spi_write_multibyte_register(uint8_t register_addr, const uint8_t *buff, uint8_t length){
+    uint8_t status = nrf::spi_command(W_REGISTER | (register_addr & 0x1F), buff, NULL, length);
+    uint8_t *address = nrf::address_shadow(register_addr & 0x1F);
+    if(address != NULL)
+        memcpy(address, buff, (length > 5)? 5 : length);
+    return status;
 }  
 
 /**
@@ -108,11 +514,7 @@ uint8_t nrf::spi_write_multibyte_register(uint8_t register_addr, uint8_t *buff,
  * 
  */  
 uint8_t nrf::spi_read_register(uint8_t register_addr, uint8_t *data){
-	uint8_t buff[2];
-	buff[0] = R_REGISTER | (register_addr & 0x1F);
-	spi_transfer(_csn, buff, sizeof(buff));
-    *data = buff[1];
-    return buff[0];
+    return nrf::spi_command(R_REGISTER | (register_addr & 0x1F), NULL, data, 1);
 }
 
 /**
@@ -129,12 +531,7 @@ uint8_t nrf::spi_read_register(uint8_t register_addr, uint8_t *data){
  * 
  */  
 uint8_t nrf::spi_read_multibyte_register(uint8_t register_addr, uint8_t *buff, uint8_t length){
-    uint8_t data[length+1];
-    data[0]=R_REGISTER | (register_addr & 0x1F);
-    spi_transfer(_csn, data, sizeof(data));
-    for(int i=0;i<length;i++)
-        buff[i]=data[i+1];
-    return data[0];
+    return nrf::spi_command(R_REGISTER | (register_addr & 0x1F), NULL, buff, length);
 }
 
 /**
@@ -147,6 +544,7 @@ uint8_t nrf::spi_read_multibyte_register(uint8_t register_addr, uint8_t *buff, u
  *   
  */  
 void nrf::set_rf_channel(uint8_t rf_channel){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_RF_CHANNEL);
 	nrf::spi_write_register(RF_CH, rf_channel & 0x7F);
 }
     
@@ -159,9 +557,86 @@ void nrf::set_rf_channel(uint8_t rf_channel){
  *   
  */  
 uint8_t nrf::get_rf_channel(void){
-	uint8_t channel;
-	nrf::spi_read_register(RF_CH, &channel);
-	return channel;
+	return nrf::shadow(RF_CH);
+}
+
+/**
+ * \brief Troca o canal de RF no modo de operação atual
+ * 
+ * Uma escrita de RF_CH, com o pino CE em nível baixo durante a escrita nos modos 'rx' e 'tx'.
+ * O chip estará pronto no novo canal após a estabilização do PLL (ver \ref is_ready). Sem
+ * efeito se o canal não mudou.
+ * 
+ * \param[in] rf_channel Canal de RF (0 a 125)
+ */
+void nrf::switch_channel(uint8_t rf_channel){
+    NRF_TRACE_SCOPE(NRF_TRACE_SWITCH_CHANNEL);
+    rf_channel &= 0x7F;
+    if(nrf::shadow(RF_CH) == rf_channel)
+        return;
+    bool ce = _bus->read_ce();
+    if(ce)
+        nrf::chip_disable();
+    nrf::spi_write_register(RF_CH, rf_channel);
+    if(ce){
+        nrf::chip_enable();
+        uint32_t ready_at = _bus->micros() + _settle_delay;
+        if((int32_t)(ready_at - _ready_at) > 0)
+            _ready_at = ready_at;
+    }
+}
+
+/**
+ * \brief Mede a ocupação dos canais pelo detector de potência (RPD)
+ * 
+ * Percorre os canais de 'first' a 'last' em 'passes' varreduras. Em cada canal, o chip fica no
+ * modo 'rx' pelo tempo mínimo para a detecção (estabilização do PLL e \ref NRF_RPD_DWELL,
+ * cerca de 170us): cada passo consiste em uma escrita de RF_CH, um pulso em CE e uma leitura
+ * de RPD. Uma varredura dos 126 canais dura cerca de 22ms; faixas menores podem ser medidas
+ * entre os atendimentos da aplicação.
+ * 
+ * Ao final, o canal e o modo de operação anteriores são restaurados, sem aguardar a
+ * estabilização (ver \ref is_ready).
+ * 
+ * \param[out] *hist Número de varreduras em que foi detectado sinal acima de -64dBm, por canal
+ * (hist[0] corresponde a 'first'; 'last'-'first'+1 posições). Satura em 255.
+ * \param[in] passes Número de varreduras
+ * \param[in] first Primeiro canal
+ * \param[in] last Último canal (até 125)
+ * 
+ * \warning Pacotes recebidos durante a varredura permanecem no FIFO de recepção. O contador
+ * PLOS_CNT é zerado (ver \ref get_observe_tx).
+ */
+void nrf::scan_channels(uint8_t *hist, uint8_t passes, uint8_t first, uint8_t last){
+    NRF_TRACE_SCOPE(NRF_TRACE_SCAN_CHANNELS);
+    if(last > 125)
+        last = 125;
+    if(first > last)
+        return;
+    memset(hist, 0, last - first + 1);
+    
+    uint8_t channel = nrf::shadow(RF_CH);
+    nrf_operation_mode_t mode = _current_mode, last_mode = _last_mode;
+    nrf::begin_mode(NRF_RX_MODE);
+    nrf::chip_disable();
+    nrf::wait_ready();  // oscilador em funcionamento
+    
+    for(uint8_t pass=0; pass<passes; pass++){
+        for(uint8_t ch=first; ch<=last; ch++){
+            uint8_t rpd;
+            nrf::spi_write_register(RF_CH, ch);
+            nrf::chip_enable();
+            _bus->delay_us(_settle_delay + NRF_RPD_DWELL);
+            nrf::spi_read_register(RPD, &rpd);
+            nrf::chip_disable();
+            if((rpd & RPD_MASK) && hist[ch - first] < 255)
+                hist[ch - first]++;
+        }
+    }
+    
+    nrf::spi_write_register(RF_CH, channel);
+    nrf::begin_mode(mode);
+    _last_mode = last_mode;
 }
 
 /**
@@ -181,8 +656,8 @@ uint8_t nrf::get_rf_channel(void){
  *   
  */  
 void nrf::set_rf_power(nrf_power_t power){
-	uint8_t lastValue;
-	nrf::spi_read_register(RF_SETUP, &lastValue);
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_RF_POWER);
+	uint8_t lastValue = nrf::shadow(RF_SETUP);
 	nrf::spi_write_register(RF_SETUP, (lastValue & ~RF_PWR) | ( ( (uint8_t) power ) << 1) );
 }
 
@@ -200,8 +675,7 @@ void nrf::set_rf_power(nrf_power_t power){
  *  
  */  
 uint8_t nrf::get_rf_power(void){
-	uint8_t reg;
-	nrf::spi_read_register(RF_SETUP,&reg);
+	uint8_t reg = nrf::shadow(RF_SETUP);
 	return (reg & RF_PWR) >> 1;
 }
 
@@ -219,20 +693,16 @@ uint8_t nrf::get_rf_power(void){
  * 
  */  
 void nrf::set_rf_datarate(nrf_datarate_t speed){
-    uint8_t lastValue;
-    nrf::spi_read_register(RF_SETUP,&lastValue);
-    switch(speed){
-        case NRF_250KBPS:
-        nrf::spi_write_register(RF_SETUP, (lastValue & ~RF_DR_HIGH) | RF_DR_LOW);
-        break;
-        case NRF_1MBPS:
-        nrf::spi_write_register(RF_SETUP, lastValue & ~(RF_DR_HIGH | RF_DR_LOW));
-        break;
-        case NRF_2MBPS:
-        nrf::spi_write_register(RF_SETUP, (lastValue & ~RF_DR_LOW) | RF_DR_HIGH);
-    }
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_RF_DATARATE);
+    uint8_t bits = (speed == NRF_250KBPS)? RF_DR_LOW : (speed == NRF_2MBPS)? RF_DR_HIGH : 0;
+    nrf::spi_write_register(RF_SETUP, (nrf::shadow(RF_SETUP) & ~(RF_DR_LOW|RF_DR_HIGH)) | bits);
 }
 
+/* taxa de dados indexada pelos bits RF_DR_HIGH e RF_DR_LOW */
+static const uint8_t datarate_codes[4] PROGMEM = {
+    NRF_1MBPS, NRF_250KBPS, NRF_2MBPS, 0x03 //reservado
+};
+
 /**
  * \brief Retorna a taxa de dados (bps) atual
  * 
@@ -247,19 +717,8 @@ void nrf::set_rf_datarate(nrf_datarate_t speed){
  * \retval 3 (reservado)
  */  
 uint8_t nrf::get_rf_datarate(void){
-    uint8_t reg;
-    nrf::spi_read_register(RF_SETUP, &reg);
-    uint8_t tmp = ((reg & RF_DR_LOW)>>5) | ((reg & RF_DR_HIGH)>>2);
-    switch(tmp){
-        case 0:
-        return 0x01; //1Mbps
-        case 1:
-        return 0x00; //250kbps
-        case 2:
-        return 0x02; //2Mbps
-        default:
-        return 0x03; //Reserved
-    }
+    uint8_t reg = nrf::shadow(RF_SETUP);
+    return pgm_read_byte(&datarate_codes[((reg & RF_DR_LOW)>>5) | ((reg & RF_DR_HIGH)>>2)]);
 }
 
 /**
@@ -278,6 +737,7 @@ uint8_t nrf::get_rf_datarate(void){
  * 
  */  
 void nrf::set_address_width(nrf_address_width_t width){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_ADDRESS_WIDTH);
     nrf::spi_write_register(SETUP_AW, (uint8_t)width );
 }
 
@@ -291,9 +751,7 @@ void nrf::set_address_width(nrf_address_width_t width){
  * \retval 5 (para endereço de 5 bytes)
  */
 uint8_t nrf::get_address_width(void){
-    uint8_t reg;
-    nrf::spi_read_register(SETUP_AW, &reg);
-    return reg+2;
+    return nrf::shadow(SETUP_AW)+2;
 }
 
 /**
@@ -311,11 +769,11 @@ uint8_t nrf::get_address_width(void){
  * com o 'pipe' informado.   
  */
 void nrf::enable_rx_pipe(nrf_address_t pipe, bool auto_ack){
-    uint8_t reg;
-    nrf::spi_read_register(EN_RXADDR, &reg);
+    NRF_TRACE_SCOPE(NRF_TRACE_ENABLE_RX_PIPE);
+    uint8_t reg = nrf::shadow(EN_RXADDR);
     nrf::spi_write_register(EN_RXADDR, reg | BIT((uint8_t)pipe));
     
-    nrf::spi_read_register(EN_AA, &reg);
+    reg = nrf::shadow(EN_AA);
     if(auto_ack){
         nrf::spi_write_register(EN_AA, reg | BIT((uint8_t)pipe));
     }else{
@@ -332,11 +790,9 @@ void nrf::enable_rx_pipe(nrf_address_t pipe, bool auto_ack){
  * \param [in] pipe Pipe de recepção.
  */
 void nrf::disable_rx_pipe(nrf_address_t pipe){
-    uint8_t reg;
-    nrf::spi_read_register(EN_RXADDR, &reg);
-    nrf::spi_write_register(EN_RXADDR, reg & ~BIT((uint8_t)pipe));
-    nrf::spi_read_register(EN_AA, &reg);
-    nrf::spi_write_register(EN_AA, reg & ~BIT((uint8_t)pipe) );
+    NRF_TRACE_SCOPE(NRF_TRACE_DISABLE_RX_PIPE);
+    nrf::spi_write_register(EN_RXADDR, nrf::shadow(EN_RXADDR) & ~BIT((uint8_t)pipe));
+    nrf::spi_write_register(EN_AA, nrf::shadow(EN_AA) & ~BIT((uint8_t)pipe) );
 }
 
 /**
@@ -354,6 +810,7 @@ void nrf::disable_rx_pipe(nrf_address_t pipe){
  * em apenas um byte (o byte menos significativo ou LSB).
  */
 void nrf::set_rx_address(nrf_address_t pipe, uint8_t *addr, uint8_t length){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_RX_ADDRESS);
     switch(pipe){
         case NRF_PIPE0:
         case NRF_PIPE1:
@@ -378,6 +835,7 @@ void nrf::set_rx_address(nrf_address_t pipe, uint8_t *addr, uint8_t length){
  * 
  */
 void nrf::set_static_payload_width(nrf_address_t pipe, uint8_t width){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_STATIC_PAYLOAD_WIDTH);
     nrf::spi_write_register(RX_PW_P0 + (uint8_t) pipe, width & 0x3F);
 }
 
@@ -392,9 +850,7 @@ void nrf::set_static_payload_width(nrf_address_t pipe, uint8_t width){
  * @return uint8_t Tamanho do payload para o pipe informado
  */
 uint8_t nrf::get_static_payload_width(nrf_address_t pipe){
-    uint8_t reg;
-    nrf::spi_read_register(RX_PW_P0 + (uint8_t) pipe, &reg);
-    return reg;
+    return nrf::shadow(RX_PW_P0 + (uint8_t) pipe);
 }
 
 /**
@@ -409,7 +865,11 @@ uint8_t nrf::get_static_payload_width(nrf_address_t pipe){
  * \warning A variável 'length' deve assumir o mesmo valor definido pela função \ref set_address_width .
  */
 void nrf::set_tx_address(uint8_t *addr, uint8_t length){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_TX_ADDRESS);
     nrf::spi_write_multibyte_register(TX_ADDR, addr, length);
+#if NRF_STATS
+    nrf::stats_select(addr, length);
+#endif
 }
 
 /**
@@ -425,6 +885,7 @@ void nrf::set_tx_address(uint8_t *addr, uint8_t length){
  * 
  */
 void nrf::set_retr_param(uint8_t retr_count, uint8_t retr_delay){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_RETR_PARAM);
     nrf::spi_write_register(SETUP_RETR, ((retr_delay & 0x0F)<<4) | (retr_count & 0x0F) );
 }
 
@@ -436,9 +897,7 @@ void nrf::set_retr_param(uint8_t retr_count, uint8_t retr_delay){
  * 
  */
 uint8_t nrf::get_retr_param(void){
-    uint8_t reg;
-    nrf::spi_read_register(SETUP_RETR, &reg);
-    return reg;
+    return nrf::shadow(SETUP_RETR);
 }
 
 /**
@@ -452,8 +911,8 @@ uint8_t nrf::get_retr_param(void){
  * 
  */
 void nrf::set_crc_mode(nrf_crc_mode_t crc_mode){
-    uint8_t lastValue;
-    nrf::spi_read_register(CONFIG, &lastValue);
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_CRC_MODE);
+    uint8_t lastValue = nrf::shadow(CONFIG);
     switch(crc_mode){
         case NRF_CRC_1BYTE:
         nrf::spi_write_register(CONFIG, (lastValue & ~CRCO) | EN_CRC);
@@ -471,8 +930,7 @@ void nrf::set_crc_mode(nrf_crc_mode_t crc_mode){
  * \retval 2 (para CRC de 2 bytes)
  */
 uint8_t nrf::get_crc_mode(void){
-    uint8_t reg;
-    nrf::spi_read_register(CONFIG, &reg);
+    uint8_t reg = nrf::shadow(CONFIG);
     if(reg & EN_CRC){
         if(reg & CRCO){
             return 0x02;
@@ -489,8 +947,8 @@ uint8_t nrf::get_crc_mode(void){
  * 
  */
 void nrf::flush_rx_fifo(void){
-    uint8_t data = FLUSH_RX;
-    spi_transfer(_csn, &data, sizeof(data));
+    nrf::spi_command(FLUSH_RX, NULL, NULL, 0);
+    _status |= RX_P_NO;   // FIFO de recepção vazio
 }
 
 /**
@@ -498,8 +956,8 @@ void nrf::flush_rx_fifo(void){
  * 
  */
 void nrf::flush_tx_fifo(void){
-    uint8_t data = FLUSH_TX;
-    spi_transfer(_csn, &data, sizeof(data));
+    nrf::spi_command(FLUSH_TX, NULL, NULL, 0);
+    _status &= ~TX_FULL;  // FIFO de transmissão vazio
 }
 
 /**
@@ -509,9 +967,43 @@ void nrf::flush_tx_fifo(void){
  * 
  */
 uint8_t nrf::get_status(void){
-    uint8_t reg=NOP;
-    spi_transfer(_csn, &reg, sizeof(reg));
-    return reg;
+    return nrf::spi_command(NOP, NULL, NULL, 0);
+}
+
+/**
+ * \brief Retorna o último estado conhecido do dispositivo.
+ * 
+ * O chip envia o registrador STATUS no primeiro byte de todo comando SPI. Esta função
+ * retorna o valor capturado na última transação, sem acessar a interface SPI.
+ * 
+ * \return Último conteúdo conhecido do registrador STATUS.
+ */
+uint8_t nrf::get_last_status(void){
+    return _status;
+}
+
+/**
+ * \brief Retorna o acesso ao hardware utilizado pela classe
+ * 
+ * Utilizado pelas camadas construídas sobre a classe (ver \ref nrf_transport) para
+ * consultar o tempo.
+ */
+nrf_backend *nrf::get_backend(void){
+    return _bus;
+}
+
+/**
+ * \brief Verifica se o pino de IRQ indica ausência de eventos.
+ * 
+ * \param[in] mask Máscaras (bits MASK_* do registrador CONFIG) das fontes de interrupção consultadas.
+ * 
+ * \return true caso o pino de IRQ esteja configurado, as fontes indicadas estejam habilitadas
+ * e o pino esteja em nível alto (nenhum dos flags correspondentes setado).
+ */
+bool nrf::irq_idle(uint8_t mask){
+    if(_irq == NRF_NO_IRQ || (nrf::shadow(CONFIG) & mask))
+        return false;
+    return _bus->read_irq();
 }
 
 /**
@@ -521,8 +1013,8 @@ uint8_t nrf::get_status(void){
  * 
  */
 void nrf::clear_all_int_flags(void){
-    uint8_t lastValue=nrf::get_status();
-    nrf::spi_write_register(STATUS, lastValue | (RX_DR|TX_DS|MAX_RT) );
+    NRF_TRACE_SCOPE(NRF_TRACE_CLEAR_ALL_INT_FLAGS);
+    nrf::spi_write_register(STATUS, RX_DR|TX_DS|MAX_RT);
 }
 
 /**
@@ -534,16 +1026,21 @@ void nrf::clear_all_int_flags(void){
  * \retval true Pacote recebido
  * \retval false Não há pacote no buffer de recepção.
  * 
+ * O último estado conhecido (ver \ref get_last_status) e o pino de IRQ (ver \ref set_irq_pin)
+ * são consultados antes de acessar a interface SPI.
+ * 
  * \warning Antes de executar essa função, verifique se o dispostivo
  * está no modo de recepção.
  */
 bool nrf::available(void){
-    uint8_t fifo_status = nrf::get_fifo_status();
-    if(!(fifo_status & RX_EMPTY)){
-        return true;
-    }else{
-        return false;
-    }
+    NRF_TRACE_SCOPE(NRF_TRACE_AVAILABLE);
+    if(_rx_interrupt)
+        return _ring_head != _ring_tail;
+    if((_status & RX_P_NO) != RX_P_NO)
+        return true;    // há pacote no FIFO desde a última transação
+    if(nrf::irq_idle(MASK_RX_DR))
+        return false;   // RX_DR não foi setado desde a última leitura
+    return (nrf::get_status() & RX_P_NO) != RX_P_NO;
 }
 
 /**
@@ -561,28 +1058,62 @@ bool nrf::available(void){
  * \retval 7 (Buffer de recepção vazio)
  */ 
 uint8_t nrf::get_data_source(void){                           
-    uint8_t reg = nrf::get_status();
+    NRF_TRACE_SCOPE(NRF_TRACE_GET_DATA_SOURCE);
+    if(_rx_interrupt){
+        if(_ring_head == _ring_tail)
+            return RX_P_NO >> 1;
+        NRF_BARRIER();
+        return _ring[_ring_tail & (NRF_RX_RING_SIZE-1)].pipe;
+    }
+    uint8_t reg = _status;
+    if((reg & RX_P_NO) == RX_P_NO)
+        reg = nrf::get_status();
     return (reg & RX_P_NO) >> 1;
 }
 
 /**
  * \brief Lê o payload do pacote recebido
  * 
- * \param [out] *buff Ponteiro para o buffer de dados
+ * No modo de recepção por interrupção (ver \ref enable_rx_interrupt), o pacote é retirado
+ * do buffer circular, sem acesso à interface SPI.
+ * 
+ * \param [out] *buff Ponteiro para o buffer de dados (mínimo de 32 bytes)
  * \param [out] *length Ponteiro para o tamanho do payload recebido.
+ * \param [out] *pipe Ponteiro para o pipe de recepção do pacote (opcional).
  * 
  * \return true ou false
  * \retval true Pacote recebido com sucesso
  * \retval false Erro na leitura.
  * 
  */ 
-bool nrf::read_received_payload(uint8_t *buff, uint8_t *length){
+bool nrf::read_received_payload(uint8_t *buff, uint8_t *length, uint8_t *pipe){
+    NRF_TRACE_SCOPE(NRF_TRACE_READ_RECEIVED_PAYLOAD);
+    if(_rx_interrupt){
+        if(_ring_head == _ring_tail)
+            return false;
+        NRF_BARRIER();  // posição lida após o índice
+        nrf_packet_t *packet = &_ring[_ring_tail & (NRF_RX_RING_SIZE-1)];
+        *length = packet->length;
+        memcpy(buff, packet->data, packet->length);
+        if(pipe != NULL)
+            *pipe = packet->pipe;
+        NRF_BARRIER();
+        _ring_tail++;   // libera a posição para a interrupção
+        return true;
+    }
+    
     if( !(nrf::available()) ){
         buff=NULL;
         return false;
     }
+    uint8_t source = (_status & RX_P_NO) >> 1;
+    if(pipe != NULL)
+        *pipe = source;
     
     *length = nrf::get_received_payload_width();
+#if NRF_STATS
+    nrf::stats_received(source, *length, *length > 32);
+#endif
     if(*length>32){
         nrf::flush_rx_fifo();
         nrf::clear_int_flag(NRF_RX_DR);
@@ -590,16 +1121,24 @@ bool nrf::read_received_payload(uint8_t *buff, uint8_t *length){
         return false;
     }
     
-    uint8_t incoming[*length+1];
-    incoming[0]= R_RX_PAYLOAD;
-    spi_transfer(_csn,incoming,sizeof(incoming));
+    nrf::read_payload(buff, *length);
     
-    for(int i=0;i<*length;i++)
-        buff[i]=incoming[i+1];
+    // o STATUS retornado indica se ainda há pacotes no FIFO
+    nrf::clear_int_flag(NRF_RX_DR);
     
     return true;
 }
 
+/**
+ * \brief Retira um payload do FIFO de recepção
+ * 
+ * \param [out] *buff Ponteiro para o buffer de dados. Se NULL, o payload é descartado.
+ * \param [in] length Tamanho do payload (ver \ref get_received_payload_width)
+ */
+void nrf::read_payload(uint8_t *buff, uint8_t length){
+    nrf::spi_command(R_RX_PAYLOAD, NULL, buff, length);
+}
+
 /**
  * \brief Bloqueia a execução do programa até a chegada de um pacote.
  * 
@@ -607,6 +1146,7 @@ bool nrf::read_received_payload(uint8_t *buff, uint8_t *length){
  * 
  */ 
 void nrf::wait_available(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_WAIT_AVAILABLE);
     while( !(nrf::available()) ){
     }
 }
@@ -622,8 +1162,9 @@ void nrf::wait_available(void){
  * @warning Antes de executar essa função coloque o dispositivo no modo recepção.
  */ 
 bool nrf::wait_available_timeout(const unsigned long timeout){
-    unsigned long currentTime = millis();
-    while( (millis() - currentTime) < timeout ){
+    NRF_TRACE_SCOPE(NRF_TRACE_WAIT_AVAILABLE_TIMEOUT);
+    uint32_t currentTime = _bus->millis();
+    while( (_bus->millis() - currentTime) < timeout ){
         if(nrf::available()){
             return true;
         }
@@ -639,8 +1180,7 @@ bool nrf::wait_available_timeout(const unsigned long timeout){
  * \param [in] pwr_up true ou false.
  */ 
 void nrf::set_power_up(bool pwr_up){
-    uint8_t lastValue;
-    nrf::spi_read_register(CONFIG,&lastValue);
+    uint8_t lastValue = nrf::shadow(CONFIG);
     if(pwr_up){
         nrf::spi_write_register(CONFIG, lastValue | PWR_UP);
     }else{
@@ -656,8 +1196,7 @@ void nrf::set_power_up(bool pwr_up){
  * \param [in] prim_rx true ou false.
  */ 
 void nrf::set_primary_rx(bool prim_rx){
-    uint8_t lastValue;
-    nrf::spi_read_register(CONFIG, &lastValue);
+    uint8_t lastValue = nrf::shadow(CONFIG);
     if(prim_rx){
         nrf::spi_write_register(CONFIG, lastValue | PRIM_RX);
     }else{
@@ -671,261 +1210,1047 @@ void nrf::set_primary_rx(bool prim_rx){
  * \param [in] int_source Fonte de interrupação.
  */ 
 void nrf::clear_int_flag(nrf_int_source_t int_source){
-    uint8_t lastValue = nrf::get_status();
+    NRF_TRACE_SCOPE(NRF_TRACE_CLEAR_INT_FLAG);
     switch(int_source){
         case NRF_RX_DR:
-            nrf::spi_write_register(STATUS, lastValue | RX_DR);
+            nrf::spi_write_register(STATUS, RX_DR);
             break;
         case NRF_TX_DS:
-            nrf::spi_write_register(STATUS, lastValue | TX_DS);
+            nrf::spi_write_register(STATUS, TX_DS);
             break;
         case NRF_MAX_RT:
-            nrf::spi_write_register(STATUS, lastValue | MAX_RT);
+            nrf::spi_write_register(STATUS, MAX_RT);
     }    
 }
 
 
+#if NRF_REGISTER_MAP
+/* descritor de registrador, na memória flash */
+typedef struct{
+    uint8_t address;    //endereço no chip
+    uint8_t width;      //bytes na imagem (ver NRF_REGISTER_IMAGE_SIZE)
+    char name[12];
+}nrf_register_desc_t;
+
+/* descritor de campo de registrador, na memória flash */
+typedef struct{
+    uint8_t address;    //registrador do campo
+    uint8_t mask;       //máscara do campo (nordic.h)
+    char name[12];
+}nrf_field_desc_t;
+
+/* registradores na ordem da imagem (ver snapshot_registers) */
+static const nrf_register_desc_t register_map[NRF_REGISTER_COUNT] PROGMEM = {
+    {CONFIG, 1, "CONFIG"},          {EN_AA, 1, "EN_AA"},            {EN_RXADDR, 1, "EN_RXADDR"},
+    {SETUP_AW, 1, "SETUP_AW"},      {SETUP_RETR, 1, "SETUP_RETR"},  {RF_CH, 1, "RF_CH"},
+    {RF_SETUP, 1, "RF_SETUP"},      {STATUS, 1, "STATUS"},          {OBSERVE_TX, 1, "OBSERVE_TX"},
+    {RPD, 1, "RPD"},                {RX_ADDR_P0, 5, "RX_ADDR_P0"},  {RX_ADDR_P1, 5, "RX_ADDR_P1"},
+    {RX_ADDR_P2, 1, "RX_ADDR_P2"},  {RX_ADDR_P3, 1, "RX_ADDR_P3"},  {RX_ADDR_P4, 1, "RX_ADDR_P4"},
+    {RX_ADDR_P5, 1, "RX_ADDR_P5"},  {TX_ADDR, 5, "TX_ADDR"},        {RX_PW_P0, 1, "RX_PW_P0"},
+    {RX_PW_P1, 1, "RX_PW_P1"},      {RX_PW_P2, 1, "RX_PW_P2"},      {RX_PW_P3, 1, "RX_PW_P3"},
+    {RX_PW_P4, 1, "RX_PW_P4"},      {RX_PW_P5, 1, "RX_PW_P5"},      {FIFO_STATUS, 1, "FIFO_STATUS"},
+    {DYNPD, 1, "DYNPD"},            {FEATURE, 1, "FEATURE"}
+};
+
+/* campos decodificados; os registradores ausentes são impressos apenas em hexadecimal */
+static const nrf_field_desc_t field_map[] PROGMEM = {
+    {CONFIG, MASK_RX_DR, "MASK_RX_DR"},     {CONFIG, MASK_TX_DS, "MASK_TX_DS"},
+    {CONFIG, MASK_MAX_RT, "MASK_MAX_RT"},   {CONFIG, EN_CRC, "EN_CRC"},
+    {CONFIG, CRCO, "CRCO"},                 {CONFIG, PWR_UP, "PWR_UP"},
+    {CONFIG, PRIM_RX, "PRIM_RX"},
+    {SETUP_AW, AW, "AW"},
+    {SETUP_RETR, ARD, "ARD"},               {SETUP_RETR, ARC, "ARC"},
+    {RF_SETUP, CONT_WAVE, "CONT_WAVE"},     {RF_SETUP, RF_DR_LOW, "RF_DR_LOW"},
+    {RF_SETUP, PLL_LOCK, "PLL_LOCK"},       {RF_SETUP, RF_DR_HIGH, "RF_DR_HIGH"},
+    {RF_SETUP, RF_PWR, "RF_PWR"},
+    {STATUS, RX_DR, "RX_DR"},               {STATUS, TX_DS, "TX_DS"},
+    {STATUS, MAX_RT, "MAX_RT"},             {STATUS, RX_P_NO, "RX_P_NO"},
+    {STATUS, TX_FULL, "TX_FULL"},
+    {OBSERVE_TX, PLOS_CNT, "PLOS_CNT"},     {OBSERVE_TX, ARC_CNT, "ARC_CNT"},
+    {RPD, RPD_MASK, "RPD"},
+    {FIFO_STATUS, TX_REUSE, "TX_REUSE"},    {FIFO_STATUS, TX_FIFO_FULL, "TX_FULL"},
+    {FIFO_STATUS, TX_EMPTY, "TX_EMPTY"},    {FIFO_STATUS, RX_FULL, "RX_FULL"},
+    {FIFO_STATUS, RX_EMPTY, "RX_EMPTY"},
+    {FEATURE, EN_DPL, "EN_DPL"},            {FEATURE, EN_ACK_PAY, "EN_ACK_PAY"},
+    {FEATURE, EN_DYN_ACK, "EN_DYN_ACK"}
+};
+
+#define NRF_FIELD_COUNT     (sizeof(field_map) / sizeof(field_map[0]))
+
 /**
- * \brief Imprime no terminal serial o conteúdo dos registradores de configuração.
+ * \brief Imprime no terminal o conteúdo dos registradores
  * 
- * Utilize essa função durante processo de debug
- * 
- */ 
+ * Uma linha por registrador, com o nome e o valor em hexadecimal. Os endereços são impressos
+ * com o byte menos significativo primeiro. Os nomes e os textos fixos ficam na memória flash
+ * (ver \ref NRF_REGISTER_MAP).
+ */
 void nrf::print_registers(void){
-  uint8_t reg,address_width;
-  Serial.print("--- Register's content (in hexa) ---\n");
-
-  nrf::spi_read_register(CONFIG,&reg);
-  Serial.print("CONFIG: ");
-  Serial.println(reg,HEX);
-
-  nrf::spi_read_register(EN_AA,&reg);  
-  Serial.print("EN_AA: ");
-  Serial.println(reg,HEX);
-
-  nrf::spi_read_register(EN_RXADDR,&reg);  
-  Serial.print("EN_RXADDR: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(SETUP_AW,&reg); 
-  address_width=reg+2;
-  Serial.print("SETUP_AW: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(SETUP_RETR,&reg);  
-  Serial.print("SETUP_RETR: ");
-  Serial.println(reg,HEX);  
-  
-  nrf::spi_read_register(RF_CH,&reg);  
-  Serial.print("RF_CH: ");
-  Serial.println(reg,HEX); 
-  
-  nrf::spi_read_register(RF_SETUP,&reg);  
-  Serial.print("RF_SETUP: ");
-  Serial.println(reg,HEX);
-  
-  Serial.print("STATUS: ");
-  Serial.println(nrf::get_status(),HEX);
-
-  nrf::spi_read_register(OBSERVE_TX,&reg);  
-  Serial.print("OBSERVE_TX: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RPD,&reg);  
-  Serial.print("RPD: ");
-  Serial.println(reg,HEX);
-  
-  uint8_t buff[5];
-  nrf::spi_read_multibyte_register(RX_ADDR_P0, buff, address_width);
-  Serial.print("RX_ADDR_P0 (LSB first): ");
-  for(int i=0;i<address_width;i++){
-    Serial.print(buff[i],HEX);
-    Serial.print(" ");
-  }
-  Serial.print("\n");
-  
-  
-  nrf::spi_read_multibyte_register(RX_ADDR_P1, buff, address_width);
-  Serial.print("RX_ADDR_P1 (LSB first): ");
-  for(int i=0;i<address_width;i++){
-    Serial.print(buff[i],HEX);
-    Serial.print(" ");
-  }
-  Serial.print("\n");
-  
-  nrf::spi_read_register(RX_ADDR_P2,&reg);  
-  Serial.print("RX_ADDR_P2: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_ADDR_P3,&reg);  
-  Serial.print("RX_ADDR_P3: ");
-  Serial.println(reg,HEX);
-
-  nrf::spi_read_register(RX_ADDR_P4,&reg);  
-  Serial.print("RX_ADDR_P4: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_ADDR_P5,&reg);  
-  Serial.print("RX_ADDR_P5: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_multibyte_register(TX_ADDR, buff, address_width);
-  Serial.print("TX_ADDR (LSB first): ");
-  for(int i=0;i<address_width;i++){
-    Serial.print(buff[i],HEX);
-    Serial.print(" ");
-  }
-  Serial.print("\n");
-
-  nrf::spi_read_register(RX_PW_P0,&reg);  
-  Serial.print("RX_PW_P0: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_PW_P1,&reg);  
-  Serial.print("RX_PW_P1: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_PW_P2,&reg);  
-  Serial.print("RX_PW_P2: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_PW_P3,&reg);  
-  Serial.print("RX_PW_P3: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_PW_P4,&reg);  
-  Serial.print("RX_PW_P4: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(RX_PW_P5,&reg);  
-  Serial.print("RX_PW_P5: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(FIFO_STATUS,&reg);  
-  Serial.print("FIFO_STATUS: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(DYNPD,&reg);  
-  Serial.print("DYNPD: ");
-  Serial.println(reg,HEX);
-  
-  nrf::spi_read_register(FEATURE,&reg);  
-  Serial.print("FEATURE: ");
-  Serial.println(reg,HEX);
-  
+    NRF_TRACE_SCOPE(NRF_TRACE_PRINT_REGISTERS);
+    uint8_t image[NRF_REGISTER_IMAGE_SIZE];
+    nrf::snapshot_registers(image);
+    nrf::print_P(PSTR("--- Register's content (in hexa) ---\n"));
+    nrf::print_image(image, NULL, false);
 }
 
 /**
- * \brief Imprime no terminal serial o conteúdo de um registrador ou buffer de dados.
- * 
- * \param [in] *buff Ponteiro para o buffer de dados lido.
- * \param [in] length tamanho do buffer de dados.
+ * \brief Imprime no terminal o conteúdo dos registradores, com os campos decodificados
  * 
- */ 
-void nrf::print_buffer(uint8_t *buff, uint8_t length){
-    for(int i=0;i<length;i++){
-        Serial.print(buff[i],HEX);
-        Serial.print(" ");
-    }
+ * Além do valor em hexadecimal, cada campo dos registradores de controle e de estado é
+ * impresso em decimal (por exemplo, "SETUP_RETR: 13 ARD=1 ARC=3").
+ */
+void nrf::print_register_fields(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_PRINT_REGISTERS);
+    uint8_t image[NRF_REGISTER_IMAGE_SIZE];
+    nrf::snapshot_registers(image);
+    nrf::print_image(image, NULL, true);
 }
 
 /**
- * \brief Retorna o estado dos buffers de recepção e transmissão.
+ * \brief Lê todos os registradores numa imagem binária
  * 
- * \return Retorna byte de estado dos FIFO's de TX e RX
+ * A imagem segue a ordem dos endereços (0x00 a FIFO_STATUS, DYNPD e FEATURE), um byte por
+ * registrador e 5 bytes para RX_ADDR_P0, RX_ADDR_P1 e TX_ADDR, com o byte menos significativo
+ * primeiro e completados com 0 se o endereço for menor. O formato é fixo e pode ser enviado
+ * como telemetria ou comparado com \ref diff_registers .
  * 
- */ 
-uint8_t nrf::get_fifo_status(void){
-    uint8_t reg;
-    nrf::spi_read_register(FIFO_STATUS,&reg);
-    return reg;
+ * \param[out] *image Imagem, com \ref NRF_REGISTER_IMAGE_SIZE bytes
+ * \return Tamanho da imagem em bytes
+ */
+uint8_t nrf::snapshot_registers(uint8_t *image){
+    NRF_TRACE_SCOPE(NRF_TRACE_SNAPSHOT_REGISTERS);
+    uint8_t offset = 0, address_width = 5;
+    for(uint8_t i=0; i<NRF_REGISTER_COUNT; i++){
+        nrf_register_desc_t reg;
+        memcpy_P(&reg, &register_map[i], sizeof(reg));
+        if(reg.width == 1){
+            nrf::spi_read_register(reg.address, &image[offset]);
+        }else{
+            memset(&image[offset], 0, reg.width);
+            nrf::spi_read_multibyte_register(reg.address, &image[offset], address_width);
+        }
+        if(reg.address == SETUP_AW && (image[offset] & AW) != 0)
+            address_width = (image[offset] & AW) + 2;
+        offset += reg.width;
+    }
+    return offset;
 }
 
 /**
- * \brief Escreve o payload no buffer de transmissão.
+ * \brief Compara duas imagens dos registradores
  * 
- * \param [in] *buff Ponteiro para o buffer de dados que armazena o payload
- * \param [in] length Tamanho do buffer
- * \param [in] auto_ack true or false. Habilita ou não a função de auto-ack para o pacote a ser enviado.
- *
- * \return true ou false
- * \retval true Dados escritos com sucesso.
- * \retval false Erro durante a escrita. Buffer de TX pode está cheio.
+ * Não há acesso à interface SPI.
  * 
+ * \param[in] *before Imagem anterior (ver \ref snapshot_registers)
+ * \param[in] *after Imagem atual
+ * \return Registradores alterados: bit i para o i-ésimo registrador da imagem (0 se iguais)
  */
-bool nrf::write_tx_payload(uint8_t *buff, uint8_t length, bool auto_ack){
-    
-    if(nrf::get_fifo_status() & TX_FIFO_FULL){
-        return false; 
+uint32_t nrf::diff_registers(const uint8_t *before, const uint8_t *after){
+    uint32_t changed = 0;
+    uint8_t offset = 0;
+    for(uint8_t i=0; i<NRF_REGISTER_COUNT; i++){
+        uint8_t width = pgm_read_byte(&register_map[i].width);
+        if(memcmp(&before[offset], &after[offset], width) != 0)
+            changed |= 1UL << i;
+        offset += width;
     }
-    
-    uint8_t outcoming[length+1];
-    outcoming[0]=(auto_ack)? W_TX_PAYLOAD:W_TX_PAYLOAD_NOACK;
-    
-    //copy data
-    for(int i=0;i<length;i++)
-        outcoming[i+1]=buff[i];
-    
-    // write into tx fifo
-    spi_transfer(_csn, outcoming, sizeof(outcoming));
-    
-    return true;
+    return changed;
 }
 
 /**
- * \brief Aguarda o envio do pacote.
+ * \brief Imprime no terminal os registradores alterados entre duas imagens
  * 
- * Utilize essa função para bloquear a execução do programa até o pacote ser enviado.
+ * Cada registrador alterado é impresso com o valor anterior, o atual e os campos que mudaram
+ * (por exemplo, "CONFIG: 0C > 0E PWR_UP=1").
  * 
- * \return true ou false
- * \retval true Pacote enviado com sucesso.
- * \retval false Erro durante o envio. Dispositivo não está no modo de transmissão ou o número máximo de retransmissões foi atingido.
- * Verifique se o chip está no modo transmissão e se o receptor está ativo e dentro da área de cobertura. 
+ * \param[in] *before Imagem anterior (ver \ref snapshot_registers)
+ * \param[in] *after Imagem atual
  */
-bool nrf::wait_packet_sent(void){
-    uint8_t config;
-    nrf::spi_read_register(CONFIG, &config);
-    if( (config & PRIM_RX) | !digitalRead(_ce) | !(config & PWR_UP) )  
-        return false;
-    
-    do{
-        while( !(nrf::get_status() & (TX_DS|MAX_RT)) ){
-        }
-    
-        if(nrf::get_status() & MAX_RT){
-            nrf::clear_int_flag(NRF_MAX_RT);
-            nrf::flush_tx_fifo();
-            return false;
-        }
-        nrf::clear_int_flag(NRF_TX_DS);
-    }while(!(nrf::get_fifo_status() & TX_EMPTY));
-    
-    return true;
+void nrf::print_register_diff(const uint8_t *before, const uint8_t *after){
+    NRF_TRACE_SCOPE(NRF_TRACE_PRINT_REGISTERS);
+    nrf::print_image(after, before, true);
 }
 
 /**
- * \brief Retorna o tamanho do payload recebido.
+ * \brief Imprime uma imagem dos registradores
  * 
- * \return Tamanho do payload recebido em bytes
+ * \param[in] *image Imagem (ver \ref snapshot_registers)
+ * \param[in] *previous Imagem anterior: apenas os registradores e campos alterados são
+ * impressos (opcional)
+ * \param[in] fields Imprime os campos decodificados
+ */
+void nrf::print_image(const uint8_t *image, const uint8_t *previous, bool fields){
+    uint8_t offset = 0, field = 0;
+    for(uint8_t i=0; i<NRF_REGISTER_COUNT; offset += pgm_read_byte(&register_map[i].width), i++){
+        nrf_register_desc_t reg;
+        memcpy_P(&reg, &register_map[i], sizeof(reg));
+        const uint8_t *value = &image[offset];
+        if(previous != NULL && memcmp(&previous[offset], value, reg.width) == 0)
+            continue;
+        
+        _bus->print(reg.name);
+        nrf::print_P(PSTR(":"));
+        if(previous != NULL){
+            for(uint8_t j=0; j<reg.width; j++){
+                nrf::print_P(PSTR(" "));
+                nrf::print_hex(previous[offset + j]);
+            }
+            nrf::print_P(PSTR(" >"));
+        }
+        for(uint8_t j=0; j<reg.width; j++){
+            nrf::print_P(PSTR(" "));
+            nrf::print_hex(value[j]);
+        }
+        
+        // os campos seguem a ordem dos registradores
+        while(field < NRF_FIELD_COUNT && pgm_read_byte(&field_map[field].address) < reg.address)
+            field++;
+        for(; fields && field < NRF_FIELD_COUNT; field++){
+            nrf_field_desc_t f;
+            memcpy_P(&f, &field_map[field], sizeof(f));
+            if(f.address != reg.address)
+                break;
+            if(previous != NULL && ((previous[offset] ^ value[0]) & f.mask) == 0)
+                continue;
+            uint8_t shift = 0;
+            while(!((f.mask >> shift) & 1))
+                shift++;
+            nrf::print_P(PSTR(" "));
+            _bus->print(f.name);
+            nrf::print_P(PSTR("="));
+            nrf::print_dec((value[0] & f.mask) >> shift);
+        }
+        nrf::print_P(PSTR("\n"));
+    }
+}
+#endif
+
+/**
+ * \brief Imprime no terminal um byte em hexadecimal.
+ * 
+ * \param [in] value Valor impresso (dois dígitos).
+ */
+void nrf::print_hex(uint8_t value){
+    static const char digits[] PROGMEM = "0123456789ABCDEF";
+    char text[3];
+    text[0] = (char)pgm_read_byte(&digits[value >> 4]);
+    text[1] = (char)pgm_read_byte(&digits[value & 0x0F]);
+    text[2] = 0;
+    _bus->print(text);
+}
+
+/**
+ * \brief Imprime um valor em decimal
+ */
+void nrf::print_dec(uint32_t value){
+    char text[11];
+    uint8_t i = sizeof(text) - 1;
+    text[i] = 0;
+    do{
+        text[--i] = '0' + (value % 10);
+        value /= 10;
+    }while(value > 0);
+    _bus->print(&text[i]);
+}
+
+/**
+ * \brief Imprime um texto armazenado na memória flash (ver PSTR)
+ * 
+ * O texto é copiado em blocos para a pilha: no AVR, os textos fixos dos métodos de impressão
+ * não ocupam RAM.
+ */
+void nrf::print_P(const char *text){
+    char buff[16];
+    uint8_t length = 0;
+    for(;;){
+        char c = (char)pgm_read_byte(text++);
+        if(c == 0 || length == sizeof(buff) - 1){
+            buff[length] = 0;
+            _bus->print(buff);
+            length = 0;
+            if(c == 0)
+                return;
+        }
+        buff[length++] = c;
+    }
+}
+
+/**
+ * \brief Imprime no terminal serial o conteúdo de um registrador ou buffer de dados.
+ * 
+ * \param [in] *buff Ponteiro para o buffer de dados lido.
+ * \param [in] length tamanho do buffer de dados.
+ * 
+ */ 
+void nrf::print_buffer(uint8_t *buff, uint8_t length){
+    for(int i=0;i<length;i++){
+        nrf::print_hex(buff[i]);
+        nrf::print_P(PSTR(" "));
+    }
+}
+
+#if NRF_TRACE
+/* tamanho de cada nome na tabela, com o terminador ("get_received_payload_width") */
+#define NRF_TRACE_NAME_SIZE     27
+
+/* nomes dos métodos, na ordem de nrf_trace_id_t, na memória flash */
+static const char trace_names[NRF_TRACE_COUNT][NRF_TRACE_NAME_SIZE] PROGMEM = {
+    "init", "set_rf_channel", "set_rf_power", "set_rf_datarate", "set_address_width",
+    "enable_rx_pipe", "disable_rx_pipe", "set_rx_address", "set_static_payload_width",
+    "set_tx_address", "set_retr_param", "set_crc_mode", "available", "wait_available",
+    "wait_available_timeout", "write_tx_payload", "read_received_payload", "wait_packet_sent",
+    "enable_rx_interrupt", "disable_rx_interrupt", "rx_isr", "set_int_source",
+    "set_dynamic_payload", "clear_all_int_flags", "clear_int_flag",
+    "get_received_payload_width", "get_data_source", "set_mode", "sync_registers",
+    "verify_registers", "print_registers", "send_stream",
+    "enable_ack_payload", "write_ack_payload", "flush_ack_payloads", "read_ack_payload",
+    "start_beacon", "poll_beacon", "stop_beacon", "get_tx_reuse",
+    "apply_profile", "begin_mode", "send_async", "poll", "get_observe_tx",
+    "scan_channels", "switch_channel", "snapshot_registers"
+};
+
+/**
+ * \brief Retorna os contadores de instrumentação de um método
+ * 
+ * Disponível apenas se \ref NRF_TRACE for diferente de 0 (ver nrf_config.h).
+ * 
+ * \param[in] id Método (ver \ref nrf_trace_id_t)
+ * \return Contadores acumulados desde a última chamada de \ref reset_trace
+ */
+const nrf_trace_t *nrf::get_trace(nrf_trace_id_t id){
+    return &_trace[id];
+}
+
+/**
+ * \brief Zera os contadores de instrumentação
+ */
+void nrf::reset_trace(void){
+    _bus->lock();
+    memset(_trace, 0, sizeof(_trace));
+    for(uint8_t i=0; i<NRF_TRACE_COUNT; i++)
+        _trace[i].min_us = 0xFFFFFFFFUL;
+    _bus->unlock();
+}
+
+/**
+ * \brief Imprime no terminal serial os contadores dos métodos chamados
+ * 
+ * Uma linha por método: chamadas, transações SPI, bytes, tempo em SPI e latência
+ * mínima/média/máxima, em microssegundos.
+ */
+void nrf::print_trace(void){
+    nrf::print_P(PSTR("metodo: chamadas transacoes bytes spi_us min/med/max_us\n"));
+    for(uint8_t i=0; i<NRF_TRACE_COUNT; i++){
+        nrf_trace_t t;
+        _bus->lock();
+        t = _trace[i];
+        _bus->unlock();
+        if(t.calls == 0)
+            continue;
+        char name[NRF_TRACE_NAME_SIZE];
+        memcpy_P(name, trace_names[i], NRF_TRACE_NAME_SIZE);
+        _bus->print(name);
+        nrf::print_P(PSTR(": "));
+        nrf::print_dec(t.calls);
+        nrf::print_P(PSTR(" "));
+        nrf::print_dec(t.transactions);
+        nrf::print_P(PSTR(" "));
+        nrf::print_dec(t.bytes);
+        nrf::print_P(PSTR(" "));
+        nrf::print_dec(t.spi_us);
+        nrf::print_P(PSTR(" "));
+        nrf::print_dec(t.min_us);
+        nrf::print_P(PSTR("/"));
+        nrf::print_dec(t.total_us / t.calls);
+        nrf::print_P(PSTR("/"));
+        nrf::print_dec(t.max_us);
+        nrf::print_P(PSTR("\n"));
+    }
+}
+
+
+/**
+ * \brief Inicia a medição de uma chamada
+ * 
+ * \param[in] *radio Instância medida
+ * \param[in] id Método chamado
+ * \param[in] isr Chamada na rotina de interrupção: interrompe a medição do método em execução
+ */
+nrf_trace_scope::nrf_trace_scope(nrf *radio, nrf_trace_id_t id, bool isr){
+    _radio = radio;
+    _previous = radio->_trace_id;
+    if(_previous == NRF_TRACE_NONE || isr){
+        _id = id;
+        radio->_trace_id = id;
+        _start = radio->_bus->micros();
+    }else{
+        _id = NRF_TRACE_NONE;   // chamada interna, atribuída ao método externo
+    }
+}
+
+/**
+ * \brief Encerra a medição da chamada
+ */
+nrf_trace_scope::~nrf_trace_scope(){
+    if(_id != NRF_TRACE_NONE){
+        uint32_t elapsed = _radio->_bus->micros() - _start;
+        nrf_trace_t *t = &_radio->_trace[_id];
+        t->calls++;
+        t->total_us += elapsed;
+        if(elapsed < t->min_us)
+            t->min_us = elapsed;
+        if(elapsed > t->max_us)
+            t->max_us = elapsed;
+    }
+    _radio->_trace_id = _previous;
+}
+#endif
+
+#if NRF_STATS
+/**
+ * \brief Retorna as estatísticas de um pipe de recepção
+ * 
+ * Disponível apenas se \ref NRF_STATS for diferente de 0 (ver nrf_config.h). A cópia e a
+ * limpeza são feitas com a interrupção desabilitada.
+ * 
+ * \param[in] pipe Pipe de recepção
+ * \param[out] *stats Estatísticas acumuladas desde a última limpeza
+ * \param[in] reset Zera as estatísticas do pipe após a cópia
+ */
+void nrf::get_pipe_stats(nrf_address_t pipe, nrf_stats_t *stats, bool reset){
+    _bus->lock();
+    *stats = _pipe_stats[pipe];
+    if(reset)
+        memset(&_pipe_stats[pipe], 0, sizeof(nrf_stats_t));
+    _bus->unlock();
+}
+
+/**
+ * \brief Retorna as estatísticas de um destino de transmissão
+ * 
+ * Os destinos são registrados por \ref set_tx_address , na ordem em que aparecem, até
+ * \ref NRF_STATS_DESTINATIONS. Os envios para destinos além desse limite não são contados.
+ * São contados os envios concluídos por \ref wait_packet_sent , \ref send_stream e
+ * \ref poll (ver \ref send_async).
+ * 
+ * \param[in] index Posição do destino, a partir de 0
+ * \param[out] *stats Estatísticas acumuladas desde a última limpeza
+ * \param[out] *addr Endereço do destino, 5 bytes (opcional)
+ * \param[in] reset Zera as estatísticas do destino após a cópia
+ * \return false se não há destino na posição
+ */
+bool nrf::get_destination_stats(uint8_t index, nrf_stats_t *stats, uint8_t *addr, bool reset){
+    if(index >= _dest_count)
+        return false;
+    if(addr != NULL)
+        memcpy(addr, _dest_addr[index], 5);
+    _bus->lock();
+    *stats = _dest_stats[index];
+    if(reset)
+        memset(&_dest_stats[index], 0, sizeof(nrf_stats_t));
+    _bus->unlock();
+    return true;
+}
+
+/**
+ * \brief Zera as estatísticas de todos os pipes e destinos
+ * 
+ * Os destinos registrados são mantidos.
+ */
+void nrf::reset_stats(void){
+    _bus->lock();
+    memset(_pipe_stats, 0, sizeof(_pipe_stats));
+    memset(_dest_stats, 0, sizeof(_dest_stats));
+    _bus->unlock();
+}
+
+/* atualiza a taxa de sucesso: média exponencial com peso 1/16 */
+void nrf::stats_sample(nrf_stats_t *stats, uint16_t sample){
+    if(stats->packets == 0 && stats->failures == 0)
+        stats->success = sample;    // primeira amostra
+    else
+        stats->success += ((int32_t)sample - stats->success) / 16;
+}
+
+/* seleciona (ou registra) o destino dos próximos envios */
+void nrf::stats_select(const uint8_t *addr, uint8_t length){
+    uint8_t key[5] = {0, 0, 0, 0, 0};
+    memcpy(key, addr, (length > 5)? 5 : length);
+    for(_dest = 0; _dest < _dest_count; _dest++){
+        if(memcmp(_dest_addr[_dest], key, 5) == 0)
+            return;
+    }
+    if(_dest_count >= NRF_STATS_DESTINATIONS){
+        _dest = NRF_STATS_NO_DESTINATION;
+        return;
+    }
+    memcpy(_dest_addr[_dest], key, 5);
+    _dest_count++;
+}
+
+/* conta os bytes escritos no FIFO de TX para o destino atual */
+void nrf::stats_written(uint8_t length){
+    if(_dest != NRF_STATS_NO_DESTINATION)
+        _dest_stats[_dest].bytes += length;
+}
+
+/**
+ * \brief Conta os envios concluídos para o destino atual
+ * 
+ * Os pacotes perdidos são o aumento de PLOS_CNT desde a última leitura ou escrita de RF_CH.
+ * O contador satura em 15: ao atingir esse valor, RF_CH é reescrito com o canal atual, o que
+ * zera PLOS_CNT sem trocar de canal, para que as perdas seguintes continuem sendo contadas.
+ * O campo ARC_CNT refere-se ao último pacote; as retransmissões dos anteriores não
+ * são conhecidas.
+ * 
+ * \param[in] sent Pacotes confirmados (ver \ref tx_completions)
+ * \param[in] failed Pacote não confirmado após o número máximo de retransmissões
+ */
+void nrf::stats_transmitted(uint8_t sent, bool failed){
+    if(sent == 0 && !failed)
+        return;
+    uint8_t observe;
+    nrf::spi_read_register(OBSERVE_TX, &observe);
+    uint8_t plos = (observe & PLOS_CNT) >> 4;
+    // _plos é zerado a cada escrita de RF_CH (ver spi_write_register)
+    uint8_t lost = (plos > _plos)? plos - _plos : 0;
+    _plos = plos;
+    if(plos == 15)
+        nrf::spi_write_register(RF_CH, nrf::shadow(RF_CH));    // zera PLOS_CNT e _plos
+    if(_dest == NRF_STATS_NO_DESTINATION)
+        return;
+    
+    nrf_stats_t *stats = &_dest_stats[_dest];
+    uint8_t arc = observe & ARC_CNT;
+    stats->lost = (stats->lost > 0xFFFF - lost)? 0xFFFF : stats->lost + lost;
+    stats->retransmits += arc;
+    for(; sent > 0; sent--){
+        // ARC_CNT é do último pacote confirmado, se não houve falha
+        nrf::stats_sample(stats, (sent == 1 && !failed)? 0xFFFF / (arc + 1) : 0xFFFF);
+        stats->packets++;
+    }
+    if(failed){
+        nrf::stats_sample(stats, 0);
+        if(stats->failures < 0xFFFF)
+            stats->failures++;
+    }
+}
+
+/**
+ * \brief Conta um pacote recebido
+ * 
+ * Deve ser chamada antes da leitura do payload, para que o FIFO cheio seja detectado. O
+ * registrador RPD é mantido pelo chip desde o último pacote recebido.
+ * 
+ * \param[in] pipe Pipe de recepção
+ * \param[in] length Tamanho do payload
+ * \param[in] discarded Pacote descartado pela biblioteca
+ */
+void nrf::stats_received(uint8_t pipe, uint8_t length, bool discarded){
+    if(pipe > 5)
+        return;
+    nrf_stats_t *stats = &_pipe_stats[pipe];
+    if(discarded){
+        nrf::stats_sample(stats, 0);
+        if(stats->failures < 0xFFFF)
+            stats->failures++;
+        return;
+    }
+    uint8_t fifo, rpd;
+    nrf::spi_read_register(FIFO_STATUS, &fifo);
+    nrf::spi_read_register(RPD, &rpd);
+    nrf::stats_sample(stats, 0xFFFF);
+    stats->packets++;
+    stats->bytes += length;
+    if((fifo & RX_FULL) && stats->fifo_full < 0xFFFF)
+        stats->fifo_full++;
+    if((rpd & RPD_MASK) && stats->rpd_hits < 0xFFFF)
+        stats->rpd_hits++;
+}
+#endif
+
+/**
+ * \brief Retorna o estado dos buffers de recepção e transmissão.
+ * 
+ * \return Retorna byte de estado dos FIFO's de TX e RX
+ * 
+ */ 
+uint8_t nrf::get_fifo_status(void){
+    uint8_t reg;
+    nrf::spi_read_register(FIFO_STATUS,&reg);
+    return reg;
+}
+
+/**
+ * \brief Escreve o payload no buffer de transmissão.
+ * 
+ * \param [in] *buff Ponteiro para o buffer de dados que armazena o payload
+ * \param [in] length Tamanho do buffer
+ * \param [in] auto_ack true or false. Habilita ou não a função de auto-ack para o pacote a ser enviado.
+ * Pacotes sem auto-ack exigem o bit EN_DYN_ACK do registrador FEATURE, configurado automaticamente.
+ *
+ * \return true ou false
+ * \retval true Dados escritos com sucesso.
+ * \retval false Erro durante a escrita. Buffer de TX pode está cheio.
+ * 
+ */
+bool nrf::write_tx_payload(uint8_t *buff, uint8_t length, bool auto_ack){
+    NRF_TRACE_SCOPE(NRF_TRACE_WRITE_TX_PAYLOAD);
+    
+    if((_status & TX_FULL) && (nrf::get_status() & TX_FULL)){
+        return false; 
+    }
+    if(!auto_ack)
+        nrf::enable_dyn_ack();
+    
+    // write into tx fifo
+    nrf::spi_command( (auto_ack)? W_TX_PAYLOAD:W_TX_PAYLOAD_NOACK, buff, NULL, length);
+    _status |= TX_FULL; // FIFO pode ter ficado cheio
+#if NRF_STATS
+    nrf::stats_written(length);
+#endif
+    
+    return true;
+}
+
+/**
+ * \brief Aguarda o envio do pacote.
+ * 
+ * Utilize essa função para bloquear a execução do programa até o pacote ser enviado.
+ * 
+ * \return true ou false
+ * \retval true Pacote enviado com sucesso.
+ * \retval false Erro durante o envio. Dispositivo não está no modo de transmissão ou o número máximo de retransmissões foi atingido.
+ * Verifique se o chip está no modo transmissão e se o receptor está ativo e dentro da área de cobertura. 
+ */
+bool nrf::wait_packet_sent(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_WAIT_PACKET_SENT);
+    uint8_t config = nrf::shadow(CONFIG);
+    if( (config & PRIM_RX) | !_bus->read_ce() | !(config & PWR_UP) )  
+        return false;
+    
+    do{
+        while( !(_status & (TX_DS|MAX_RT)) ){
+            if( !nrf::irq_idle(MASK_TX_DS|MASK_MAX_RT) )
+                nrf::get_status();
+        }
+    
+        if(_status & MAX_RT){
+#if NRF_STATS
+            nrf::stats_transmitted((_status & TX_DS)? 1 : 0, true);
+#endif
+            nrf::clear_int_flag(NRF_MAX_RT);
+            nrf::flush_tx_fifo();
+            return false;
+        }
+#if NRF_STATS
+        nrf::stats_transmitted(1, false);
+#endif
+        nrf::clear_int_flag(NRF_TX_DS);
+    }while(!(nrf::get_fifo_status() & TX_EMPTY));
+    
+    return true;
+}
+
+/**
+ * \brief Envia um bloco de dados em sequência, sem intervalos entre os pacotes.
+ * 
+ * O bloco é dividido em pacotes de 'frame_size' bytes (o último pode ser menor) e o pino CE
+ * permanece em nível alto durante todo o envio. A cada flag TX_DS, o FIFO de TX é completado
+ * imediatamente, de modo que o próximo pacote já está no FIFO quando o anterior é confirmado.
+ * 
+ * Um pacote não confirmado após o número máximo de retransmissões (MAX_RT) é descartado e
+ * informado à função 'callback'. Os pacotes seguintes, que estavam no FIFO, são escritos
+ * novamente a partir de 'data' e o envio continua.
+ * 
+ * São mantidos no máximo \ref NRF_TX_WINDOW pacotes no FIFO (ver \ref tx_completions).
+ * 
+ * \param[in] *data Dados. Devem permanecer válidos até o retorno da função.
+ * \param[in] length Tamanho dos dados em bytes
+ * \param[in] frame_size Tamanho do payload de cada pacote (1 a 32)
+ * \param[in] callback Função chamada para cada pacote, com o índice do pacote e o resultado
+ * do envio (opcional)
+ * \param[in] auto_ack Se false, os pacotes são enviados sem pedido de ACK (difusão para vários
+ * receptores com o mesmo endereço). Cada pacote é informado como enviado ao final da sua
+ * transmissão.
+ * 
+ * \return Número de pacotes confirmados (ou transmitidos, sem auto-ack)
+ * 
+ * \warning O receptor deve utilizar payload dinâmico caso 'length' não seja múltiplo de
+ * 'frame_size'. Ao final, o dispositivo é colocado no modo 'standby'.
+ */
+uint16_t nrf::send_stream(const uint8_t *data, uint16_t length, uint8_t frame_size, nrf_stream_callback_t callback, bool auto_ack){
+    NRF_TRACE_SCOPE(NRF_TRACE_SEND_STREAM);
+    if(frame_size == 0 || frame_size > 32)
+        return 0;
+    
+    uint16_t frames = (length + frame_size - 1) / frame_size;
+    uint16_t done = 0;      // primeiro pacote ainda não confirmado
+    uint16_t next = 0;      // próximo pacote a ser escrito no FIFO
+    uint16_t delivered = 0;
+    
+    nrf::set_mode(NRF_STANDBY);
+    nrf::set_primary_rx(false);
+    nrf::flush_tx_fifo();
+    nrf::spi_write_register(STATUS, TX_DS|MAX_RT);
+    if(!auto_ack)
+        nrf::enable_dyn_ack();
+    
+    while(done < frames){
+        while(next < frames && (uint16_t)(next - done) < NRF_TX_WINDOW){
+            uint16_t offset = next * frame_size;
+            uint8_t size = (length - offset < frame_size)? length - offset : frame_size;
+            nrf::spi_command((auto_ack)? W_TX_PAYLOAD:W_TX_PAYLOAD_NOACK, data + offset, NULL, size);
+#if NRF_STATS
+            nrf::stats_written(size);
+#endif
+            next++;
+        }
+        if(!_bus->read_ce())
+            nrf::chip_enable();
+        
+        while( !(_status & (TX_DS|MAX_RT)) ){
+            if( !nrf::irq_idle(MASK_TX_DS|MASK_MAX_RT) )
+                nrf::get_status();
+        }
+        
+        bool failed;
+        uint8_t sent = nrf::tx_completions(next - done, &failed);
+#if NRF_STATS
+        nrf::stats_transmitted(sent, failed);
+#endif
+        for(; sent > 0; sent--, done++, delivered++){
+            if(callback != NULL)
+                callback(done, true);
+        }
+        
+        if(failed){
+            if(callback != NULL)
+                callback(done, false);
+            done++;
+            // descarta o pacote; os seguintes são escritos novamente
+            nrf::chip_disable();
+            nrf::flush_tx_fifo();
+            nrf::spi_write_register(STATUS, TX_DS|MAX_RT);
+            next = done;
+        }
+    }
+    
+    nrf::set_mode(NRF_STANDBY);
+    return delivered;
+}
+
+/**
+ * \brief Conta os payloads enviados desde a última chamada
+ * 
+ * Deve ser chamada quando TX_DS ou MAX_RT estiverem setados no último STATUS. O flag TX_DS é
+ * limpo; MAX_RT é mantido e deve ser tratado por quem chama (o chip para no payload não
+ * confirmado até que MAX_RT seja limpo).
+ * 
+ * O registrador FIFO_STATUS indica apenas FIFO vazio ou cheio: com até dois payloads no FIFO
+ * (\ref NRF_TX_WINDOW), o número de payloads enviados é sempre conhecido.
+ * 
+ * \param[in] in_flight Payloads escritos no FIFO e ainda não contados (até \ref NRF_TX_WINDOW)
+ * \param[out] *failed true se o primeiro payload não enviado atingiu MAX_RT
+ * \return Número de payloads enviados, na ordem em que foram escritos
+ */
+uint8_t nrf::tx_completions(uint8_t in_flight, bool *failed){
+    *failed = (_status & MAX_RT) != 0;
+    if(*failed){
+        // o chip para no pacote não confirmado; TX_DS indica que o anterior foi enviado
+        return (_status & TX_DS)? 1 : 0;
+    }
+    nrf::spi_write_register(STATUS, TX_DS);
+    if(!(nrf::get_fifo_status() & TX_EMPTY))
+        return 1;
+    // TX_DS setado após a limpeza já foi contado
+    nrf::spi_write_register(STATUS, TX_DS);
+    return in_flight;
+}
+
+/**
+ * \brief Escreve um payload para envio assíncrono
+ * 
+ * Não bloqueia: o resultado do envio é informado pelas funções registradas em \ref on_sent e
+ * \ref on_failed , chamadas por \ref poll . Se necessário, o dispositivo é colocado no modo
+ * 'tx' (ver \ref begin_mode).
+ * 
+ * \param[in] *buff Payload
+ * \param[in] length Tamanho do payload (até 32 bytes)
+ * \param[in] auto_ack Habilita ou não a função de auto-ack para o pacote
+ * 
+ * \return Identificador do envio, informado às funções de retorno, ou \ref NRF_NO_HANDLE se
+ * já há \ref NRF_TX_WINDOW payloads aguardando envio
+ * 
+ * \warning O FIFO de TX deve conter apenas payloads escritos por esta função: não utilize
+ * \ref write_tx_payload enquanto houver envios assíncronos pendentes.
+ */
+int16_t nrf::send_async(const uint8_t *buff, uint8_t length, bool auto_ack){
+    NRF_TRACE_SCOPE(NRF_TRACE_SEND_ASYNC);
+    if(_async_count >= NRF_TX_WINDOW)
+        return NRF_NO_HANDLE;
+    if(_async_count == 0 && (_status & (TX_DS|MAX_RT)))
+        nrf::spi_write_register(STATUS, TX_DS|MAX_RT);  // eventos de envios anteriores
+    if(!auto_ack)
+        nrf::enable_dyn_ack();
+    
+    nrf::spi_command((auto_ack)? W_TX_PAYLOAD:W_TX_PAYLOAD_NOACK, buff, NULL, length);
+#if NRF_STATS
+    nrf::stats_written(length);
+#endif
+    uint8_t handle = _async_next++;
+    _async_handles[_async_count++] = handle;
+    
+    if(_current_mode != NRF_TX_MODE)
+        nrf::begin_mode(NRF_TX_MODE);
+    return handle;
+}
+
+/**
+ * \brief Registra a função chamada ao fim de cada envio assíncrono confirmado
+ * 
+ * \param[in] callback Função (ver \ref nrf_sent_callback_t) ou NULL
+ */
+void nrf::on_sent(nrf_sent_callback_t callback){
+    _on_sent = callback;
+}
+
+/**
+ * \brief Registra a função chamada para envios assíncronos não confirmados
+ * 
+ * Quando um payload atinge o número máximo de retransmissões, ele e os payloads seguintes
+ * ainda no FIFO são descartados e informados a esta função.
+ * 
+ * \param[in] callback Função (ver \ref nrf_failed_callback_t) ou NULL
+ */
+void nrf::on_failed(nrf_failed_callback_t callback){
+    _on_failed = callback;
+}
+
+/**
+ * \brief Registra a função chamada para cada pacote recebido
+ * 
+ * Os pacotes são lidos por \ref poll (no PTX, os payloads de ACK também são informados).
+ * 
+ * \param[in] callback Função (ver \ref nrf_received_callback_t) ou NULL
+ */
+void nrf::on_received(nrf_received_callback_t callback){
+    _on_received = callback;
+}
+
+/* trata os eventos de TX dos envios assíncronos */
+void nrf::poll_async(void){
+    if(!(_status & (TX_DS|MAX_RT))){
+        if(nrf::irq_idle(MASK_TX_DS|MASK_MAX_RT))
+            return;
+        if(!(nrf::get_status() & (TX_DS|MAX_RT)))
+            return;
+    }
+    
+    bool failed;
+    uint8_t sent = nrf::tx_completions(_async_count, &failed);
+#if NRF_STATS
+    nrf::stats_transmitted(sent, failed);
+#endif
+    for(uint8_t i=0; i<_async_count; i++){
+        uint8_t handle = _async_handles[i];
+        if(i < sent){
+            if(_on_sent != NULL)
+                _on_sent(handle);
+        }else if(failed && _on_failed != NULL){
+            // apenas o primeiro foi transmitido; os seguintes foram descartados
+            _on_failed(handle, (i == sent)? (nrf::shadow(SETUP_RETR) & ARC) : 0);
+        }
+    }
+    if(failed){
+        nrf::flush_tx_fifo();
+        nrf::spi_write_register(STATUS, TX_DS|MAX_RT);
+        _async_count = 0;
+    }else{
+        _async_count -= sent;
+        for(uint8_t i=0; i<_async_count; i++)
+            _async_handles[i] = _async_handles[i + sent];
+    }
+}
+
+/**
+ * \brief Retorna o tamanho do payload recebido.
+ * 
+ * \return Tamanho do payload recebido em bytes
  * 
  */
 uint8_t nrf::get_received_payload_width(void){
-    uint8_t buff[2];
-    buff[0] = R_RX_PL_WID;
-    spi_transfer(_csn, buff, sizeof(buff));
-    return buff[1];
+    NRF_TRACE_SCOPE(NRF_TRACE_GET_RECEIVED_PAYLOAD_WIDTH);
+    uint8_t width;
+    nrf::spi_command(R_RX_PL_WID, NULL, &width, 1);
+    return width;
+}
+
+/**
+ * \brief Retorna o registrador OBSERVE_TX
+ * 
+ * \return Pacotes perdidos (PLOS_CNT, bits 4 a 7) e retransmissões do último pacote
+ * (ARC_CNT, bits 0 a 3)
+ * 
+ * \warning PLOS_CNT satura em 15 e é zerado apenas pela escrita do canal de RF
+ * (ver \ref set_rf_channel). Com \ref NRF_STATS , a biblioteca reescreve o canal atual
+ * quando o contador satura.
+ */
+uint8_t nrf::get_observe_tx(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_GET_OBSERVE_TX);
+    uint8_t observe;
+    nrf::spi_read_register(OBSERVE_TX, &observe);
+    return observe;
 }
 
 /**
  * \brief Configura Interrupção externa (IRQ).
  * 
  * Utilize essa função para configurar o pino de entrada para tratar o sinal de interrupção gerada pelo dispositivo (IRQ).
+ * Quando configurado, o pino é consultado pelas funções de espera antes de acessar a interface SPI.
  * 
  * \param[in] irq Pino de IRQ
  */
 void nrf::set_irq_pin(uint8_t irq){
-    _irq = irq;
-    pinMode(_irq,INPUT);
+    if(_bus->set_irq_pin(irq))
+        _irq = irq;
+}
+
+/**
+ * \brief Habilita o modo de recepção por interrupção.
+ * 
+ * A cada borda de descida do pino de IRQ, todos os pacotes do FIFO de recepção são copiados,
+ * com o pipe e o tamanho, para um buffer circular de \c NRF_RX_RING_SIZE posições (ver nrf_config.h).
+ * As funções \ref available , \ref get_data_source e \ref read_received_payload passam a consultar
+ * apenas o buffer circular. Se o buffer estiver cheio, o pacote é descartado e contabilizado
+ * em \ref get_rx_overruns .
+ * 
+ * Apenas a fonte RX_DR aciona o pino de IRQ neste modo. Os flags TX_DS e MAX_RT continuam
+ * disponíveis no registrador STATUS.
+ * 
+ * \return true ou false
+ * \retval true Modo habilitado
+ * \retval false Pino de IRQ não configurado (ver \ref set_irq_pin) ou sem interrupção externa
+ * (ver \ref nrf_backend::attach_irq).
+ * 
+ * \warning Até \ref NRF_MAX_RADIOS instâncias da classe podem utilizar este modo, cada uma com
+ * seu pino de IRQ.
+ */
+bool nrf::enable_rx_interrupt(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_ENABLE_RX_INTERRUPT);
+    if(_irq == NRF_NO_IRQ)
+        return false;
+    if(_rx_interrupt)
+        return true;
+    
+    uint8_t slot = 0;
+    while(slot < NRF_MAX_RADIOS && _isr_instances[slot] != NULL)
+        slot++;
+    if(slot == NRF_MAX_RADIOS)
+        return false;
+    
+    uint8_t config = nrf::shadow(CONFIG);
+    _config_masks = config & (MASK_RX_DR|MASK_TX_DS|MASK_MAX_RT);
+    nrf::spi_write_register(CONFIG, (config & ~MASK_RX_DR) | MASK_TX_DS | MASK_MAX_RT);
+    
+    _ring_head = 0;
+    _ring_tail = 0;
+    _ring_overruns = 0;
+    _isr_slot = slot;
+    _isr_instances[slot] = this;
+    
+    // pacotes já recebidos não gerariam nova borda no pino de IRQ
+    _bus->lock();
+    if(!_bus->attach_irq(isr_table[slot])){
+        _bus->unlock();
+        _isr_instances[slot] = NULL;
+        nrf::spi_write_register(CONFIG, config);
+        return false;
+    }
+    _rx_interrupt = true;
+    nrf::drain_rx_fifo();
+    _bus->unlock();
+    return true;
+}
+
+/**
+ * \brief Desabilita o modo de recepção por interrupção.
+ * 
+ * As máscaras de interrupção anteriores são restauradas. Pacotes ainda presentes no buffer
+ * circular são descartados.
+ */
+void nrf::disable_rx_interrupt(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_DISABLE_RX_INTERRUPT);
+    if(!_rx_interrupt)
+        return;
+    _bus->detach_irq();
+    _rx_interrupt = false;
+    _isr_instances[_isr_slot] = NULL;
+    uint8_t config = nrf::shadow(CONFIG) & ~(MASK_RX_DR|MASK_TX_DS|MASK_MAX_RT);
+    nrf::spi_write_register(CONFIG, config | _config_masks);
+}
+
+/**
+ * \brief Retorna o número de pacotes descartados por falta de espaço no buffer circular.
+ * 
+ * Utilize este valor para dimensionar \c NRF_RX_RING_SIZE .
+ * 
+ * \return Número de pacotes descartados desde \ref enable_rx_interrupt
+ */
+uint16_t nrf::get_rx_overruns(void){
+    _bus->lock();
+    uint16_t overruns = _ring_overruns;
+    _bus->unlock();
+    return overruns;
+}
+
+/**
+ * \brief Rotina de tratamento da interrupção externa (IRQ)
+ * 
+ * Uma rotina por instância no modo de recepção por interrupção (ver \ref isr_table).
+ */
+template<uint8_t slot> void nrf::rx_isr(void){
+    if(_isr_instances[slot] != NULL)
+        _isr_instances[slot]->drain_rx_fifo();
+}
+
+/**
+ * \brief Copia todos os pacotes do FIFO de recepção para o buffer circular
+ * 
+ * Executada no contexto da interrupção. Lê no máximo 3 pacotes (profundidade do FIFO), de
+ * modo que a rotina termina mesmo sem o chip (STATUS lido como 0x00). O flag RX_DR é limpo
+ * antes de cada leitura: um pacote recebido após a última limpeza gera nova borda no pino
+ * de IRQ.
+ */
+void nrf::drain_rx_fifo(void){
+#if NRF_TRACE
+    nrf_trace_scope _trace_scope(this, NRF_TRACE_RX_ISR, true);
+#endif
+    for(uint8_t i=0; i<3; i++){
+        // o STATUS retornado indica o pipe do próximo pacote no FIFO
+        nrf::clear_int_flag(NRF_RX_DR);
+        uint8_t pipe = (_status & RX_P_NO) >> 1;
+        if(pipe > 5)
+            break;  // 7: FIFO vazio, 6: valor não utilizado
+        uint8_t length = nrf::get_received_payload_width();
+#if NRF_STATS
+        nrf::stats_received(pipe, length, length > 32 ||
+                            (uint8_t)(_ring_head - _ring_tail) >= NRF_RX_RING_SIZE);
+#endif
+        if(length > 32){
+            nrf::flush_rx_fifo();
+            break;
+        }else if((uint8_t)(_ring_head - _ring_tail) < NRF_RX_RING_SIZE){
+            nrf_packet_t *packet = &_ring[_ring_head & (NRF_RX_RING_SIZE-1)];
+            packet->pipe = pipe;
+            packet->length = length;
+            nrf::read_payload(packet->data, length);
+            NRF_BARRIER();  // posição preenchida antes do índice
+            _ring_head++;   // publica o pacote para o loop principal
+        }else{
+            nrf::read_payload(NULL, length);
+            _ring_overruns++;
+        }
+    }
 }
 
 /**
@@ -941,8 +2266,8 @@ void nrf::set_irq_pin(uint8_t irq){
  * resetá-lo utilize a função \ref clear_int_flag ou \ref clear_all_int_flags
  */
 void nrf::set_int_source(nrf_int_source_t int_source, bool enable){
-    uint8_t config;
-    nrf::spi_read_register(CONFIG,&config);
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_INT_SOURCE);
+    uint8_t config = nrf::shadow(CONFIG);
     switch(int_source){
         case (NRF_RX_DR):
         if(enable){
@@ -975,9 +2300,9 @@ void nrf::set_int_source(nrf_int_source_t int_source, bool enable){
  * 
  * \warning Um PTX que transmite para um PRX com payload dinâmico habilitado deve ter o bit DPL_P0 no registrador DYNPD setado.
  * */
-void nrf::set_dynamic_payload(nrf_address_t pipe, boolean dyn_pl){
-    uint8_t last_value;
-    nrf::spi_read_register(DYNPD,&last_value);
+void nrf::set_dynamic_payload(nrf_address_t pipe, bool dyn_pl){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_DYNAMIC_PAYLOAD);
+    uint8_t last_value = nrf::shadow(DYNPD);
     switch(pipe){
         case NRF_PIPE0:
         case NRF_PIPE1:
@@ -993,13 +2318,228 @@ void nrf::set_dynamic_payload(nrf_address_t pipe, boolean dyn_pl){
         }
     }
     
-    nrf::spi_read_register(DYNPD,&last_value);
-    uint8_t feature;
-    nrf::spi_read_register(FEATURE, &feature);
-    if(last_value){
-        nrf::spi_write_register(FEATURE, feature|EN_DPL);
+    uint8_t feature = nrf::shadow(FEATURE);
+    // payloads no ACK exigem EN_DPL (ver enable_ack_payload)
+    uint8_t new_feature = (nrf::shadow(DYNPD) || (feature & EN_ACK_PAY))? (feature | EN_DPL) : (feature & ~EN_DPL);
+    if(new_feature != feature)
+        nrf::spi_write_register(FEATURE, new_feature);
+}
+
+/**
+ * \brief Habilita o envio de payloads nos pacotes ACK
+ * 
+ * Com esta função habilitada, o PRX responde ao PTX no próprio ACK (ver \ref write_ack_payload)
+ * e o PTX lê a resposta após o envio (ver \ref read_ack_payload), sem troca de modo.
+ * 
+ * Configura os bits EN_ACK_PAY e EN_DPL do registrador FEATURE e o payload dinâmico no PIPE0,
+ * exigidos em ambos os dispositivos.
+ * 
+ * \param[in] enable true ou false
+ * 
+ * \warning Com payloads no ACK, o tempo de retransmissão (ver \ref set_retr_param) deve ser
+ * suficiente para a recepção do ACK (500us para payloads acima de 15 bytes a 2Mbps).
+ */
+void nrf::enable_ack_payload(bool enable){
+    NRF_TRACE_SCOPE(NRF_TRACE_ENABLE_ACK_PAYLOAD);
+    uint8_t feature = nrf::shadow(FEATURE);
+    if(enable){
+        nrf::spi_write_register(FEATURE, feature | EN_ACK_PAY | EN_DPL);
+        nrf::set_dynamic_payload(NRF_PIPE0, true);
     }else{
-        nrf::spi_write_register(FEATURE, feature & ~EN_DPL);
+        feature &= ~EN_ACK_PAY;
+        if(!nrf::shadow(DYNPD))
+            feature &= ~EN_DPL;
+        nrf::spi_write_register(FEATURE, feature);
+    }
+}
+
+/**
+ * \brief Escreve o payload do próximo ACK enviado no pipe (PRX)
+ * 
+ * O payload é enviado no ACK do próximo pacote recebido no pipe. Os payloads de ACK ocupam
+ * o FIFO de TX, de três posições, compartilhado por todos os pipes.
+ * 
+ * \param[in] pipe Pipe de recepção
+ * \param[in] *buff Payload
+ * \param[in] length Tamanho do payload (até 32 bytes)
+ * 
+ * \return true ou false
+ * \retval true Payload escrito
+ * \retval false FIFO de TX cheio (ver \ref flush_ack_payloads)
+ * 
+ * \warning Utilize \ref enable_ack_payload antes desta função.
+ */
+bool nrf::write_ack_payload(nrf_address_t pipe, const uint8_t *buff, uint8_t length){
+    NRF_TRACE_SCOPE(NRF_TRACE_WRITE_ACK_PAYLOAD);
+    if(!(nrf::shadow(DYNPD) & BIT((uint8_t)pipe)))
+        nrf::set_dynamic_payload(pipe, true);
+    if(_status & TX_DS)
+        nrf::spi_write_register(STATUS, TX_DS);    // ACK com payload enviado
+    
+    if((_status & TX_FULL) && (nrf::get_status() & TX_FULL))
+        return false;
+    
+    nrf::spi_command(W_ACK_PAYLOAD | (uint8_t)pipe, buff, NULL, length);
+    _status |= TX_FULL; // FIFO pode ter ficado cheio
+    return true;
+}
+
+/**
+ * \brief Descarta os payloads de ACK ainda não enviados (PRX)
+ */
+void nrf::flush_ack_payloads(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_FLUSH_ACK_PAYLOADS);
+    nrf::flush_tx_fifo();
+}
+
+/**
+ * \brief Lê o payload recebido no ACK (PTX)
+ * 
+ * Após o envio (ver \ref wait_packet_sent), o payload do ACK é armazenado no FIFO de
+ * recepção, no PIPE0.
+ * 
+ * \param [out] *buff Ponteiro para o buffer de dados (mínimo de 32 bytes)
+ * \param [out] *length Ponteiro para o tamanho do payload recebido.
+ * 
+ * \return true se havia payload de ACK no FIFO de recepção
+ */
+bool nrf::read_ack_payload(uint8_t *buff, uint8_t *length){
+    NRF_TRACE_SCOPE(NRF_TRACE_READ_ACK_PAYLOAD);
+    return nrf::read_received_payload(buff, length);
+}
+
+/**
+ * \brief Habilita o comando W_TX_PAYLOAD_NOACK
+ * 
+ * Sem o bit EN_DYN_ACK do registrador FEATURE, o chip ignora o comando e o payload
+ * não é escrito no FIFO de TX.
+ */
+void nrf::enable_dyn_ack(void){
+    uint8_t feature = nrf::shadow(FEATURE);
+    if(!(feature & EN_DYN_ACK))
+        nrf::spi_write_register(FEATURE, feature | EN_DYN_ACK);
+}
+
+/**
+ * \brief Inicia o envio periódico de um beacon
+ * 
+ * O payload é escrito uma única vez no FIFO de TX e reutilizado (comando REUSE_TX_PL): cada
+ * envio é apenas um pulso no pino CE, sem transferências SPI. O primeiro envio é imediato e
+ * os seguintes são feitos por \ref poll_beacon . Os pacotes são enviados sem pedido de ACK.
+ * 
+ * A interrupção TX_DS é mascarada até \ref stop_beacon : o bit permanece em '1' no registrador
+ * STATUS entre os envios, sem manter o pino de IRQ ativo.
+ * 
+ * \param[in] *buff Payload
+ * \param[in] length Tamanho do payload (até 32 bytes)
+ * \param[in] count Número de envios. Se 0, o beacon é enviado até \ref stop_beacon .
+ * \param[in] interval Intervalo entre os envios em microssegundos
+ * 
+ * \return false se o intervalo for menor que a estabilização do PLL (ver \ref set_settle_times)
+ * somada à duração do pacote; o beacon não é iniciado.
+ * 
+ * \warning O dispositivo permanece no modo 'standby' entre os envios. Não utilize outras funções
+ * de envio ou recepção antes de \ref stop_beacon .
+ */
+bool nrf::start_beacon(const uint8_t *buff, uint8_t length, uint16_t count, uint32_t interval){
+    NRF_TRACE_SCOPE(NRF_TRACE_START_BEACON);
+    if(interval < _settle_delay + (uint32_t)nrf::airtime(length))
+        return false;
+    nrf::set_mode(NRF_STANDBY);
+    nrf::set_primary_rx(false);
+    nrf::flush_tx_fifo();
+    nrf::spi_write_register(STATUS, TX_DS|MAX_RT);
+    uint8_t config = nrf::shadow(CONFIG);
+    _beacon_masks = config & MASK_TX_DS;
+    if(!_beacon_masks)
+        nrf::spi_write_register(CONFIG, config | MASK_TX_DS);
+    nrf::enable_dyn_ack();
+    nrf::spi_command(W_TX_PAYLOAD_NOACK, buff, NULL, length);
+    nrf::spi_command(REUSE_TX_PL, NULL, NULL, 0);
+    
+    _beacon_active = true;
+    _beacon_count = count;
+    _beacon_remaining = count;
+    _beacon_interval = interval;
+    nrf::pulse_beacon();
+    return true;
+}
+
+/**
+ * \brief Envia o beacon quando o intervalo é atingido
+ * 
+ * Deve ser chamada periodicamente, com frequência maior que a dos envios. Encerra o beacon
+ * após o número de envios informado em \ref start_beacon .
+ * 
+ * \return true enquanto o beacon estiver ativo
+ */
+bool nrf::poll_beacon(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_POLL_BEACON);
+    if(!_beacon_active)
+        return false;
+    if((_bus->micros() - _beacon_last) < _beacon_interval)
+        return true;
+    if(_beacon_count != 0 && _beacon_remaining == 0){
+        nrf::stop_beacon();    // último envio já concluído
+        return false;
+    }
+    nrf::pulse_beacon();
+    return true;
+}
+
+/**
+ * \brief Encerra o beacon
+ * 
+ * Descarta o payload reutilizado, restaura a máscara de TX_DS e coloca o dispositivo no modo
+ * 'standby'.
+ */
+void nrf::stop_beacon(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_STOP_BEACON);
+    bool unmask = _beacon_active && !_beacon_masks;
+    _beacon_active = false;
+    nrf::chip_disable();
+    nrf::flush_tx_fifo();
+    nrf::spi_write_register(STATUS, TX_DS|MAX_RT);
+    if(unmask)
+        nrf::spi_write_register(CONFIG, nrf::shadow(CONFIG) & ~MASK_TX_DS);
+    nrf::set_mode(NRF_STANDBY);
+}
+
+/**
+ * \brief Verifica se o payload de TX está sendo reutilizado
+ * 
+ * \return Bit TX_REUSE do registrador FIFO_STATUS: true após o comando REUSE_TX_PL (ver
+ * \ref start_beacon), até a escrita de um novo payload ou o descarte do FIFO de TX.
+ */
+bool nrf::get_tx_reuse(void){
+    NRF_TRACE_SCOPE(NRF_TRACE_GET_TX_REUSE);
+    return (nrf::get_fifo_status() & TX_REUSE) != 0;
+}
+
+/* pulso de CE (mínimo de 10us): o payload reutilizado é enviado uma vez */
+void nrf::pulse_beacon(void){
+    _beacon_last = _bus->micros();
+    if(_beacon_remaining > 0)
+        _beacon_remaining--;
+    nrf::chip_enable();
+    _bus->delay_us(10);
+    nrf::chip_disable();
+}
+
+/**
+ * \brief Duração de uma transmissão (us) na taxa de dados atual
+ * 
+ * Preâmbulo, endereço, campo de controle (9 bits), payload e CRC.
+ */
+uint16_t nrf::airtime(uint8_t length){
+    uint16_t bits = 8 * (1 + nrf::get_address_width() + length + nrf::get_crc_mode()) + 9;
+    switch(nrf::get_rf_datarate()){
+        case NRF_2MBPS:
+        return bits / 2;
+        case NRF_1MBPS:
+        return bits;
+        default:
+        return bits * 4;
     }
 }
 
@@ -1016,50 +2556,62 @@ void nrf::set_dynamic_payload(nrf_address_t pipe, boolean dyn_pl){
  * \li \c NRF_TX_MODE. TX mode Modo de transmissão. Neste modo o dispositivo monta os pacotes a partir do FIFO de TX
  * e os envia. Quando o FIFO está vazio, o dispositivo automaticamente vai para um estado de menor consumo.
  * 
+ * A função retorna após o tempo de estabilização do novo modo. Para não bloquear, utilize
+ * \ref begin_mode e \ref is_ready .
  * */
 void nrf::set_mode(nrf_operation_mode_t mode){
+    NRF_TRACE_SCOPE(NRF_TRACE_SET_MODE);
+    nrf::begin_mode(mode);
+    nrf::wait_ready();
+}
+
+/**
+ * \brief Inicia a transição para o modo de operação, sem aguardar a estabilização
+ * 
+ * O registrador CONFIG (uma escrita, apenas se houver mudança) e o pino CE são configurados
+ * imediatamente. O chip estará pronto no novo
+ * modo após o tempo de partida do oscilador (a partir de 'power down') e de estabilização do
+ * PLL (modos 'rx' e 'tx'), ver \ref set_settle_times . Consulte \ref is_ready .
+ * 
+ * \param [in] mode Modo de operação (ver \ref set_mode)
+ * */
+void nrf::begin_mode(nrf_operation_mode_t mode){
+    NRF_TRACE_SCOPE(NRF_TRACE_BEGIN_MODE);
+    uint32_t settle = (mode != NRF_POWER_DOWN && _current_mode == NRF_POWER_DOWN)? _power_up_delay : 0;
     _last_mode = _current_mode;
-     
+    
+    // valor final de CONFIG: uma única escrita por transição, apenas se houver mudança
+    uint8_t config = nrf::shadow(CONFIG);
     switch(mode){
     
     case NRF_POWER_DOWN:
-    nrf::chip_disable();
-    nrf::set_power_up(false);
-    _current_mode = NRF_POWER_DOWN;
+    config &= ~PWR_UP;
     break;
     
     case NRF_STANDBY:
-    nrf::chip_disable();
-    nrf::set_power_up(true);
-    if(_current_mode == NRF_POWER_DOWN)
-        delay(5);
-    _current_mode = NRF_STANDBY;
+    config |= PWR_UP;
     break;
     
     case NRF_RX_MODE:
-    nrf::chip_disable();
-    nrf::set_power_up(true);
-    nrf::set_primary_rx(true);
-    nrf::chip_enable();
-    if(_current_mode == NRF_STANDBY)
-        delayMicroseconds(150);
-    if(_current_mode == NRF_POWER_DOWN)
-        delay(5);
-    _current_mode = NRF_RX_MODE;
+    config |= PWR_UP | PRIM_RX;
+    settle += _settle_delay;
     break;
     
     case NRF_TX_MODE:
-    nrf::chip_disable();
-    nrf::set_power_up(true);
-    nrf::set_primary_rx(false);
-    nrf::chip_enable();
-    if(_current_mode == NRF_STANDBY)
-        delayMicroseconds(150);
-    if(_current_mode == NRF_POWER_DOWN)
-        delay(5);
-    _current_mode = NRF_TX_MODE;
+    config = (config | PWR_UP) & ~PRIM_RX;
+    settle += _settle_delay;
     
     }
+    nrf::chip_disable();
+    if(config != nrf::shadow(CONFIG))
+        nrf::spi_write_register(CONFIG, config);
+    if(mode == NRF_RX_MODE || mode == NRF_TX_MODE)
+        nrf::chip_enable();
+    _current_mode = mode;
+    
+    uint32_t ready_at = _bus->micros() + settle;
+    if((int32_t)(ready_at - _ready_at) > 0)
+        _ready_at = ready_at;
 }
 
 /**
@@ -32,6 +32,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * ambiente do Arduino Uno e pode ser estendida para outros ambientes como por
  * exemplo o raspberryPi.
  * 
+ * O acesso ao hardware é feito através da interface \ref nrf_backend . No Arduino é utilizada
+ * a classe \ref nrf_arduino_backend e no Linux (raspberryPi) a classe \ref nrf_linux_backend ,
+ * baseada nos dispositivos /dev/spidevX.Y e /dev/gpiochipN.
+ * 
  * \section chip_sec Chip nordic nRF24L01+
  * 
  * O chip nRF24L01+ é uma transceptor digital que pode operar na faixa de 2,4GHz 
@@ -94,11 +98,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef NRF_H
 #define NRF_H
 
-#include<Arduino.h>
 #include<stdint.h>
-#include<SPI.h>
-#include "spidrv.h"
+#include<stddef.h>
+#include "nrf_backend.h"
 #include "nordic.h"
+#include "nrf_config.h"
+
+/** \brief Número de registradores de configuração mantidos em cache (ver \ref nrf::sync_registers) */
+#define NRF_SHADOW_SIZE     19
+/** \brief Valor retornado para registradores que não possuem cópia em cache */
+#define NRF_NOT_SHADOWED    0xFF
+/** \brief Pino de IRQ não configurado */
+#define NRF_NO_IRQ          0xFF
+#if NRF_REGISTER_MAP
+/** \brief Número de registradores do mapa: 0x00 a FIFO_STATUS, DYNPD e FEATURE (ver \ref nrf::snapshot_registers) */
+#define NRF_REGISTER_COUNT  26
+/** \brief Tamanho da imagem dos registradores em bytes: RX_ADDR_P0, RX_ADDR_P1 e TX_ADDR ocupam 5 bytes */
+#define NRF_REGISTER_IMAGE_SIZE     38
+#endif
 
 typedef enum{
     NRF_18DBM = 0,
@@ -146,6 +163,191 @@ typedef enum{
         NRF_RX_MODE
 }nrf_operation_mode_t;
 
+/**
+ * \brief Pacote recebido
+ * 
+ * Posição do buffer circular preenchido pela rotina de interrupção (ver \ref nrf::enable_rx_interrupt).
+ * */
+typedef struct{
+    uint8_t pipe;       ///< Pipe de recepção
+    uint8_t length;     ///< Tamanho do payload
+    uint8_t data[32];   ///< Payload
+}nrf_packet_t;
+
+/**
+ * \brief Função chamada a cada pacote enviado por \ref nrf::send_stream
+ * 
+ * \param[in] frame Índice do pacote no bloco de dados
+ * \param[in] delivered true se o pacote foi confirmado, false se foi descartado (MAX_RT)
+ * */
+typedef void (*nrf_stream_callback_t)(uint16_t frame, bool delivered);
+
+/** \brief Payloads mantidos no FIFO de TX por \ref nrf::send_stream e \ref nrf::send_async */
+#define NRF_TX_WINDOW       2
+/** \brief Retornado por \ref nrf::send_async quando não há espaço no FIFO de TX */
+#define NRF_NO_HANDLE       (-1)
+
+/**
+ * \brief Função chamada por \ref nrf::poll para cada envio assíncrono confirmado
+ * 
+ * \param[in] handle Identificador retornado por \ref nrf::send_async
+ * */
+typedef void (*nrf_sent_callback_t)(uint8_t handle);
+
+/**
+ * \brief Função chamada por \ref nrf::poll para cada envio assíncrono não confirmado
+ * 
+ * \param[in] handle Identificador retornado por \ref nrf::send_async
+ * \param[in] retries Retransmissões realizadas (0 para payloads descartados sem transmissão)
+ * */
+typedef void (*nrf_failed_callback_t)(uint8_t handle, uint8_t retries);
+
+/**
+ * \brief Função chamada por \ref nrf::poll para cada pacote recebido
+ * 
+ * \param[in] *buff Payload (válido apenas durante a chamada)
+ * \param[in] length Tamanho do payload
+ * \param[in] pipe Pipe de recepção
+ * */
+typedef void (*nrf_received_callback_t)(const uint8_t *buff, uint8_t length, uint8_t pipe);
+
+/**
+ * \brief Configuração de um pipe de recepção (ver \ref nrf_profile_t)
+ * */
+typedef struct{
+    bool enabled;               ///< Pipe habilitado
+    bool auto_ack;              ///< Auto-ack habilitado
+    uint8_t width;              ///< Tamanho estático do payload (1 a 32) ou 0 para payload dinâmico
+    const uint8_t *address;     ///< Endereço (NULL: não alterado). Nos pipes 2 a 5, apenas o primeiro byte.
+}nrf_pipe_profile_t;
+
+/**
+ * \brief Configuração completa do rádio, aplicada por \ref nrf::apply_profile
+ * 
+ * Estrutura sem construtores, que pode ser inicializada estaticamente:
+ * \code
+ * const nrf_profile_t sensor_link = {
+ *     25, NRF_2MBPS, NRF_0DBM, NRF_AW_5BYTES, NRF_CRC_2BYTES,
+ *     3, 1,                   // 3 retransmissões, 500us
+ *     0, 0,                   // todas as interrupções habilitadas, sem recursos adicionais
+ *     prx_addr,               // endereço de transmissão
+ *     { {true, true, 0, prx_addr}, {true, true, 0, ptx_addr} }   // pipes 0 e 1, payload dinâmico
+ * };
+ * \endcode
+ * */
+typedef struct{
+    uint8_t channel;                    ///< Canal de RF (0 a 125)
+    nrf_datarate_t datarate;            ///< Taxa de dados
+    nrf_power_t power;                  ///< Potência de saída
+    nrf_address_width_t address_width;  ///< Tamanho dos endereços
+    nrf_crc_mode_t crc;                 ///< Tamanho do CRC
+    uint8_t retr_count;                 ///< Número de retransmissões (0 a 15)
+    uint8_t retr_delay;                 ///< Atraso das retransmissões, 250*(1+retr_delay) us (0 a 15)
+    uint8_t irq_masks;                  ///< Interrupções desabilitadas (bits MASK_RX_DR, MASK_TX_DS e MASK_MAX_RT)
+    uint8_t features;                   ///< Bits EN_ACK_PAY e EN_DYN_ACK do registrador FEATURE
+    const uint8_t *tx_address;          ///< Endereço de transmissão (NULL: não alterado)
+    nrf_pipe_profile_t pipes[6];        ///< Pipes de recepção
+}nrf_profile_t;
+
+#if NRF_TRACE
+/**
+ * \brief Métodos medidos pelos contadores de instrumentação (ver \ref nrf::get_trace)
+ * */
+typedef enum{
+    NRF_TRACE_INIT = 0,     ///< Inicialização (ver \ref nrf::is_ready)
+    NRF_TRACE_SET_RF_CHANNEL,
+    NRF_TRACE_SET_RF_POWER,
+    NRF_TRACE_SET_RF_DATARATE,
+    NRF_TRACE_SET_ADDRESS_WIDTH,
+    NRF_TRACE_ENABLE_RX_PIPE,
+    NRF_TRACE_DISABLE_RX_PIPE,
+    NRF_TRACE_SET_RX_ADDRESS,
+    NRF_TRACE_SET_STATIC_PAYLOAD_WIDTH,
+    NRF_TRACE_SET_TX_ADDRESS,
+    NRF_TRACE_SET_RETR_PARAM,
+    NRF_TRACE_SET_CRC_MODE,
+    NRF_TRACE_AVAILABLE,
+    NRF_TRACE_WAIT_AVAILABLE,
+    NRF_TRACE_WAIT_AVAILABLE_TIMEOUT,
+    NRF_TRACE_WRITE_TX_PAYLOAD,
+    NRF_TRACE_READ_RECEIVED_PAYLOAD,
+    NRF_TRACE_WAIT_PACKET_SENT,
+    NRF_TRACE_ENABLE_RX_INTERRUPT,
+    NRF_TRACE_DISABLE_RX_INTERRUPT,
+    NRF_TRACE_RX_ISR,       ///< Rotina de interrupção do modo de recepção por interrupção
+    NRF_TRACE_SET_INT_SOURCE,
+    NRF_TRACE_SET_DYNAMIC_PAYLOAD,
+    NRF_TRACE_CLEAR_ALL_INT_FLAGS,
+    NRF_TRACE_CLEAR_INT_FLAG,
+    NRF_TRACE_GET_RECEIVED_PAYLOAD_WIDTH,
+    NRF_TRACE_GET_DATA_SOURCE,
+    NRF_TRACE_SET_MODE,
+    NRF_TRACE_SYNC_REGISTERS,
+    NRF_TRACE_VERIFY_REGISTERS,
+    NRF_TRACE_PRINT_REGISTERS,
+    NRF_TRACE_SEND_STREAM,
+    NRF_TRACE_ENABLE_ACK_PAYLOAD,
+    NRF_TRACE_WRITE_ACK_PAYLOAD,
+    NRF_TRACE_FLUSH_ACK_PAYLOADS,
+    NRF_TRACE_READ_ACK_PAYLOAD,
+    NRF_TRACE_START_BEACON,
+    NRF_TRACE_POLL_BEACON,
+    NRF_TRACE_STOP_BEACON,
+    NRF_TRACE_GET_TX_REUSE,
+    NRF_TRACE_APPLY_PROFILE,
+    NRF_TRACE_BEGIN_MODE,
+    NRF_TRACE_SEND_ASYNC,
+    NRF_TRACE_POLL,
+    NRF_TRACE_GET_OBSERVE_TX,
+    NRF_TRACE_SCAN_CHANNELS,
+    NRF_TRACE_SWITCH_CHANNEL,
+    NRF_TRACE_SNAPSHOT_REGISTERS,
+    NRF_TRACE_COUNT
+}nrf_trace_id_t;
+
+/** \brief Nenhum método em execução */
+#define NRF_TRACE_NONE      0xFF
+
+/**
+ * \brief Contadores de instrumentação de um método
+ * 
+ * Cada transação SPI corresponde a uma seleção do chip (CSN). As transações executadas por
+ * métodos chamados internamente são atribuídas ao método chamado pela aplicação.
+ * */
+typedef struct{
+    uint32_t calls;         ///< Número de chamadas
+    uint32_t transactions;  ///< Transações SPI (seleções do chip)
+    uint32_t bytes;         ///< Bytes transferidos, incluindo o comando
+    uint32_t spi_us;        ///< Tempo gasto nas transferências SPI (us)
+    uint32_t total_us;      ///< Tempo total das chamadas (us), para o cálculo da média
+    uint32_t min_us;        ///< Menor latência (us)
+    uint32_t max_us;        ///< Maior latência (us)
+}nrf_trace_t;
+#endif
+
+#if NRF_STATS
+/** \brief Destino sem estatísticas: tabela cheia (ver \ref NRF_STATS_DESTINATIONS) */
+#define NRF_STATS_NO_DESTINATION    0xFF
+
+/**
+ * \brief Estatísticas de um enlace: pipe de recepção ou destino de transmissão
+ * 
+ * Nos destinos, a taxa de sucesso considera as retransmissões: um pacote confirmado após n
+ * retransmissões contribui com 1/(n+1) e um pacote não confirmado, com 0. Nos pipes, apenas
+ * os pacotes descartados na recepção contam como falha. Os contadores de 16 bits saturam.
+ * */
+typedef struct{
+    uint32_t packets;       ///< Pacotes confirmados (destino) ou recebidos (pipe)
+    uint32_t bytes;         ///< Bytes de payload escritos para envio (destino) ou recebidos (pipe)
+    uint32_t retransmits;   ///< Retransmissões, pelo campo ARC_CNT (destino)
+    uint16_t failures;      ///< Envios com MAX_RT (destino) ou pacotes descartados: tamanho inválido ou buffer circular cheio (pipe)
+    uint16_t lost;          ///< Pacotes perdidos pelo campo PLOS_CNT, zerado ao saturar (destino)
+    uint16_t fifo_full;     ///< Pacotes lidos com o FIFO de recepção cheio (pipe)
+    uint16_t rpd_hits;      ///< Pacotes lidos com RPD=1, sinal acima de -64dBm (pipe)
+    uint16_t success;       ///< Taxa de sucesso, média exponencial com peso 1/16 (65535 = 100%)
+}nrf_stats_t;
+#endif
+
 /**
  * \brief Classe nrf
  * 
@@ -156,9 +358,15 @@ typedef enum{
 class nrf{
     
 public:
-	nrf(uint8_t ce=9, uint8_t csn=10);
+#if defined(ARDUINO)
+	nrf(uint8_t ce=9, uint8_t csn=10, uint32_t spi_clock=NRF_SPI_CLOCK);
+#endif
+    nrf(nrf_backend *backend);
+    virtual ~nrf();
     void set_rf_channel(uint8_t rf_channel);
     uint8_t get_rf_channel(void);
+    void scan_channels(uint8_t *hist, uint8_t passes, uint8_t first=0, uint8_t last=125);
+    void switch_channel(uint8_t rf_channel);
     void set_rf_power(nrf_power_t power);
     uint8_t get_rf_power(void);
     void set_rf_datarate(nrf_datarate_t speed);
@@ -179,21 +387,63 @@ public:
     void wait_available(void);
     bool wait_available_timeout(const unsigned long timeout);
     bool write_tx_payload(uint8_t *buff, uint8_t length, bool auto_ack=true);
-    bool read_received_payload(uint8_t *buff, uint8_t *length);
+    bool read_received_payload(uint8_t *buff, uint8_t *length, uint8_t *pipe=NULL);
     bool wait_packet_sent(void);
+    int16_t send_async(const uint8_t *buff, uint8_t length, bool auto_ack=true);
+    void on_sent(nrf_sent_callback_t callback);
+    void on_failed(nrf_failed_callback_t callback);
+    void on_received(nrf_received_callback_t callback);
+    uint16_t send_stream(const uint8_t *data, uint16_t length, uint8_t frame_size, nrf_stream_callback_t callback=NULL, bool auto_ack=true);
     void set_irq_pin(uint8_t irq = 2);
+    bool enable_rx_interrupt(void);
+    void disable_rx_interrupt(void);
+    uint16_t get_rx_overruns(void);
     void set_int_source(nrf_int_source_t int_source, bool enable);
-    void set_dynamic_payload(nrf_address_t pipe, boolean dyn_pl);
+    void set_dynamic_payload(nrf_address_t pipe, bool dyn_pl);
+    void enable_ack_payload(bool enable);
+    bool write_ack_payload(nrf_address_t pipe, const uint8_t *buff, uint8_t length);
+    void flush_ack_payloads(void);
+    bool read_ack_payload(uint8_t *buff, uint8_t *length);
+    bool start_beacon(const uint8_t *buff, uint8_t length, uint16_t count, uint32_t interval);
+    bool poll_beacon(void);
+    void stop_beacon(void);
+    bool get_tx_reuse(void);
     void clear_all_int_flags(void);
     void clear_int_flag(nrf_int_source_t int_source);
     uint8_t get_received_payload_width(void);
+    uint8_t get_observe_tx(void);
     uint8_t get_data_source(void);
     void set_mode(nrf_operation_mode_t mode); 
+    void begin_mode(nrf_operation_mode_t mode);
+    bool is_ready(void);
+    void poll(void);
+    void set_settle_times(uint16_t power_up, uint16_t settle);
     nrf_operation_mode_t get_current_mode();
     void retrieve_last_mode();
+    void apply_profile(const nrf_profile_t *profile);
+    void sync_registers(void);
+    bool verify_registers(void);
+    uint8_t get_last_status(void);
+    nrf_backend *get_backend(void);
+#if NRF_TRACE
+    const nrf_trace_t *get_trace(nrf_trace_id_t id);
+    void reset_trace(void);
+    void print_trace(void);
+#endif
+#if NRF_STATS
+    void get_pipe_stats(nrf_address_t pipe, nrf_stats_t *stats, bool reset=false);
+    bool get_destination_stats(uint8_t index, nrf_stats_t *stats, uint8_t *addr=NULL, bool reset=false);
+    void reset_stats(void);
+#endif
     
     //debug
+#if NRF_REGISTER_MAP
     void print_registers(void);
+    void print_register_fields(void);
+    uint8_t snapshot_registers(uint8_t *image);
+    static uint32_t diff_registers(const uint8_t *before, const uint8_t *after);
+    void print_register_diff(const uint8_t *before, const uint8_t *after);
+#endif
     void print_buffer(uint8_t *buff, uint8_t length);
     
     
@@ -203,23 +453,116 @@ public:
     
     
 private:
-    uint8_t _ce; //pino de CE
-	uint8_t _csn; //pino de CSN
+    template<uint8_t ce, uint8_t csn, class config> friend class nrf_t;
+    friend class nrf_listen;
+#if NRF_TRACE
+    friend class nrf_trace_scope;
+    nrf_trace_t _trace[NRF_TRACE_COUNT];
+    uint8_t _trace_id; //método em execução (NRF_TRACE_NONE fora da classe)
+#endif
+#if NRF_REGISTER_MAP
+    void print_image(const uint8_t *image, const uint8_t *previous, bool fields);
+#endif
+#if NRF_STATS
+    nrf_stats_t _pipe_stats[6]; //atualizadas também na interrupção
+    nrf_stats_t _dest_stats[NRF_STATS_DESTINATIONS];
+    uint8_t _dest_addr[NRF_STATS_DESTINATIONS][5];
+    uint8_t _dest_count;
+    uint8_t _dest; //destino atual (ver set_tx_address)
+    uint8_t _plos; //último PLOS_CNT lido (0 após escrita de RF_CH)
+    static void stats_sample(nrf_stats_t *stats, uint16_t sample);
+    void stats_select(const uint8_t *addr, uint8_t length);
+    void stats_written(uint8_t length);
+    void stats_transmitted(uint8_t sent, bool failed);
+    void stats_received(uint8_t pipe, uint8_t length, bool discarded);
+#endif
+    nrf_backend *_bus; //acesso ao hardware
+    bool _owns_bus; //_bus alocado pelo construtor
     uint8_t _irq; //pino de IRQ
+    uint8_t _status; //último STATUS recebido pela interface SPI
+    bool _rx_interrupt; //modo de recepção por interrupção
+    uint8_t _config_masks; //máscaras de CONFIG antes do modo de recepção por interrupção
+    volatile uint8_t _ring_head; //escrito apenas pela interrupção
+    volatile uint8_t _ring_tail; //escrito apenas fora da interrupção
+    volatile uint16_t _ring_overruns;
+    nrf_packet_t _ring[NRF_RX_RING_SIZE];
+    bool _beacon_active;
+    uint16_t _beacon_count; //0: até stop_beacon
+    uint16_t _beacon_remaining;
+    uint32_t _beacon_interval;
+    uint32_t _beacon_last; //micros() do último envio
+    uint8_t _beacon_masks; //MASK_TX_DS de CONFIG antes do beacon
+    void pulse_beacon(void);
+    uint16_t airtime(uint8_t length);
+    uint8_t _async_handles[NRF_TX_WINDOW]; //envios assíncronos no FIFO de TX, em ordem
+    uint8_t _async_count;
+    uint8_t _async_next; //próximo identificador
+    nrf_sent_callback_t _on_sent;
+    nrf_failed_callback_t _on_failed;
+    nrf_received_callback_t _on_received;
+    uint8_t tx_completions(uint8_t in_flight, bool *failed);
+    void poll_async(void);
+    uint8_t _isr_slot; //posição em _isr_instances
+    static nrf *_isr_instances[NRF_MAX_RADIOS];
+    static void (* const isr_table[NRF_MAX_RADIOS])(void);
+    template<uint8_t slot> static void rx_isr(void);
+    void drain_rx_fifo(void);
+    void read_payload(uint8_t *buff, uint8_t length);
     nrf_operation_mode_t _last_mode,_current_mode;
+    uint8_t _shadow[NRF_SHADOW_SIZE]; //cópia dos registradores de configuração
+    uint8_t _address_shadow[3][5]; //cópia de RX_ADDR_P0, RX_ADDR_P1 e TX_ADDR
+    static uint8_t shadow_index(uint8_t register_addr);
+    uint8_t *address_shadow(uint8_t register_addr);
+    uint8_t shadow(uint8_t register_addr);
+    uint32_t _ready_at; //micros() em que o chip estará pronto
+    bool _init_pending; //inicialização aguardando o 'power on reset'
+    uint16_t _power_up_delay, _settle_delay;
+    void init(void);
+    void complete_init(void);
+    void wait_ready(void);
+    void print_hex(uint8_t value);
+    void print_dec(uint32_t value);
+    void print_P(const char *text);
+    uint8_t spi_command(uint8_t command, const uint8_t *tx, uint8_t *rx, uint8_t length);
     uint8_t spi_write_register(uint8_t register_addr, uint8_t data);
 	uint8_t spi_read_register(uint8_t register_addr, uint8_t *data);
-    uint8_t spi_write_multibyte_register(uint8_t register_addr, uint8_t *addr, uint8_t length);
+    uint8_t spi_write_multibyte_register(uint8_t register_addr, const uint8_t *addr, uint8_t length);
     uint8_t spi_read_multibyte_register(uint8_t register_addr, uint8_t *buff, uint8_t length);
     uint8_t get_fifo_status(void);
     uint8_t get_status(void);
+    bool irq_idle(uint8_t mask);
     void set_power_up(bool pwr_up);
     void set_primary_rx(bool prim_rx);
     void flush_rx_fifo(void);
 	void flush_tx_fifo(void);
     void chip_enable(void);
 	void chip_disable(void);
+    void enable_dyn_ack(void);
     
 };
 
+#if NRF_TRACE
+/**
+ * \brief Mede uma chamada de método público (ver \ref NRF_TRACE)
+ * 
+ * Declarada no início do método: o tempo é medido do construtor ao destrutor e as transações
+ * SPI realizadas nesse intervalo são atribuídas ao método. Chamadas aninhadas são atribuídas
+ * ao método mais externo, exceto na rotina de interrupção.
+ * */
+class nrf_trace_scope{
+public:
+    nrf_trace_scope(nrf *radio, nrf_trace_id_t id, bool isr=false);
+    ~nrf_trace_scope();
+private:
+    nrf *_radio;
+    uint8_t _id;
+    uint8_t _previous;
+    uint32_t _start;
+};
+
+#define NRF_TRACE_SCOPE(id)     nrf_trace_scope _trace_scope(this, id)
+#else
+#define NRF_TRACE_SCOPE(id)
+#endif
+
 #endif
@@ -0,0 +1,93 @@
+/**
+ * \file nrf_arduino.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do acesso ao hardware no ambiente Arduino
+ * */
+
+#if defined(ARDUINO)
+
+#include "nrf_arduino.h"
+
+/**
+ * \brief Configura os pinos e a interface SPI
+ * 
+ * \param[in] ce Pino do Arduino atribuído ao 'chip enable' (CE)
+ * \param[in] csn Pino do Arduino atribuído ao 'chip select' (CSN)
+ * \param[in] spi_clock Frequência do clock SPI em Hz (máximo de 10MHz)
+ */
+void nrf_arduino_backend::begin(uint8_t ce, uint8_t csn, uint32_t spi_clock){
+    spi_pin_init(&_ce, ce);
+    spi_begin(&_spi, csn, spi_clock);
+}
+
+void nrf_arduino_backend::transfer(const spi_segment_t *segments, uint8_t count){
+    spi_transfer_segments(&_spi, segments, count);
+}
+
+void nrf_arduino_backend::write_ce(bool high){
+    spi_pin_write(&_ce, high);
+}
+
+bool nrf_arduino_backend::read_ce(void){
+    return spi_pin_is_high(&_ce);
+}
+
+/**
+ * \brief Construtor, sem pino de IRQ
+ */
+nrf_arduino_platform::nrf_arduino_platform(void){
+    _irq = NOT_A_PIN;
+}
+
+bool nrf_arduino_platform::set_irq_pin(uint8_t irq){
+    _irq = irq;
+    pinMode(_irq, INPUT);
+    return true;
+}
+
+bool nrf_arduino_platform::read_irq(void){
+    return digitalRead(_irq) == HIGH;
+}
+
+bool nrf_arduino_platform::attach_irq(void (*isr)(void)){
+    int interrupt = digitalPinToInterrupt(_irq);
+    if(interrupt == NOT_AN_INTERRUPT)
+        return false;
+    spi_using_interrupt(interrupt);
+    attachInterrupt(interrupt, isr, FALLING);
+    return true;
+}
+
+void nrf_arduino_platform::detach_irq(void){
+    detachInterrupt(digitalPinToInterrupt(_irq));
+}
+
+void nrf_arduino_platform::lock(void){
+    noInterrupts();
+}
+
+void nrf_arduino_platform::unlock(void){
+    interrupts();
+}
+
+void nrf_arduino_platform::delay_us(uint32_t us){
+    if(us >= 1000)
+        delay(us / 1000);   // delayMicroseconds é limitado a 16383us
+    delayMicroseconds(us % 1000);
+}
+
+uint32_t nrf_arduino_platform::millis(void){
+    return ::millis();
+}
+
+uint32_t nrf_arduino_platform::micros(void){
+    return ::micros();
+}
+
+void nrf_arduino_platform::print(const char *text){
+    Serial.print(text);
+}
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * \file nrf_arduino.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Acesso ao hardware no ambiente Arduino
+ * */
+
+#ifndef NRF_ARDUINO_H
+#define NRF_ARDUINO_H
+
+#include<Arduino.h>
+#include "nrf_backend.h"
+#include "spidrv.h"
+
+/**
+ * \brief Funções do Arduino comuns aos acessos ao hardware
+ * 
+ * Pino de IRQ, interrupções, tempo e terminal. As transferências SPI e o pino CE são
+ * implementados pelas classes derivadas (\ref nrf_arduino_backend e \ref nrf_fixed_backend).
+ * */
+class nrf_arduino_platform: public nrf_backend{
+public:
+    nrf_arduino_platform(void);
+    
+    virtual bool set_irq_pin(uint8_t irq);
+    virtual bool read_irq(void);
+    virtual bool attach_irq(void (*isr)(void));
+    virtual void detach_irq(void);
+    virtual void lock(void);
+    virtual void unlock(void);
+    virtual void delay_us(uint32_t us);
+    virtual uint32_t millis(void);
+    virtual uint32_t micros(void);
+    virtual void print(const char *text);
+    
+private:
+    uint8_t _irq; //pino de IRQ
+};
+
+/**
+ * \brief Acesso ao hardware no ambiente Arduino
+ * 
+ * Utiliza o driver SPI (spidrv.h) e as funções do Arduino. É a implementação utilizada
+ * pelo construtor nrf::nrf(uint8_t, uint8_t, uint32_t).
+ * */
+class nrf_arduino_backend: public nrf_arduino_platform{
+public:
+    void begin(uint8_t ce, uint8_t csn, uint32_t spi_clock);
+    
+    virtual void transfer(const spi_segment_t *segments, uint8_t count);
+    virtual void write_ce(bool high);
+    virtual bool read_ce(void);
+    
+private:
+    spi_pin_t _ce; //pino de CE
+    spi_device_t _spi; //interface SPI e pino de CSN
+};
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * \file nrf_backend.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Interface de acesso ao hardware (SPI, pinos, tempo)
+ * */
+
+#ifndef NRF_BACKEND_H
+#define NRF_BACKEND_H
+
+#include<stdint.h>
+#include<stddef.h>
+
+/**
+ * \brief Segmento de uma transferência SPI
+ * 
+ * Os bytes de \c tx são enviados e os bytes recebidos são gravados em \c rx. Os ponteiros
+ * podem apontar para o mesmo buffer.
+ * */
+typedef struct{
+    const uint8_t *tx;  ///< Dados enviados. Se NULL, envia 0xFF (NOP).
+    uint8_t *rx;        ///< Dados recebidos. Se NULL, são descartados.
+    uint8_t length;     ///< Tamanho do segmento
+}spi_segment_t;
+
+/**
+ * \brief Interface de acesso ao hardware
+ * 
+ * A classe \ref nrf acessa a interface SPI, os pinos CE e IRQ, as funções de atraso e o
+ * relógio do sistema apenas através desta interface. Implementações disponíveis:
+ * \li \c nrf_arduino_backend (nrf_arduino.h) para o ambiente Arduino;
+ * \li \c nrf_linux_backend (nrf_linux.h) para Linux (spidev e GPIO character device).
+ * */
+class nrf_backend{
+public:
+    virtual ~nrf_backend(){}
+    
+    /**
+     * \brief Transfere vários segmentos numa única seleção do chip (CSN em '0').
+     * 
+     * \param[in] *segments Vetor de segmentos, transferidos em sequência.
+     * \param[in] count Número de segmentos.
+     * */
+    virtual void transfer(const spi_segment_t *segments, uint8_t count) = 0;
+    
+    /** \brief Altera o nível do pino CE */
+    virtual void write_ce(bool high) = 0;
+    
+    /** \brief Retorna o nível escrito no pino CE */
+    virtual bool read_ce(void) = 0;
+    
+    /**
+     * \brief Configura o pino de IRQ
+     * 
+     * \param[in] irq Identificação do pino (número do pino no Arduino, linha do gpiochip no Linux)
+     * \return false se o pino não puder ser configurado
+     * */
+    virtual bool set_irq_pin(uint8_t irq) = 0;
+    
+    /** \brief Retorna o nível do pino de IRQ (ativo em '0') */
+    virtual bool read_irq(void) = 0;
+    
+    /**
+     * \brief Associa uma rotina à borda de descida do pino de IRQ
+     * 
+     * As transferências realizadas fora da rotina não podem ser interrompidas por ela.
+     * 
+     * \return false se a plataforma não suportar interrupções no pino de IRQ
+     * */
+    virtual bool attach_irq(void (*isr)(void)) = 0;
+    
+    /** \brief Remove a rotina associada ao pino de IRQ */
+    virtual void detach_irq(void) = 0;
+    
+    /** \brief Inicia seção crítica (sem execução da rotina do pino de IRQ) */
+    virtual void lock(void) = 0;
+    
+    /** \brief Termina seção crítica */
+    virtual void unlock(void) = 0;
+    
+    /** \brief Aguarda o tempo informado, em microssegundos */
+    virtual void delay_us(uint32_t us) = 0;
+    
+    /** \brief Retorna o tempo decorrido, em milissegundos */
+    virtual uint32_t millis(void) = 0;
+    
+    /** \brief Retorna o tempo decorrido, em microssegundos */
+    virtual uint32_t micros(void) = 0;
+    
+    /** \brief Escreve texto no terminal de depuração */
+    virtual void print(const char *text) = 0;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * \file nrf_bus.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do gerenciador de rádios
+ * */
+
+#include "nrf_bus.h"
+
+/**
+ * \brief Construtor do gerenciador, sem rádios
+ */
+nrf_bus::nrf_bus(void){
+    _count = 0;
+    _next = 0;
+}
+
+/**
+ * \brief Adiciona um rádio ao gerenciador
+ * 
+ * \param[in] *radio Rádio
+ * \return false se o número máximo de rádios (\ref NRF_MAX_RADIOS) foi atingido
+ */
+bool nrf_bus::attach(nrf *radio){
+    if(_count >= NRF_MAX_RADIOS)
+        return false;
+    _radios[_count++] = radio;
+    return true;
+}
+
+/**
+ * \brief Retorna o número de rádios
+ */
+uint8_t nrf_bus::count(void){
+    return _count;
+}
+
+/**
+ * \brief Retorna o rádio, na ordem de \ref attach
+ */
+nrf *nrf_bus::get(uint8_t index){
+    return (index < _count)? _radios[index] : NULL;
+}
+
+/**
+ * \brief Verifica se todos os rádios estão prontos (ver \ref nrf::is_ready)
+ */
+bool nrf_bus::is_ready(void){
+    bool ready = true;
+    for(uint8_t i=0; i<_count; i++){
+        if(!_radios[i]->is_ready())
+            ready = false;  // os demais também concluem a inicialização
+    }
+    return ready;
+}
+
+/**
+ * \brief Atende todos os rádios (ver \ref nrf::poll)
+ * 
+ * Não bloqueia. O primeiro rádio atendido é alternado a cada chamada.
+ */
+void nrf_bus::poll(void){
+    if(_count == 0)
+        return;
+    for(uint8_t i=0; i<_count; i++)
+        _radios[(_next + i) % _count]->poll();
+    _next = (_next + 1) % _count;
+}
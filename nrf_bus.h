@@ -0,0 +1,44 @@
+/**
+ * \file nrf_bus.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Gerenciador de vários rádios no mesmo barramento SPI
+ * */
+
+#ifndef NRF_BUS_H
+#define NRF_BUS_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/**
+ * \brief Gerenciador de vários rádios no mesmo barramento SPI
+ * 
+ * Os rádios compartilham SCK, MOSI e MISO, cada um com seus pinos CE, CSN e IRQ. O acesso ao
+ * barramento é serializado pelas transações SPI: cada rádio aplica seu clock a cada transação e
+ * as interrupções de todos os rádios no modo de recepção por interrupção são mascaradas
+ * durante as transações feitas fora delas (ver \ref spi_using_interrupt).
+ * 
+ * \ref poll atende todos os rádios, alternando o primeiro atendido a cada chamada, de modo que
+ * nenhum rádio com tráfego intenso impeça o atendimento dos demais.
+ * 
+ * Uso típico (gateway 'full-duplex'): um rádio permanece no modo de recepção por interrupção e
+ * outro envia com \ref nrf::send_async , sem trocas de modo (ver exemplos/gateway).
+ * */
+class nrf_bus{
+public:
+    nrf_bus(void);
+    bool attach(nrf *radio);
+    uint8_t count(void);
+    nrf *get(uint8_t index);
+    bool is_ready(void);
+    void poll(void);
+    
+private:
+    nrf *_radios[NRF_MAX_RADIOS];
+    uint8_t _count;
+    uint8_t _next; //primeiro rádio atendido na próxima chamada de poll
+};
+
+#endif
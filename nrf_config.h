@@ -0,0 +1,173 @@
+/**
+ * \file nrf_config.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Parâmetros de compilação da biblioteca
+ * 
+ * Edite este arquivo para ajustar o consumo de memória da biblioteca ao
+ * microcontrolador utilizado.
+ * */
+
+#ifndef NRF_CONFIG_H
+#define NRF_CONFIG_H
+
+/**
+ * \brief Frequência padrão do clock SPI (Hz)
+ * 
+ * O nRF24L01+ suporta até 10MHz. No Arduino Uno, a maior frequência disponível é 8MHz.
+ * */
+#ifndef NRF_SPI_CLOCK
+#define NRF_SPI_CLOCK       8000000UL
+#endif
+
+/**
+ * \brief Número de pacotes armazenados pelo modo de recepção por interrupção
+ * 
+ * Deve ser potência de 2. Cada posição ocupa 34 bytes de RAM.
+ * */
+#ifndef NRF_RX_RING_SIZE
+#define NRF_RX_RING_SIZE    4
+#endif
+
+#if (NRF_RX_RING_SIZE & (NRF_RX_RING_SIZE-1)) || NRF_RX_RING_SIZE > 128
+#error "NRF_RX_RING_SIZE deve ser potencia de 2 e menor ou igual a 128"
+#endif
+
+/**
+ * \brief Número máximo de rádios no modo de recepção por interrupção e em \ref nrf_bus
+ * 
+ * Cada rádio no modo de recepção por interrupção utiliza seu próprio pino de IRQ.
+ * */
+#ifndef NRF_MAX_RADIOS
+#define NRF_MAX_RADIOS      2
+#endif
+
+#if NRF_MAX_RADIOS < 1 || NRF_MAX_RADIOS > 4
+#error "NRF_MAX_RADIOS deve estar entre 1 e 4"
+#endif
+
+/**
+ * \brief Número máximo de nós na tabela de \ref nrf_hub
+ * 
+ * Cada nó ocupa 14 bytes de RAM.
+ * */
+#ifndef NRF_HUB_MAX_NODES
+#define NRF_HUB_MAX_NODES   16
+#endif
+
+#if NRF_HUB_MAX_NODES < 1 || NRF_HUB_MAX_NODES > 64
+#error "NRF_HUB_MAX_NODES deve estar entre 1 e 64"
+#endif
+
+/**
+ * \brief Número de pacotes na fila de cada pipe de \ref nrf_hub
+ * 
+ * Deve ser potência de 2. Cada posição ocupa 34 bytes de RAM, em seis filas.
+ * */
+#ifndef NRF_HUB_QUEUE_SIZE
+#define NRF_HUB_QUEUE_SIZE  2
+#endif
+
+#if (NRF_HUB_QUEUE_SIZE & (NRF_HUB_QUEUE_SIZE-1)) || NRF_HUB_QUEUE_SIZE > 128
+#error "NRF_HUB_QUEUE_SIZE deve ser potencia de 2 e menor ou igual a 128"
+#endif
+
+/**
+ * \brief Número máximo de destinos de \ref nrf_link
+ * 
+ * Cada destino ocupa 31 bytes de RAM.
+ * */
+#ifndef NRF_LINK_MAX_DESTINATIONS
+#define NRF_LINK_MAX_DESTINATIONS   4
+#endif
+
+/**
+ * \brief Duração do 'power on reset' do chip (us)
+ * 
+ * O chip não responde à interface SPI durante esse tempo após a alimentação (ver \ref nrf::is_ready).
+ * */
+#ifndef NRF_POR_DELAY
+#define NRF_POR_DELAY       100000UL
+#endif
+
+/**
+ * \brief Tempo de partida do oscilador, Tpd2stby (us)
+ * 
+ * 1,5ms com cristal de baixa indutância (datasheet). Pode ser alterado em tempo de execução
+ * (ver \ref nrf::set_settle_times).
+ * */
+#ifndef NRF_POWER_UP_DELAY
+#define NRF_POWER_UP_DELAY  1500
+#endif
+
+/**
+ * \brief Tempo de estabilização do PLL, Tstby2a (us)
+ * */
+#ifndef NRF_SETTLE_DELAY
+#define NRF_SETTLE_DELAY    130
+#endif
+
+/**
+ * \brief Tempo mínimo no modo 'rx' para a detecção de portadora pelo registrador RPD (us)
+ * 
+ * Contado após a estabilização do PLL (ver \ref nrf::scan_channels).
+ * */
+#ifndef NRF_RPD_DWELL
+#define NRF_RPD_DWELL       40
+#endif
+
+/**
+ * \brief Tempo máximo entre fragmentos de uma mensagem (ms), ver \ref nrf_transport
+ * 
+ * Mensagens incompletas após esse tempo são descartadas.
+ * */
+#ifndef NRF_TRANSPORT_TIMEOUT
+#define NRF_TRANSPORT_TIMEOUT   100
+#endif
+
+/**
+ * \brief Habilita os contadores de instrumentação (ver \ref nrf::get_trace)
+ * 
+ * Conta as transações SPI, os bytes transferidos e o tempo gasto em cada método público
+ * da classe. Desabilitado por padrão: ocupa 28 bytes de RAM por método e acrescenta
+ * chamadas a micros() em cada transação. Os nomes dos métodos (\ref nrf::print_trace) ficam
+ * na memória flash.
+ * */
+#ifndef NRF_TRACE
+#define NRF_TRACE           0
+#endif
+
+/**
+ * \brief Habilita o mapa de registradores (ver \ref nrf::print_registers)
+ * 
+ * A tabela de descritores (nomes e campos dos registradores) fica na memória flash. Com 0,
+ * as funções de impressão, de imagem e de comparação dos registradores não são compiladas.
+ * */
+#ifndef NRF_REGISTER_MAP
+#define NRF_REGISTER_MAP    1
+#endif
+
+/**
+ * \brief Habilita as estatísticas de enlace (ver \ref nrf::get_pipe_stats)
+ * 
+ * Contadores por pipe de recepção e por destino de transmissão. Desabilitado por padrão: ocupa
+ * 22 bytes de RAM por pipe e 27 bytes por destino (ver \ref NRF_STATS_DESTINATIONS) e acrescenta
+ * leituras de registradores a cada pacote recebido e a cada envio concluído.
+ * */
+#ifndef NRF_STATS
+#define NRF_STATS           0
+#endif
+
+/**
+ * \brief Número máximo de destinos com estatísticas (ver \ref nrf::get_destination_stats)
+ * */
+#ifndef NRF_STATS_DESTINATIONS
+#define NRF_STATS_DESTINATIONS  4
+#endif
+
+#if NRF_STATS_DESTINATIONS < 1 || NRF_STATS_DESTINATIONS > 32
+#error "NRF_STATS_DESTINATIONS deve estar entre 1 e 32"
+#endif
+
+#endif
@@ -0,0 +1,766 @@
+/**
+ * \file nrf_emu.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do emulador do chip nRF24L01+
+ * */
+
+#if !defined(ARDUINO)
+
+#include<stdio.h>
+#include<string.h>
+#include "nrf_emu.h"
+
+#define EMU_NO_TIMER    0xFFFFFFFFFFFFFFFFULL
+#define EMU_SETTLE_NS   130000ULL   // Tstby2a (130us)
+#define EMU_TX_PIPE     0xFF        // entrada do FIFO de TX que não é payload de ACK
+
+/* registradores após o 'power on reset' */
+static const uint8_t reset_values[FEATURE+1] = {
+    0x08, 0x3F, 0x03, 0x03, 0x03, 0x02, 0x0E, 0x0E,     // CONFIG a STATUS
+    0x00, 0x00, 0x00, 0x00, 0xC3, 0xC4, 0xC5, 0xC6,     // OBSERVE_TX a RX_ADDR_P5
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11,     // TX_ADDR a FIFO_STATUS
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00                  // reservados, DYNPD e FEATURE
+};
+
+/* soma de verificação do payload (detecção de pacotes duplicados) */
+static uint16_t checksum(const uint8_t *data, uint8_t length){
+    uint16_t a = 0, b = 0;
+    for(uint8_t i=0; i<length; i++){
+        a = (a + data[i]) % 255;
+        b = (b + a) % 255;
+    }
+    return (b << 8) | a;
+}
+
+/*
+ * nrf_air
+ */
+
+/**
+ * \brief Construtor do meio de transmissão
+ * 
+ * \param[in] seed Semente do gerador pseudoaleatório (perdas de pacotes)
+ */
+nrf_air::nrf_air(uint32_t seed){
+    _count = 0;
+    _now = 0;
+    _advancing = false;
+    _seed = (seed != 0)? seed : 1;
+    memset(_loss, 0, sizeof(_loss));
+    memset(_noise, 0, sizeof(_noise));
+    memset(_history, 0, sizeof(_history));
+    _history_next = 0;
+}
+
+/**
+ * \brief Avança o relógio virtual
+ * 
+ * Os eventos de todos os chips (fim de transmissão, timeout de ACK, etc.) são processados
+ * em ordem cronológica.
+ * 
+ * \param[in] us Tempo em microssegundos
+ */
+void nrf_air::advance(uint32_t us){
+    nrf_air::advance_ns((uint64_t)us * 1000ULL);
+}
+
+/**
+ * \brief Avança o relógio virtual
+ * 
+ * \param[in] ns Tempo em nanossegundos
+ */
+void nrf_air::advance_ns(uint64_t ns){
+    uint64_t target = _now + ns;
+    if(!_advancing){
+        _advancing = true;
+        while(true){
+            nrf_emu *next = NULL;
+            for(uint8_t i=0; i<_count; i++){
+                if(_chips[i]->_timer <= target && (next == NULL || _chips[i]->_timer < next->_timer))
+                    next = _chips[i];
+            }
+            if(next == NULL)
+                break;
+            if(next->_timer > _now)
+                _now = next->_timer;
+            next->_timer = EMU_NO_TIMER;
+            next->on_event();
+        }
+        _advancing = false;
+    }
+    if(target > _now)
+        _now = target;
+    nrf_air::deliver_interrupts();
+}
+
+/**
+ * \brief Retorna o relógio virtual, em nanossegundos
+ */
+uint64_t nrf_air::now_ns(void){
+    return _now;
+}
+
+/**
+ * \brief Configura a taxa de perda de pacotes no canal
+ * 
+ * \param[in] channel Canal de RF (0 a 125)
+ * \param[in] percent Probabilidade de perda de cada pacote (0 a 100)
+ */
+void nrf_air::set_loss(uint8_t channel, uint8_t percent){
+    if(channel < NRF_AIR_CHANNELS)
+        _loss[channel] = percent;
+}
+
+/**
+ * \brief Configura ruído (sinal acima de -64dBm) no canal
+ * 
+ * O ruído é detectado pelo registrador RPD dos chips em recepção no canal.
+ */
+void nrf_air::set_noise(uint8_t channel, bool noise){
+    if(channel < NRF_AIR_CHANNELS)
+        _noise[channel] = noise;
+}
+
+/**
+ * \brief Retorna true se há ruído no canal
+ */
+bool nrf_air::noise(uint8_t channel){
+    return (channel < NRF_AIR_CHANNELS) && _noise[channel];
+}
+
+/**
+ * \brief Gerador pseudoaleatório (xorshift32)
+ */
+uint32_t nrf_air::random(void){
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return _seed;
+}
+
+/**
+ * \brief Adiciona um chip ao meio de transmissão
+ * 
+ * \return false se o número máximo de chips (\c NRF_AIR_MAX_CHIPS) foi atingido
+ */
+bool nrf_air::attach(nrf_emu *chip){
+    if(_count >= NRF_AIR_MAX_CHIPS)
+        return false;
+    _chips[_count++] = chip;
+    return true;
+}
+
+/**
+ * \brief Registra o início de uma transmissão
+ * 
+ * Chips em recepção no mesmo canal detectam a portadora (RPD).
+ */
+void nrf_air::transmit_begin(nrf_emu *from, uint8_t channel, uint64_t end){
+    transmission_t *t = &_history[_history_next];
+    _history_next = (_history_next + 1) % NRF_AIR_HISTORY;
+    t->from = from;
+    t->channel = channel;
+    t->start = _now;
+    t->end = end;
+    for(uint8_t i=0; i<_count; i++){
+        nrf_emu *chip = _chips[i];
+        if(chip != from && chip->_state == nrf_emu::EMU_RX && chip->_reg[RF_CH] == channel)
+            chip->_rpd = true;
+    }
+}
+
+/**
+ * \brief Entrega um pacote aos demais chips
+ * 
+ * O pacote é perdido se outra transmissão no mesmo canal ocorreu simultaneamente, ou de
+ * acordo com a taxa de perdas do canal (ver \ref set_loss).
+ * 
+ * \param[in] *from Chip transmissor
+ * \param[in] *packet Pacote
+ * \param[in] start Início da transmissão
+ */
+void nrf_air::deliver(nrf_emu *from, const nrf_air_packet_t *packet, uint64_t start){
+    for(uint8_t i=0; i<NRF_AIR_HISTORY; i++){
+        transmission_t *t = &_history[i];
+        if(t->from != NULL && t->from != from && t->channel == packet->channel &&
+           t->start < _now && t->end > start)
+            return; // colisão
+    }
+    for(uint8_t i=0; i<_count; i++){
+        nrf_emu *chip = _chips[i];
+        if(chip == from)
+            continue;
+        if(packet->channel < NRF_AIR_CHANNELS && _loss[packet->channel] &&
+           (nrf_air::random() % 100) < _loss[packet->channel])
+            continue;
+        chip->receive(packet);
+    }
+}
+
+/**
+ * \brief Executa as rotinas de interrupção pendentes
+ */
+void nrf_air::deliver_interrupts(void){
+    bool pending = true;
+    while(pending){
+        pending = false;
+        for(uint8_t i=0; i<_count; i++){
+            nrf_emu *chip = _chips[i];
+            if(chip->_isr_pending && chip->_isr != NULL && !chip->_locked && !chip->_in_isr){
+                chip->_isr_pending = false;
+                chip->_in_isr = true;
+                chip->_isr();
+                chip->_in_isr = false;
+                pending = true;
+            }
+        }
+    }
+}
+
+/*
+ * nrf_emu
+ */
+
+/**
+ * \brief Construtor do chip emulado
+ * 
+ * O chip é iniciado no modo 'POWER_DOWN', com os valores de reset dos registradores.
+ * 
+ * \param[in] *air Meio de transmissão
+ * \param[in] spi_clock Frequência do clock SPI (Hz), utilizada no cálculo do tempo das transferências
+ */
+nrf_emu::nrf_emu(nrf_air *air, uint32_t spi_clock){
+    _air = air;
+    memcpy(_reg, reset_values, sizeof(_reg));
+    memset(_addr[0], 0xE7, 5);
+    memset(_addr[1], 0xC2, 5);
+    memset(_addr[2], 0xE7, 5);
+    _flags = 0;
+    _tx_count = 0;
+    _rx_count = 0;
+    _reuse = false;
+    _plos_cnt = 0;
+    _arc_cnt = 0;
+    _rpd = false;
+    _pid = 0;
+    memset(_last_pid, 0xFF, sizeof(_last_pid));
+    memset(_last_crc, 0, sizeof(_last_crc));
+    _ce = false;
+    _state = EMU_POWER_DOWN;
+    _timer = EMU_NO_TIMER;
+    _tx_start = 0;
+    memset(&_packet, 0, sizeof(_packet));
+    _expect_ack = false;
+    _irq_asserted = false;
+    _isr_pending = false;
+    _in_isr = false;
+    _locked = 0;
+    _isr = NULL;
+    _spi_clock = spi_clock;
+    _transaction_ns = 0;
+    _pin_ns = 1000;
+    _power_up_us = 1500;
+    _transactions = 0;
+    air->attach(this);
+}
+
+/**
+ * \brief Configura o tempo gasto no acesso ao hardware
+ * 
+ * \param[in] spi_clock Frequência do clock SPI (Hz)
+ * \param[in] transaction_ns Tempo adicional por transação SPI (seleção do chip, chamadas), em ns
+ * \param[in] pin_ns Tempo de acesso aos pinos CE e IRQ, em ns
+ */
+void nrf_emu::set_timing(uint32_t spi_clock, uint32_t transaction_ns, uint32_t pin_ns){
+    _spi_clock = spi_clock;
+    _transaction_ns = transaction_ns;
+    _pin_ns = pin_ns;
+}
+
+/**
+ * \brief Configura o tempo de partida do oscilador (Tpd2stby), em microssegundos
+ */
+void nrf_emu::set_power_up_delay(uint32_t us){
+    _power_up_us = us;
+}
+
+/**
+ * \brief Retorna o número de transações SPI executadas
+ */
+uint32_t nrf_emu::get_transactions(void){
+    return _transactions;
+}
+
+uint8_t nrf_emu::status(void){
+    uint8_t pipe = (_rx_count > 0)? _rx[0].pipe : 0x07;
+    return _flags | (pipe << 1) | ((_tx_count == 3)? TX_FULL : 0);
+}
+
+uint8_t nrf_emu::fifo_status(void){
+    uint8_t reg = 0;
+    if(_reuse)
+        reg |= TX_REUSE;
+    if(_tx_count == 3)
+        reg |= TX_FIFO_FULL;
+    if(_tx_count == 0)
+        reg |= TX_EMPTY;
+    if(_rx_count == 3)
+        reg |= RX_FULL;
+    if(_rx_count == 0)
+        reg |= RX_EMPTY;
+    return reg;
+}
+
+uint8_t nrf_emu::address_width(void){
+    uint8_t aw = _reg[SETUP_AW] & 0x03;
+    return (aw == 0)? 3 : aw + 2;
+}
+
+uint8_t nrf_emu::crc_bytes(void){
+    if(!(_reg[CONFIG] & EN_CRC) && !_reg[EN_AA])
+        return 0;
+    return (_reg[CONFIG] & CRCO)? 2 : 1;
+}
+
+/* duração da transmissão de um pacote: preâmbulo, endereço, controle (9 bits), payload e CRC */
+uint64_t nrf_emu::airtime(uint8_t length){
+    uint64_t bits = 8ULL * (1 + address_width() + length + crc_bytes()) + 9;
+    uint8_t dr = _reg[RF_SETUP] & (RF_DR_LOW|RF_DR_HIGH);
+    uint64_t bps = (dr & RF_DR_LOW)? 250000ULL : ( (dr & RF_DR_HIGH)? 2000000ULL : 1000000ULL );
+    return bits * 1000000000ULL / bps;
+}
+
+/* endereço completo do pipe de recepção */
+uint8_t *nrf_emu::pipe_address(uint8_t pipe, uint8_t *buff){
+    if(pipe == 0){
+        memcpy(buff, _addr[0], 5);
+    }else{
+        memcpy(buff, _addr[1], 5);
+        if(pipe > 1)
+            buff[0] = _reg[RX_ADDR_P0 + pipe];
+    }
+    return buff;
+}
+
+void nrf_emu::read_register(uint8_t reg, uint8_t *buff, uint8_t length){
+    memset(buff, 0, length);
+    if(length == 0)
+        return;
+    switch(reg){
+        case RX_ADDR_P0:
+        case RX_ADDR_P1:
+        case TX_ADDR:
+            memcpy(buff, _addr[(reg == TX_ADDR)? 2 : reg - RX_ADDR_P0], (length < 5)? length : 5);
+            return;
+        case STATUS:
+            buff[0] = nrf_emu::status();
+            return;
+        case OBSERVE_TX:
+            buff[0] = (_plos_cnt << 4) | _arc_cnt;
+            return;
+        case RPD:
+            buff[0] = _rpd? RPD_MASK : 0;
+            return;
+        case FIFO_STATUS:
+            buff[0] = nrf_emu::fifo_status();
+            return;
+        default:
+            if(reg <= FEATURE)
+                buff[0] = _reg[reg];
+    }
+}
+
+void nrf_emu::write_register(uint8_t reg, const uint8_t *buff, uint8_t length){
+    if(length == 0)
+        return;
+    switch(reg){
+        case RX_ADDR_P0:
+        case RX_ADDR_P1:
+        case TX_ADDR:
+            memcpy(_addr[(reg == TX_ADDR)? 2 : reg - RX_ADDR_P0], buff, (length < 5)? length : 5);
+            return;
+        case STATUS:
+            _flags &= ~(buff[0] & (RX_DR|TX_DS|MAX_RT));
+            return;
+        case OBSERVE_TX:
+        case RPD:
+        case FIFO_STATUS:
+            return;     // somente leitura
+        case RF_CH:
+            _reg[RF_CH] = buff[0] & 0x7F;
+            _plos_cnt = 0;
+            return;
+        default:
+            if(reg <= FEATURE)
+                _reg[reg] = buff[0];
+    }
+}
+
+/* decodifica um comando SPI. out[0] recebe o STATUS anterior ao comando */
+void nrf_emu::execute(const uint8_t *in, uint8_t *out, uint8_t length){
+    uint8_t cmd = in[0];
+    uint8_t n = length - 1;
+    out[0] = nrf_emu::status();
+    memset(out + 1, 0, n);
+
+    if((cmd & 0xE0) == R_REGISTER){
+        nrf_emu::read_register(cmd & 0x1F, out + 1, n);
+    }else if((cmd & 0xE0) == W_REGISTER){
+        nrf_emu::write_register(cmd & 0x1F, in + 1, n);
+    }else if(cmd == R_RX_PAYLOAD){
+        if(_rx_count > 0){
+            memcpy(out + 1, _rx[0].data, (n < _rx[0].length)? n : _rx[0].length);
+            memmove(&_rx[0], &_rx[1], 2 * sizeof(frame_t));
+            _rx_count--;
+        }
+    }else if(cmd == R_RX_PL_WID){
+        if(n > 0 && _rx_count > 0)
+            out[1] = _rx[0].length;
+    }else if(cmd == W_TX_PAYLOAD || cmd == W_TX_PAYLOAD_NOACK || (cmd & 0xF8) == W_ACK_PAYLOAD){
+        bool accepted = true;
+        if(cmd == W_TX_PAYLOAD_NOACK && !(_reg[FEATURE] & EN_DYN_ACK))
+            accepted = false;   // comando ignorado sem EN_DYN_ACK
+        if((cmd & 0xF8) == W_ACK_PAYLOAD && ( (cmd & 0x07) > 5 || !(_reg[FEATURE] & EN_ACK_PAY) ))
+            accepted = false;
+        if(accepted && _tx_count < 3 && n > 0){
+            frame_t *f = &_tx[_tx_count++];
+            f->length = (n > 32)? 32 : n;
+            memcpy(f->data, in + 1, f->length);
+            f->pipe = ((cmd & 0xF8) == W_ACK_PAYLOAD)? (cmd & 0x07) : EMU_TX_PIPE;
+            f->no_ack = (cmd == W_TX_PAYLOAD_NOACK);
+            f->sent = false;
+            _reuse = false;
+        }
+    }else if(cmd == FLUSH_TX){
+        _tx_count = 0;
+        _reuse = false;
+    }else if(cmd == FLUSH_RX){
+        _rx_count = 0;
+    }else if(cmd == REUSE_TX_PL){
+        if(_tx_count > 0)
+            _reuse = true;
+    }
+}
+
+void nrf_emu::transfer(const spi_segment_t *segments, uint8_t count){
+    uint8_t in[64], out[64];
+    uint8_t length = 0;
+    for(uint8_t i=0; i<count; i++){
+        for(uint8_t j=0; j<segments[i].length && length < sizeof(in); j++)
+            in[length++] = (segments[i].tx != NULL)? segments[i].tx[j] : NOP;
+    }
+    if(length == 0)
+        return;
+
+    nrf_emu::execute(in, out, length);
+
+    length = 0;
+    for(uint8_t i=0; i<count; i++){
+        for(uint8_t j=0; j<segments[i].length && length < sizeof(out); j++, length++){
+            if(segments[i].rx != NULL)
+                segments[i].rx[j] = out[length];
+        }
+    }
+    _transactions++;
+    nrf_emu::evaluate();
+    nrf_emu::update_irq();
+    nrf_emu::spend(_transaction_ns + (uint64_t)length * 8ULL * 1000000000ULL / _spi_clock);
+}
+
+void nrf_emu::write_ce(bool high){
+    _ce = high;
+    nrf_emu::evaluate();
+    nrf_emu::spend(_pin_ns);
+}
+
+bool nrf_emu::read_ce(void){
+    nrf_emu::spend(_pin_ns);
+    return _ce;
+}
+
+bool nrf_emu::set_irq_pin(uint8_t irq){
+    (void)irq;
+    return true;
+}
+
+bool nrf_emu::read_irq(void){
+    nrf_emu::spend(_pin_ns);
+    return !_irq_asserted;
+}
+
+bool nrf_emu::attach_irq(void (*isr)(void)){
+    _isr = isr;
+    _isr_pending = false;
+    return true;
+}
+
+void nrf_emu::detach_irq(void){
+    _isr = NULL;
+    _isr_pending = false;
+}
+
+void nrf_emu::lock(void){
+    _locked++;
+}
+
+void nrf_emu::unlock(void){
+    if(_locked > 0 && --_locked == 0)
+        _air->deliver_interrupts();
+}
+
+void nrf_emu::delay_us(uint32_t us){
+    _air->advance(us);
+}
+
+/* a leitura do relógio também consome tempo: laços de espera avançam o relógio virtual */
+uint32_t nrf_emu::millis(void){
+    nrf_emu::spend(_pin_ns);
+    return (uint32_t)(_air->now_ns() / 1000000ULL);
+}
+
+uint32_t nrf_emu::micros(void){
+    nrf_emu::spend(_pin_ns);
+    return (uint32_t)(_air->now_ns() / 1000ULL);
+}
+
+void nrf_emu::print(const char *text){
+    fputs(text, stdout);
+}
+
+/* tempo gasto pelo microcontrolador no acesso ao chip */
+void nrf_emu::spend(uint64_t ns){
+    _air->advance_ns(ns);
+}
+
+/* há payload para transmitir no modo PTX */
+bool nrf_emu::tx_pending(void){
+    return _tx_count > 0 && _tx[0].pipe == EMU_TX_PIPE && !(_flags & MAX_RT);
+}
+
+/* transições a partir dos estados sem temporização (standby, RX e power down) */
+void nrf_emu::evaluate(void){
+    uint64_t now = _air->now_ns();
+    if(!(_reg[CONFIG] & PWR_UP)){
+        _state = EMU_POWER_DOWN;
+        _timer = EMU_NO_TIMER;
+        _rpd = false;
+        return;
+    }
+    switch(_state){
+        case EMU_POWER_DOWN:
+            _state = EMU_POWERING_UP;
+            _timer = now + (uint64_t)_power_up_us * 1000ULL;
+            break;
+        case EMU_STANDBY:
+            if(!_ce)
+                break;
+            if(_reg[CONFIG] & PRIM_RX){
+                _state = EMU_RX_SETTLE;
+                _timer = now + EMU_SETTLE_NS;
+            }else if(nrf_emu::tx_pending()){
+                _state = EMU_TX_SETTLE;
+                _timer = now + EMU_SETTLE_NS;
+            }
+            break;
+        case EMU_RX_SETTLE:
+        case EMU_RX:
+            if(!_ce || !(_reg[CONFIG] & PRIM_RX)){
+                _state = EMU_STANDBY;
+                _timer = EMU_NO_TIMER;
+                _rpd = false;
+                nrf_emu::evaluate();
+            }
+            break;
+        default:
+            break;  // estados temporizados (ver on_event)
+    }
+}
+
+/* fim da temporização do estado atual */
+void nrf_emu::on_event(void){
+    uint64_t now = _air->now_ns();
+    switch(_state){
+        case EMU_POWERING_UP:
+            _state = EMU_STANDBY;
+            nrf_emu::evaluate();
+            break;
+        case EMU_RX_SETTLE:
+            _state = EMU_RX;
+            _rpd = _air->noise(_reg[RF_CH]);
+            break;
+        case EMU_TX_SETTLE:
+            if(nrf_emu::tx_pending()){
+                nrf_emu::start_tx();
+            }else{
+                _state = EMU_STANDBY;
+                nrf_emu::evaluate();
+            }
+            break;
+        case EMU_TX:
+            _air->deliver(this, &_packet, _tx_start);
+            if(_expect_ack){
+                _state = EMU_WAIT_ACK;
+                _timer = now + 250000ULL * (1 + (_reg[SETUP_RETR] >> 4));
+            }else{
+                nrf_emu::tx_success(NULL);
+            }
+            break;
+        case EMU_WAIT_ACK:
+            if(_arc_cnt >= (_reg[SETUP_RETR] & ARC)){
+                _flags |= MAX_RT;
+                if(_plos_cnt < 15)
+                    _plos_cnt++;
+                _state = EMU_STANDBY;
+                nrf_emu::update_irq();
+            }else{
+                _arc_cnt++;
+                nrf_emu::start_tx();
+            }
+            break;
+        case EMU_ACK_SETTLE:
+            _state = EMU_ACK_TX;
+            _tx_start = now;
+            _timer = now + nrf_emu::airtime(_packet.length);
+            _air->transmit_begin(this, _packet.channel, _timer);
+            break;
+        case EMU_ACK_TX:
+            _air->deliver(this, &_packet, _tx_start);
+            _state = EMU_RX;
+            nrf_emu::evaluate();
+            break;
+        default:
+            break;
+    }
+}
+
+/* inicia a transmissão do primeiro payload do FIFO de TX */
+void nrf_emu::start_tx(void){
+    uint64_t now = _air->now_ns();
+    frame_t *f = &_tx[0];
+    if(!f->sent){
+        f->sent = true;
+        _pid = (_pid + 1) & 0x03;
+        _arc_cnt = 0;
+    }
+    _packet.address_width = nrf_emu::address_width();
+    memcpy(_packet.address, _addr[2], 5);
+    _packet.channel = _reg[RF_CH];
+    _packet.datarate = _reg[RF_SETUP] & (RF_DR_LOW|RF_DR_HIGH);
+    _packet.pid = _pid;
+    _packet.no_ack = f->no_ack;
+    _packet.ack = false;
+    _packet.length = f->length;
+    memcpy(_packet.data, f->data, f->length);
+    _expect_ack = !f->no_ack && (_reg[EN_AA] & ENAA_P0);
+
+    _state = EMU_TX;
+    _tx_start = now;
+    _timer = now + nrf_emu::airtime(f->length);
+    _air->transmit_begin(this, _packet.channel, _timer);
+}
+
+/* payload transmitido (e confirmado, se houver auto-ack) */
+void nrf_emu::tx_success(const nrf_air_packet_t *ack){
+    _flags |= TX_DS;
+    if(ack != NULL && ack->length > 0 && _rx_count < 3){
+        frame_t *f = &_rx[_rx_count++];
+        f->length = ack->length;
+        memcpy(f->data, ack->data, ack->length);
+        f->pipe = 0;
+        _flags |= RX_DR;
+    }
+    if(_reuse){
+        _tx[0].sent = false;
+    }else if(_tx_count > 0){
+        memmove(&_tx[0], &_tx[1], 2 * sizeof(frame_t));
+        _tx_count--;
+    }
+    _state = EMU_STANDBY;
+    _timer = EMU_NO_TIMER;
+    nrf_emu::update_irq();
+    nrf_emu::evaluate();
+}
+
+/* pacote recebido do meio de transmissão */
+void nrf_emu::receive(const nrf_air_packet_t *packet){
+    uint8_t aw = nrf_emu::address_width();
+    uint8_t datarate = _reg[RF_SETUP] & (RF_DR_LOW|RF_DR_HIGH);
+    if(packet->channel != _reg[RF_CH] || packet->datarate != datarate || packet->address_width != aw)
+        return;
+
+    if(packet->ack){
+        if(_state == EMU_WAIT_ACK && memcmp(packet->address, _addr[0], aw) == 0)
+            nrf_emu::tx_success(packet);
+        return;
+    }
+    if(_state != EMU_RX)
+        return;
+
+    uint8_t pipe, address[5];
+    for(pipe=0; pipe<6; pipe++){
+        if((_reg[EN_RXADDR] & BIT(pipe)) && memcmp(nrf_emu::pipe_address(pipe, address), packet->address, aw) == 0)
+            break;
+    }
+    if(pipe == 6)
+        return;
+    _rpd = true;
+
+    bool dynamic = (_reg[FEATURE] & EN_DPL) && (_reg[DYNPD] & BIT(pipe));
+    uint8_t length = dynamic? packet->length : _reg[RX_PW_P0 + pipe];
+    if(length == 0 || length > 32 || _rx_count == 3)
+        return; // pacote descartado, sem ACK
+
+    uint16_t crc = checksum(packet->data, packet->length);
+    if(packet->pid != _last_pid[pipe] || crc != _last_crc[pipe]){
+        _last_pid[pipe] = packet->pid;
+        _last_crc[pipe] = crc;
+        frame_t *f = &_rx[_rx_count++];
+        memset(f->data, 0, sizeof(f->data));
+        memcpy(f->data, packet->data, (length < packet->length)? length : packet->length);
+        f->length = length;
+        f->pipe = pipe;
+        _flags |= RX_DR;
+        nrf_emu::update_irq();
+    }
+
+    if(packet->no_ack || !(_reg[EN_AA] & BIT(pipe)))
+        return;
+
+    // ACK enviado com o endereço do pipe, com payload se houver
+    memcpy(_packet.address, address, 5);
+    _packet.address_width = aw;
+    _packet.channel = _reg[RF_CH];
+    _packet.datarate = datarate;
+    _packet.pid = packet->pid;
+    _packet.no_ack = true;
+    _packet.ack = true;
+    _packet.length = 0;
+    if(_reg[FEATURE] & EN_ACK_PAY){
+        for(uint8_t i=0; i<_tx_count; i++){
+            if(_tx[i].pipe == pipe){
+                _packet.length = _tx[i].length;
+                memcpy(_packet.data, _tx[i].data, _tx[i].length);
+                memmove(&_tx[i], &_tx[i+1], (2 - i) * sizeof(frame_t));
+                _tx_count--;
+                _flags |= TX_DS;
+                nrf_emu::update_irq();
+                break;
+            }
+        }
+    }
+    _state = EMU_ACK_SETTLE;
+    _timer = _air->now_ns() + EMU_SETTLE_NS;
+}
+
+/* atualiza o pino de IRQ e registra a borda de descida */
+void nrf_emu::update_irq(void){
+    uint8_t masks = (_reg[CONFIG] & (MASK_RX_DR|MASK_TX_DS|MASK_MAX_RT));
+    bool asserted = (_flags & ~masks & (RX_DR|TX_DS|MAX_RT)) != 0;
+    if(asserted && !_irq_asserted && _isr != NULL)
+        _isr_pending = true;
+    _irq_asserted = asserted;
+}
+
+#endif
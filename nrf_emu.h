@@ -0,0 +1,209 @@
+/**
+ * \file nrf_emu.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Modelo em software do chip nRF24L01+ (emulador)
+ * 
+ * O emulador substitui o hardware (ver \ref nrf_backend) e permite executar a classe
+ * \ref nrf num computador, sem rádio. Vários chips emulados compartilham um meio de
+ * transmissão simulado (\ref nrf_air), com relógio virtual.
+ * 
+ * Exemplo:
+ * \code
+ * nrf_air air;
+ * nrf_emu ptx_chip(&air), prx_chip(&air);
+ * nrf ptx(&ptx_chip), prx(&prx_chip);
+ * ...
+ * ptx.write_tx_payload(buff, length);
+ * ptx.set_mode(NRF_TX_MODE);
+ * ptx.wait_packet_sent();    // o tempo virtual avança com as transferências SPI
+ * \endcode
+ * */
+
+#ifndef NRF_EMU_H
+#define NRF_EMU_H
+
+#if !defined(ARDUINO)
+
+#include<stdint.h>
+#include "nrf_backend.h"
+#include "nordic.h"
+
+/** \brief Número máximo de chips no meio de transmissão */
+#define NRF_AIR_MAX_CHIPS       8
+/** \brief Número de transmissões recentes mantidas para detecção de colisões */
+#define NRF_AIR_HISTORY         16
+/** \brief Número de canais de RF */
+#define NRF_AIR_CHANNELS        126
+
+class nrf_emu;
+
+/**
+ * \brief Pacote no meio de transmissão
+ * */
+typedef struct{
+    uint8_t address[5];     ///< Endereço de destino (LSB primeiro)
+    uint8_t address_width;  ///< Tamanho do endereço
+    uint8_t channel;        ///< Canal de RF
+    uint8_t datarate;       ///< Bits RF_DR_LOW e RF_DR_HIGH do registrador RF_SETUP
+    uint8_t pid;            ///< Identificador do pacote (2 bits)
+    bool no_ack;            ///< Pacote enviado sem pedido de ACK
+    bool ack;               ///< Pacote de ACK
+    uint8_t length;         ///< Tamanho do payload
+    uint8_t data[32];       ///< Payload
+}nrf_air_packet_t;
+
+/**
+ * \brief Meio de transmissão simulado
+ * 
+ * Mantém o relógio virtual (em nanossegundos) e entrega os pacotes transmitidos aos chips
+ * no mesmo canal e com a mesma taxa de dados. Transmissões simultâneas no mesmo canal
+ * colidem e são perdidas. Uma taxa de perdas e ruído (detectado por RPD) podem ser
+ * configurados por canal.
+ * */
+class nrf_air{
+public:
+    nrf_air(uint32_t seed=1);
+    void advance(uint32_t us);
+    void advance_ns(uint64_t ns);
+    uint64_t now_ns(void);
+    void set_loss(uint8_t channel, uint8_t percent);
+    void set_noise(uint8_t channel, bool noise);
+    bool noise(uint8_t channel);
+    uint32_t random(void);
+
+    bool attach(nrf_emu *chip);
+    void transmit_begin(nrf_emu *from, uint8_t channel, uint64_t end);
+    void deliver(nrf_emu *from, const nrf_air_packet_t *packet, uint64_t start);
+    void deliver_interrupts(void);
+
+private:
+    typedef struct{
+        nrf_emu *from;
+        uint8_t channel;
+        uint64_t start;
+        uint64_t end;
+    }transmission_t;
+
+    nrf_emu *_chips[NRF_AIR_MAX_CHIPS];
+    uint8_t _count;
+    uint64_t _now;
+    bool _advancing;
+    uint32_t _seed;
+    uint8_t _loss[NRF_AIR_CHANNELS];
+    bool _noise[NRF_AIR_CHANNELS];
+    transmission_t _history[NRF_AIR_HISTORY];
+    uint8_t _history_next;
+};
+
+/**
+ * \brief Chip nRF24L01+ emulado
+ * 
+ * Decodifica todos os comandos SPI (ver nordic.h), modela os FIFOs de três níveis, os
+ * registradores STATUS, FIFO_STATUS e OBSERVE_TX, a máquina de estados (power down,
+ * standby, RX, TX) e o auto-ack com retransmissão (ARD/ARC), incluindo payloads no ACK,
+ * pacotes sem ACK, REUSE_TX_PL e detecção de pacotes duplicados (PID).
+ * 
+ * As transferências SPI e o acesso aos pinos avançam o relógio virtual de acordo com o
+ * clock SPI configurado. \ref delay_us apenas avança o relógio virtual, de modo que a
+ * execução é muito mais rápida que o tempo real.
+ * */
+class nrf_emu: public nrf_backend{
+public:
+    nrf_emu(nrf_air *air, uint32_t spi_clock=8000000UL);
+    void set_timing(uint32_t spi_clock, uint32_t transaction_ns, uint32_t pin_ns);
+    void set_power_up_delay(uint32_t us);
+    uint32_t get_transactions(void);
+
+    virtual void transfer(const spi_segment_t *segments, uint8_t count);
+    virtual void write_ce(bool high);
+    virtual bool read_ce(void);
+    virtual bool set_irq_pin(uint8_t irq);
+    virtual bool read_irq(void);
+    virtual bool attach_irq(void (*isr)(void));
+    virtual void detach_irq(void);
+    virtual void lock(void);
+    virtual void unlock(void);
+    virtual void delay_us(uint32_t us);
+    virtual uint32_t millis(void);
+    virtual uint32_t micros(void);
+    virtual void print(const char *text);
+
+private:
+    friend class nrf_air;
+
+    typedef enum{
+        EMU_POWER_DOWN,
+        EMU_POWERING_UP,
+        EMU_STANDBY,
+        EMU_RX_SETTLE,
+        EMU_RX,
+        EMU_TX_SETTLE,
+        EMU_TX,
+        EMU_WAIT_ACK,
+        EMU_ACK_SETTLE,
+        EMU_ACK_TX
+    }state_t;
+
+    typedef struct{
+        uint8_t length;
+        uint8_t data[32];
+        uint8_t pipe;       // pipe de recepção ou do payload de ACK
+        bool no_ack;
+        bool sent;          // já transmitido ao menos uma vez
+    }frame_t;
+
+    nrf_air *_air;
+    uint8_t _reg[FEATURE+1];
+    uint8_t _addr[3][5]; // RX_ADDR_P0, RX_ADDR_P1 e TX_ADDR
+    uint8_t _flags; // RX_DR, TX_DS e MAX_RT
+    frame_t _tx[3];
+    uint8_t _tx_count;
+    frame_t _rx[3];
+    uint8_t _rx_count;
+    bool _reuse;
+    uint8_t _plos_cnt, _arc_cnt;
+    bool _rpd;
+    uint8_t _pid;
+    uint8_t _last_pid[6];
+    uint16_t _last_crc[6];
+    bool _ce;
+    state_t _state;
+    uint64_t _timer;
+    uint64_t _tx_start;
+    nrf_air_packet_t _packet; // pacote em transmissão (dados ou ACK)
+    bool _expect_ack;
+    bool _irq_asserted;
+    bool _isr_pending;
+    bool _in_isr;
+    uint8_t _locked;
+    void (*_isr)(void);
+    uint32_t _spi_clock;
+    uint32_t _transaction_ns;
+    uint32_t _pin_ns;
+    uint32_t _power_up_us;
+    uint32_t _transactions;
+
+    uint8_t status(void);
+    uint8_t fifo_status(void);
+    uint8_t address_width(void);
+    uint8_t crc_bytes(void);
+    uint64_t airtime(uint8_t length);
+    uint8_t *pipe_address(uint8_t pipe, uint8_t *buff);
+    void read_register(uint8_t reg, uint8_t *buff, uint8_t length);
+    void write_register(uint8_t reg, const uint8_t *buff, uint8_t length);
+    void execute(const uint8_t *in, uint8_t *out, uint8_t length);
+    bool tx_pending(void);
+    void evaluate(void);
+    void on_event(void);
+    void start_tx(void);
+    void tx_success(const nrf_air_packet_t *ack);
+    void receive(const nrf_air_packet_t *packet);
+    void update_irq(void);
+    void spend(uint64_t ns);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,349 @@
+/**
+ * \file nrf_fixed.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Variante da classe com pinos e configuração definidos em tempo de compilação
+ * 
+ * Apenas cabeçalho; exige C++11 (padrão da IDE do Arduino a partir da versão 1.6.6).
+ * */
+
+#ifndef NRF_FIXED_H
+#define NRF_FIXED_H
+
+#if __cplusplus < 201103L
+#error "nrf_fixed.h exige C++11"
+#endif
+
+#include<Arduino.h>
+#include<SPI.h>
+#include "nrf.h"
+#include "nrf_arduino.h"
+#include "spidrv.h"
+
+/**
+ * \brief Pino de saída resolvido em tempo de compilação
+ * 
+ * No Arduino Uno (ATmega328P), a porta e o bit são constantes: cada escrita é uma única
+ * instrução (sbi/cbi), atômica, sem desabilitar as interrupções. Nas demais plataformas é
+ * utilizado digitalWrite.
+ * */
+template<uint8_t pin> struct nrf_pin{
+#if defined(__AVR_ATmega328P__)
+    static_assert(pin < 20, "pino inexistente no Arduino Uno (0 a 19)");
+
+    static constexpr uint8_t port = (pin < 8)? 'D' : (pin < 14)? 'B' : 'C';   ///< Porta do pino
+    static constexpr uint8_t bit = (pin < 8)? pin : (pin < 14)? pin - 8 : pin - 14;   ///< Bit na porta
+    static constexpr uint8_t mask = 1 << bit;   ///< Máscara do pino na porta
+
+    /** \brief Registrador de saída da porta */
+    static inline volatile uint8_t &out(void){
+        return (port == 'B')? PORTB : (port == 'C')? PORTC : PORTD;
+    }
+
+    /** \brief Registrador de direção da porta */
+    static inline volatile uint8_t &ddr(void){
+        return (port == 'B')? DDRB : (port == 'C')? DDRC : DDRD;
+    }
+
+    /** \brief Configura o pino como saída */
+    static inline void init(void){
+        nrf_pin::ddr() |= mask;
+    }
+
+    /** \brief Altera o nível lógico do pino */
+    static inline void write(bool high){
+        if(high)
+            nrf_pin::out() |= mask;
+        else
+            nrf_pin::out() &= ~mask;
+    }
+
+    /** \brief Retorna o nível lógico escrito no pino */
+    static inline bool is_high(void){
+        return (nrf_pin::out() & mask) != 0;
+    }
+#else
+    static inline void init(void){
+        pinMode(pin, OUTPUT);
+    }
+
+    static inline void write(bool high){
+        digitalWrite(pin, high? HIGH:LOW);
+    }
+
+    static inline bool is_high(void){
+        return digitalRead(pin) == HIGH;
+    }
+#endif
+};
+
+/**
+ * \brief Acesso ao hardware com os pinos CE e CSN e o clock SPI definidos em tempo de compilação
+ * 
+ * Não armazena pinos nem configurações SPI: ocupa apenas a tabela virtual e o pino de IRQ. As
+ * funções de IRQ, tempo e terminal são as do Arduino (ver \ref nrf_arduino_platform).
+ * */
+template<uint8_t ce, uint8_t csn, uint32_t spi_clock> class nrf_fixed_backend: public nrf_arduino_platform{
+    static_assert(ce != csn, "CE e CSN devem ser pinos distintos");
+    static_assert(spi_clock <= SPI_MAX_CLOCK, "o nRF24L01+ suporta clock SPI de ate 10MHz");
+public:
+    /**
+     * \brief Configura os pinos e a interface SPI
+     */
+    void begin(void){
+        nrf_pin<ce>::init();
+        nrf_pin<csn>::init();
+        nrf_pin<csn>::write(true);
+        SPI.begin();
+    }
+
+    virtual void transfer(const spi_segment_t *segments, uint8_t count){
+        SPI.beginTransaction(SPISettings(spi_clock, MSBFIRST, SPI_MODE0));
+        nrf_pin<csn>::write(false);
+        for(; count>0; count--, segments++)
+            spi_shift(segments->tx, segments->rx, segments->length);
+        nrf_pin<csn>::write(true);
+        SPI.endTransaction();
+    }
+
+    virtual void write_ce(bool high){
+        nrf_pin<ce>::write(high);
+    }
+
+    virtual bool read_ce(void){
+        return nrf_pin<ce>::is_high();
+    }
+};
+
+/**
+ * \brief Configuração padrão de \ref nrf_t : valores de reset do chip
+ * 
+ * Para alterar a configuração, derive uma estrutura e redefina apenas os campos desejados:
+ * \code
+ * struct sensor_config: nrf_default_config{
+ *     static constexpr uint8_t channel = 76;
+ *     static constexpr uint8_t payload_width = 0;  // payload dinâmico
+ * };
+ * nrf_t<9, 10, sensor_config> radio;
+ * \endcode
+ * */
+struct nrf_default_config{
+    static constexpr uint32_t spi_clock = NRF_SPI_CLOCK;        ///< Frequência do clock SPI (Hz)
+    static constexpr uint8_t channel = 2;                       ///< Canal de RF (0 a 125)
+    static constexpr nrf_datarate_t datarate = NRF_2MBPS;       ///< Taxa de dados
+    static constexpr nrf_power_t power = NRF_0DBM;              ///< Potência de saída
+    static constexpr nrf_address_width_t address_width = NRF_AW_5BYTES;    ///< Tamanho dos endereços
+    static constexpr nrf_crc_mode_t crc = NRF_CRC_1BYTE;        ///< Tamanho do CRC
+    static constexpr uint8_t retr_count = 3;                    ///< Número de retransmissões (0 a 15)
+    static constexpr uint8_t retr_delay = 0;                    ///< Atraso das retransmissões, 250*(1+retr_delay) us (0 a 15)
+    static constexpr uint8_t irq_masks = 0;                     ///< Interrupções desabilitadas (bits MASK_RX_DR, MASK_TX_DS e MASK_MAX_RT)
+    static constexpr uint8_t features = 0;                      ///< Bits EN_ACK_PAY e EN_DYN_ACK do registrador FEATURE
+    static constexpr uint8_t rx_pipes = 0x03;                   ///< Pipes habilitados (bit 0 para o PIPE0)
+    static constexpr uint8_t auto_ack = 0x3F;                   ///< Pipes com auto-ack
+    static constexpr uint8_t payload_width = 32;                ///< Tamanho estático do payload dos pipes habilitados (1 a 32) ou 0 para payload dinâmico
+};
+
+/**
+ * \brief Valores dos registradores de configuração, calculados em tempo de compilação
+ * 
+ * Segue as regras de \ref nrf::apply_profile : o bit EN_DPL é calculado a partir do payload
+ * dinâmico e de EN_ACK_PAY, que também exige payload dinâmico no PIPE0. Configurações
+ * inválidas resultam em erro de compilação.
+ * */
+template<class config> struct nrf_registers{
+    static_assert(config::channel <= 125, "canal de RF deve estar entre 0 e 125");
+    static_assert(config::address_width >= NRF_AW_3BYTES && config::address_width <= NRF_AW_5BYTES,
+                  "tamanho de endereco invalido");
+    static_assert(config::retr_count <= 15 && config::retr_delay <= 15,
+                  "parametros de retransmissao devem estar entre 0 e 15");
+    static_assert(config::payload_width <= 32, "payload deve ter no maximo 32 bytes");
+    static_assert(config::rx_pipes <= 0x3F && config::auto_ack <= 0x3F, "o chip possui 6 pipes");
+    static_assert(!(config::irq_masks & ~(MASK_RX_DR|MASK_TX_DS|MASK_MAX_RT)), "mascara de interrupcao invalida");
+    static_assert(!(config::features & ~(EN_ACK_PAY|EN_DYN_ACK)), "apenas EN_ACK_PAY e EN_DYN_ACK sao configuraveis");
+
+    static constexpr uint8_t address_length = config::address_width + 2;  ///< Tamanho dos endereços em bytes
+
+    static constexpr uint8_t config_reg = EN_CRC | config::irq_masks |
+                                          ((config::crc == NRF_CRC_2BYTES)? CRCO : 0);  ///< CONFIG, sem PWR_UP e PRIM_RX
+    static constexpr uint8_t en_aa = config::auto_ack & config::rx_pipes;    ///< EN_AA
+    static constexpr uint8_t en_rxaddr = config::rx_pipes;                   ///< EN_RXADDR
+    static constexpr uint8_t setup_aw = config::address_width;               ///< SETUP_AW
+    static constexpr uint8_t setup_retr = (config::retr_delay << 4) | config::retr_count;   ///< SETUP_RETR
+    static constexpr uint8_t rf_ch = config::channel;                        ///< RF_CH
+    static constexpr uint8_t rf_setup = (config::power << 1) |
+                                        ((config::datarate == NRF_250KBPS)? RF_DR_LOW : 0) |
+                                        ((config::datarate == NRF_2MBPS)? RF_DR_HIGH : 0);  ///< RF_SETUP
+    static constexpr uint8_t rx_pw = config::payload_width;                  ///< RX_PW_Px dos pipes habilitados
+    static constexpr uint8_t dynpd = ((config::payload_width == 0)? config::rx_pipes : 0) |
+                                     ((config::features & EN_ACK_PAY)? BIT(0) : 0);   ///< DYNPD
+    static constexpr uint8_t feature = config::features | (dynpd? EN_DPL : 0);       ///< FEATURE
+};
+
+/**
+ * \brief Acesso ao hardware de \ref nrf_t , construído antes da classe base \ref nrf
+ * */
+template<uint8_t ce, uint8_t csn, uint32_t spi_clock> struct nrf_fixed_holder{
+    nrf_fixed_backend<ce, csn, spi_clock> _fixed;
+
+    nrf_fixed_holder(void){
+        _fixed.begin();
+    }
+};
+
+/**
+ * \brief Classe nrf com pinos e configuração definidos em tempo de compilação
+ * 
+ * Os pinos CE e CSN são parâmetros do template (ver \ref nrf_pin) e os registradores de
+ * configuração são constantes calculadas pelo compilador (ver \ref nrf_registers), escritas
+ * por \ref configure sem codificação em tempo de execução. Os endereços, payloads e pipes
+ * informados por vetores de tamanho fixo são verificados em tempo de compilação.
+ * 
+ * O acesso ao hardware (\ref nrf_fixed_backend) é membro da instância e ocupa 3 bytes de RAM no
+ * Arduino Uno, contra 15 bytes do acesso alocado pelo construtor nrf::nrf(uint8_t, uint8_t, uint32_t)
+ * (incluindo o cabeçalho do 'heap'). As transferências SPI continuam passando por uma chamada
+ * virtual, assim como cada escrita no pino CE.
+ * 
+ * Todos os métodos de \ref nrf continuam disponíveis. Os métodos não utilizados pela
+ * aplicação são descartados pelo 'linker'; a RAM do modo de recepção por interrupção é
+ * ajustada por \ref NRF_RX_RING_SIZE .
+ * 
+ * \code
+ * const uint8_t prx_addr[5] = {17, 11, 22, 134, 192};
+ * nrf_t<9, 10> radio;
+ * 
+ * radio.configure();
+ * radio.set_tx_address(prx_addr);
+ * radio.set_rx_address<NRF_PIPE0>(prx_addr);
+ * \endcode
+ * */
+template<uint8_t ce, uint8_t csn, class config = nrf_default_config>
+class nrf_t: private nrf_fixed_holder<ce, csn, config::spi_clock>, public nrf{
+public:
+    typedef nrf_registers<config> registers;    ///< Valores dos registradores de configuração
+
+    /**
+     * \brief Construtor da classe
+     * 
+     * \warning Após a classe ser instanciada, o dispositivo é colocado no modo 'POWER_DOWN'.
+     */
+    nrf_t(void): nrf(&this->_fixed){
+    }
+
+    /**
+     * \brief Aplica a configuração definida em tempo de compilação
+     * 
+     * Escreve apenas os registradores que diferem da cópia local, uma transação SPI por
+     * registrador. Os bits PWR_UP e PRIM_RX (modo de operação) são preservados.
+     * 
+     * \warning Aplique a configuração com o dispositivo no modo 'standby' ou 'power down' e
+     * antes de \ref enable_rx_interrupt .
+     */
+    void configure(void){
+        nrf_t::load(CONFIG, (nrf::shadow(CONFIG) & (PWR_UP|PRIM_RX)) | registers::config_reg);
+        nrf_t::load(EN_AA, registers::en_aa);
+        nrf_t::load(EN_RXADDR, registers::en_rxaddr);
+        nrf_t::load(SETUP_AW, registers::setup_aw);
+        nrf_t::load(SETUP_RETR, registers::setup_retr);
+        nrf_t::load(RF_CH, registers::rf_ch);
+        nrf_t::load(RF_SETUP, registers::rf_setup);
+        if(registers::rx_pw != 0){
+            for(uint8_t pipe=0; pipe<6; pipe++){
+                if(registers::en_rxaddr & BIT(pipe))
+                    nrf_t::load(RX_PW_P0 + pipe, registers::rx_pw);
+            }
+        }
+        nrf_t::load(DYNPD, registers::dynpd);
+        nrf_t::load(FEATURE, registers::feature);
+    }
+
+    using nrf::set_rf_datarate;
+
+    /**
+     * \brief Configura a taxa de dados, com o valor de RF_SETUP calculado em tempo de compilação
+     */
+    template<nrf_datarate_t speed> void set_rf_datarate(void){
+        static_assert(speed <= NRF_2MBPS, "taxa de dados invalida");
+        constexpr uint8_t bits = (speed == NRF_250KBPS)? RF_DR_LOW : (speed == NRF_2MBPS)? RF_DR_HIGH : 0;
+        nrf::spi_write_register(RF_SETUP, (nrf::shadow(RF_SETUP) & ~(RF_DR_LOW|RF_DR_HIGH)) | bits);
+    }
+
+    using nrf::set_rf_channel;
+
+    /**
+     * \brief Configura o canal de RF, verificado em tempo de compilação
+     */
+    template<uint8_t rf_channel> void set_rf_channel(void){
+        static_assert(rf_channel <= 125, "canal de RF deve estar entre 0 e 125");
+        nrf::spi_write_register(RF_CH, rf_channel);
+    }
+
+    using nrf::set_rx_address;
+
+    /**
+     * \brief Configura o endereço de um pipe, com o tamanho verificado em tempo de compilação
+     * 
+     * Os pipes 0 e 1 recebem o endereço completo (\ref nrf_registers::address_length bytes); os
+     * pipes 2 a 5, apenas o byte menos significativo.
+     * 
+     * \param[in] addr Endereço
+     */
+    template<nrf_address_t pipe, uint8_t length> void set_rx_address(const uint8_t (&addr)[length]){
+        static_assert(pipe <= NRF_PIPE5, "o chip possui 6 pipes");
+        static_assert(pipe >= NRF_PIPE2 || length == registers::address_length,
+                      "o tamanho do endereco difere de address_width");
+        static_assert(pipe < NRF_PIPE2 || length == 1, "os pipes 2 a 5 recebem apenas o byte menos significativo");
+        nrf::set_rx_address(pipe, const_cast<uint8_t *>(addr), length);
+    }
+
+    using nrf::set_tx_address;
+
+    /**
+     * \brief Configura o endereço de transmissão, com o tamanho verificado em tempo de compilação
+     * 
+     * \param[in] addr Endereço
+     */
+    template<uint8_t length> void set_tx_address(const uint8_t (&addr)[length]){
+        static_assert(length == registers::address_length, "o tamanho do endereco difere de address_width");
+        nrf::set_tx_address(const_cast<uint8_t *>(addr), length);
+    }
+
+    using nrf::set_static_payload_width;
+
+    /**
+     * \brief Configura o tamanho estático do payload de um pipe, verificado em tempo de compilação
+     */
+    template<nrf_address_t pipe, uint8_t width> void set_static_payload_width(void){
+        static_assert(pipe <= NRF_PIPE5, "o chip possui 6 pipes");
+        static_assert(width >= 1 && width <= 32, "payload deve ter de 1 a 32 bytes");
+        nrf::spi_write_register(RX_PW_P0 + pipe, width);
+    }
+
+    using nrf::write_tx_payload;
+
+    /**
+     * \brief Escreve o payload no buffer de transmissão, com o tamanho verificado em tempo de compilação
+     * 
+     * Com payload estático (\ref nrf_default_config::payload_width diferente de 0), o tamanho
+     * deve ser igual ao configurado.
+     * 
+     * \param[in] buff Payload
+     * \param[in] auto_ack Habilita ou não a função de auto-ack para o pacote
+     * \return false se o FIFO de TX está cheio (ver \ref nrf::write_tx_payload)
+     */
+    template<uint8_t length> bool write_tx_payload(const uint8_t (&buff)[length], bool auto_ack=true){
+        static_assert(length >= 1 && length <= 32, "payload deve ter de 1 a 32 bytes");
+        static_assert(registers::rx_pw == 0 || length == registers::rx_pw,
+                      "o tamanho do payload difere de payload_width");
+        return nrf::write_tx_payload(const_cast<uint8_t *>(buff), length, auto_ack);
+    }
+
+private:
+    /* escreve o registrador se o valor difere da cópia local */
+    void load(uint8_t register_addr, uint8_t value){
+        if(nrf::shadow(register_addr) != value)
+            nrf::spi_write_register(register_addr, value);
+    }
+};
+
+#endif
@@ -0,0 +1,403 @@
+/**
+ * \file nrf_hopper.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do salto de frequência
+ * */
+
+#include<string.h>
+#include "nrf_hopper.h"
+
+/**
+ * \brief Construtor, sem canais (ver \ref begin)
+ * 
+ * \param[in] *radio Rádio
+ */
+nrf_hopper::nrf_hopper(nrf *radio){
+    _radio = radio;
+    _count = 0;
+    _index = 0;
+    _seed = 0;
+    _slot_us = 0;
+    _slot = 0;
+    _slot_start = 0;
+    _beacon_slot = 0;
+    _excluded = 0;
+    _next_excluded = 0;
+    _apply_slot = 0;
+    _pending = 0;
+    _readmit = 1;
+    _slot_sent = 0;
+    _slot_failed = 0;
+    _dead_index = NRF_HOP_NO_INDEX;
+    _beacon_interval = 1;
+    _guard_us = 500;
+    _master = false;
+    _synced = false;
+    _beacon_due = false;
+}
+
+/**
+ * \brief Inicia o salto de frequência
+ * 
+ * O mestre inicia o intervalo 0 e é colocado no modo 'tx'; o seguidor é colocado no modo 'rx'
+ * no canal de encontro, sem aguardar a estabilização (ver \ref nrf::begin_mode).
+ * 
+ * \param[in] *channels Lista de canais (até \ref NRF_HOP_MAX_CHANNELS). O primeiro é o canal
+ * de encontro.
+ * \param[in] count Número de canais
+ * \param[in] seed Semente da sequência
+ * \param[in] slot_us Duração dos intervalos (us)
+ * \param[in] master true no mestre (PTX)
+ */
+void nrf_hopper::begin(const uint8_t *channels, uint8_t count, uint32_t seed, uint32_t slot_us, bool master){
+    if(count > NRF_HOP_MAX_CHANNELS)
+        count = NRF_HOP_MAX_CHANNELS;
+    memcpy(_channels, channels, count);
+    memset(_loss, 0, sizeof(_loss));
+    _count = count;
+    _seed = seed;
+    _slot_us = slot_us;
+    _master = master;
+    _excluded = 0;
+    _next_excluded = 0;
+    _apply_slot = 0;
+    _pending = 0;
+    _readmit = 1;
+    _slot_sent = 0;
+    _slot_failed = 0;
+    _dead_index = NRF_HOP_NO_INDEX;
+    _slot = 0;
+    _beacon_slot = 0;
+    _slot_start = _radio->get_backend()->micros();
+    
+    if(master){
+        _synced = true;
+        _beacon_due = true;
+        _radio->begin_mode(NRF_TX_MODE);
+        nrf_hopper::hop(nrf_hopper::channel_index(0));
+    }else{
+        _synced = false;
+        nrf_hopper::hop(0);
+        _radio->begin_mode(NRF_RX_MODE);
+    }
+}
+
+/**
+ * \brief Configura o intervalo entre 'beacons'
+ * 
+ * \param[in] slots Número de intervalos entre 'beacons' (padrão: 1, um 'beacon' por intervalo)
+ */
+void nrf_hopper::set_beacon_interval(uint8_t slots){
+    _beacon_interval = (slots)? slots : 1;
+}
+
+/**
+ * \brief Configura a margem no início e no fim de cada intervalo (ver \ref can_transmit)
+ * 
+ * Deve cobrir a troca de canal, o 'beacon' e o erro de sincronismo do seguidor, que depende da
+ * frequência das chamadas de \ref poll e \ref read . Padrão: 500us.
+ * 
+ * \param[in] us Margem (us)
+ */
+void nrf_hopper::set_guard(uint16_t us){
+    _guard_us = us;
+}
+
+/**
+ * \brief Troca o canal no início de cada intervalo e envia os 'beacons' (mestre)
+ * 
+ * Não bloqueia, exceto no envio do 'beacon' pelo mestre (uma transmissão sem ACK).
+ * 
+ * \return true se sincronizado
+ */
+bool nrf_hopper::poll(void){
+    if(!_synced || _count == 0)
+        return false;
+    uint32_t now = _radio->get_backend()->micros();
+    if((uint32_t)(now - _slot_start) < _slot_us){
+        // 'beacon' após metade da margem: recebido mesmo com o seguidor ligeiramente atrasado
+        if(_beacon_due && (uint32_t)(now - _slot_start) >= _guard_us / 2){
+            _beacon_due = false;
+            nrf_hopper::send_beacon();
+        }
+        return true;
+    }
+    if(_master)
+        nrf_hopper::account();
+    do{
+        _slot_start += _slot_us;
+        _slot++;
+    }while((uint32_t)(now - _slot_start) >= _slot_us);
+    if((int32_t)(_slot - _apply_slot) >= 0)
+        _excluded = _next_excluded;
+    
+    if(!_master && (uint32_t)(_slot - _beacon_slot) > (uint32_t)NRF_HOP_SYNC_TIMEOUT * _beacon_interval){
+        _synced = false;
+        nrf_hopper::hop(0);     // aguarda o mestre no canal de encontro
+        return false;
+    }
+    nrf_hopper::hop(nrf_hopper::channel_index(_slot));
+    
+    if(_master){
+        if(_slot % NRF_HOP_READMIT == 0 && _pending){
+            // readmite um canal excluído por vez, em rodízio
+            for(uint8_t i=0; i<_count; i++){
+                uint8_t index = (_readmit + i) % _count;
+                if(_pending & (1UL << index)){
+                    _pending &= ~(1UL << index);
+                    _loss[index] = 0;
+                    _readmit = index + 1;
+                    break;
+                }
+            }
+        }
+        if(_excluded == _next_excluded && _pending != _excluded){
+            // anuncia a mudança nos próximos 'beacons'
+            _next_excluded = _pending;
+            _apply_slot = _slot - (_slot % _beacon_interval) + (uint32_t)(NRF_HOP_ANNOUNCE + 1) * _beacon_interval;
+        }
+        _beacon_due = (_slot % _beacon_interval == 0);
+    }
+    return true;
+}
+
+/**
+ * \brief Verifica se há tempo para uma transmissão no intervalo atual
+ * 
+ * \return true se sincronizado, fora das margens do intervalo (ver \ref set_guard) e com o
+ * rádio pronto no canal
+ */
+bool nrf_hopper::can_transmit(void){
+    if(!_synced)
+        return false;
+    uint32_t elapsed = _radio->get_backend()->micros() - _slot_start;
+    if(elapsed < _guard_us || elapsed + _guard_us > _slot_us)
+        return false;
+    return _radio->is_ready();
+}
+
+/**
+ * \brief Lê o próximo pacote recebido, consumindo os 'beacons' (seguidor)
+ * 
+ * \param[out] *buff Payload (mínimo de 32 bytes)
+ * \param[out] *length Tamanho do payload
+ * \param[out] *pipe Pipe de recepção (opcional)
+ * 
+ * \return false se não há pacotes da aplicação
+ * 
+ * \warning Pacotes da aplicação com \ref NRF_HOP_BEACON_SIZE bytes não devem iniciar com
+ * \ref NRF_HOP_BEACON .
+ */
+bool nrf_hopper::read(uint8_t *buff, uint8_t *length, uint8_t *pipe){
+    uint8_t p;
+    while(_radio->read_received_payload(buff, length, &p)){
+        if(*length == NRF_HOP_BEACON_SIZE && buff[0] == NRF_HOP_BEACON){
+            nrf_hopper::receive_beacon(buff);
+            continue;
+        }
+        if(pipe != NULL)
+            *pipe = p;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * \brief Informa o resultado de um envio no intervalo atual (mestre)
+ * 
+ * A taxa de perdas do canal é atualizada ao fim do intervalo. Um intervalo sem confirmações
+ * é atribuído ao canal apenas se o intervalo seguinte tiver confirmações; caso contrário, o
+ * receptor está fora de sincronismo ou de alcance e os intervalos são desconsiderados.
+ * 
+ * Um canal acima de \ref NRF_HOP_LOSS_EXCLUDE e do dobro da média é excluído após o anúncio
+ * nos 'beacons', mantendo \ref NRF_HOP_MIN_CHANNELS canais. Os canais excluídos são
+ * readmitidos um a um a cada \ref NRF_HOP_READMIT intervalos.
+ * 
+ * \param[in] delivered Pacote confirmado
+ */
+void nrf_hopper::report(bool delivered){
+    if(!_master || _slot_sent == 0xFF)
+        return;
+    _slot_sent++;
+    if(!delivered)
+        _slot_failed++;
+}
+
+/**
+ * \brief Retorna true se sincronizado (sempre, no mestre)
+ */
+bool nrf_hopper::is_synced(void){
+    return _synced;
+}
+
+/**
+ * \brief Retorna o número do intervalo atual
+ */
+uint32_t nrf_hopper::get_slot(void){
+    return _slot;
+}
+
+/**
+ * \brief Retorna o canal de RF atual
+ */
+uint8_t nrf_hopper::get_channel(void){
+    return _channels[_index];
+}
+
+/**
+ * \brief Retorna os canais excluídos no intervalo atual (bit n: n-ésimo canal da lista)
+ */
+uint32_t nrf_hopper::get_excluded(void){
+    return _excluded;
+}
+
+/**
+ * \brief Retorna a taxa de perdas de um canal da lista (escala 256, mestre)
+ */
+uint8_t nrf_hopper::get_loss(uint8_t index){
+    return (index < _count)? _loss[index] : 0;
+}
+
+/**
+ * \brief Canal do intervalo na lista, entre os canais não excluídos
+ */
+uint8_t nrf_hopper::channel_index(uint32_t slot){
+    uint32_t x = _seed ^ (slot * 0x9E3779B9UL);
+    if(x == 0)
+        x = 1;
+    for(uint8_t i=0; i<2; i++){
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    
+    uint8_t active = 0;
+    for(uint8_t i=0; i<_count; i++){
+        if(!(_excluded & (1UL << i)))
+            active++;
+    }
+    uint8_t k = x % active;
+    for(uint8_t i=0; i<_count; i++){
+        if(_excluded & (1UL << i))
+            continue;
+        if(k == 0)
+            return i;
+        k--;
+    }
+    return 0;
+}
+
+/**
+ * \brief Avalia as perdas do intervalo encerrado (mestre)
+ */
+void nrf_hopper::account(void){
+    if(_slot_sent){
+        if(_slot_failed < _slot_sent){
+            if(_dead_index < _count)
+                nrf_hopper::update_loss(_dead_index, 255);
+            nrf_hopper::update_loss(_index, (uint16_t)255 * _slot_failed / _slot_sent);
+            _dead_index = NRF_HOP_NO_INDEX;
+        }else{
+            // dois intervalos seguidos sem confirmações: desconsiderados até uma confirmação
+            _dead_index = (_dead_index == NRF_HOP_NO_INDEX)? _index : NRF_HOP_NO_LINK;
+        }
+    }
+    _slot_sent = 0;
+    _slot_failed = 0;
+}
+
+/**
+ * \brief Atualiza a taxa de perdas do canal e o exclui se necessário (mestre)
+ */
+void nrf_hopper::update_loss(uint8_t index, uint8_t loss){
+    _loss[index] += ((int16_t)loss - (int16_t)_loss[index]) / NRF_HOP_LOSS_WEIGHT;
+    if(index == 0 || (_pending & (1UL << index)) || _loss[index] <= NRF_HOP_LOSS_EXCLUDE)
+        return;
+    
+    // perdas semelhantes em todos os canais não excluem canais
+    uint8_t active = 0;
+    uint16_t total = 0;
+    for(uint8_t i=0; i<_count; i++){
+        if(!(_pending & (1UL << i))){
+            active++;
+            total += _loss[i];
+        }
+    }
+    if(active > NRF_HOP_MIN_CHANNELS && (uint16_t)_loss[index] * active > 2 * total)
+        _pending |= 1UL << index;
+}
+
+/**
+ * \brief Envia o 'beacon' do intervalo atual (mestre)
+ */
+void nrf_hopper::send_beacon(void){
+    uint8_t beacon[NRF_HOP_BEACON_SIZE];
+    uint32_t offset = _radio->get_backend()->micros() - _slot_start;
+    if(offset > 0xFFFF)
+        offset = 0xFFFF;
+    beacon[0] = NRF_HOP_BEACON;
+    beacon[5] = offset;
+    beacon[6] = offset >> 8;
+    for(uint8_t i=0; i<4; i++){
+        beacon[1 + i] = _slot >> (8 * i);
+        beacon[7 + i] = _excluded >> (8 * i);
+        beacon[11 + i] = _next_excluded >> (8 * i);
+        beacon[15 + i] = _apply_slot >> (8 * i);
+    }
+    
+    if(!_radio->write_tx_payload(beacon, sizeof(beacon), false))
+        return;
+    _radio->wait_packet_sent();
+    _beacon_slot = _slot;
+}
+
+/**
+ * \brief Sincroniza o relógio dos intervalos e os canais excluídos pelo 'beacon' (seguidor)
+ * 
+ * O início do intervalo é estimado pelo instante da leitura, descontados o atraso no mestre,
+ * a estabilização do PLL e a duração da transmissão.
+ */
+void nrf_hopper::receive_beacon(const uint8_t *buff){
+    if(_master)
+        return;
+    uint32_t now = _radio->get_backend()->micros();
+    uint32_t fields[4] = {0, 0, 0, 0};  // intervalo, excluídos, próximos excluídos, intervalo da mudança
+    for(uint8_t i=0; i<4; i++){
+        fields[0] |= (uint32_t)buff[1 + i] << (8 * i);
+        fields[1] |= (uint32_t)buff[7 + i] << (8 * i);
+        fields[2] |= (uint32_t)buff[11 + i] << (8 * i);
+        fields[3] |= (uint32_t)buff[15 + i] << (8 * i);
+    }
+    uint16_t offset = buff[5] | ((uint16_t)buff[6] << 8);
+    
+    uint16_t bits = 8 * (1 + _radio->get_address_width() + NRF_HOP_BEACON_SIZE + _radio->get_crc_mode()) + 9;
+    uint8_t rate = _radio->get_rf_datarate();
+    uint16_t airtime = (rate == NRF_2MBPS)? bits / 2 : (rate == NRF_1MBPS)? bits : bits * 4;
+    
+    // o atraso da leitura apenas atrasa a estimativa: estimativas anteriores à previsão são
+    // aceitas, as posteriores corrigem apenas a deriva dos relógios
+    uint32_t start = now - offset - NRF_SETTLE_DELAY - airtime;
+    if(_synced){
+        uint32_t predicted = _slot_start + (int32_t)(fields[0] - _slot) * (int32_t)_slot_us;
+        int32_t late = (int32_t)(start - predicted);
+        if(late > 0)
+            start = predicted + late / 8;
+    }
+    _slot = fields[0];
+    _slot_start = start;
+    _beacon_slot = fields[0];
+    _excluded = fields[1] & ~1UL;   // canal de encontro nunca excluído
+    _next_excluded = fields[2] & ~1UL;
+    _apply_slot = fields[3];
+    _synced = true;
+}
+
+/**
+ * \brief Troca para o canal da lista
+ */
+void nrf_hopper::hop(uint8_t index){
+    _index = index;
+    _radio->switch_channel(_channels[index]);
+}
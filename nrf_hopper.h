@@ -0,0 +1,129 @@
+/**
+ * \file nrf_hopper.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Salto de frequência sincronizado
+ * 
+ * O tempo é dividido em intervalos ('slots') de duração fixa. Em cada intervalo, os rádios
+ * utilizam um canal de uma lista, escolhido por uma sequência pseudoaleatória (xorshift) do
+ * número do intervalo e de uma semente comum. A troca de canal, no início de cada intervalo,
+ * é uma escrita de RF_CH (ver \ref nrf::switch_channel).
+ * 
+ * O transmissor (PTX) é o mestre: mantém o relógio dos intervalos, envia um 'beacon' sem ACK
+ * após metade da margem inicial (ver \ref nrf_hopper::set_guard) dos intervalos de sincronização (ver \ref nrf_hopper::set_beacon_interval) e exclui
+ * da sequência os canais com perdas frequentes (ver \ref nrf_hopper::report). O 'beacon'
+ * contém o número do intervalo, o instante do envio, os canais excluídos no intervalo e a
+ * próxima lista de canais excluídos, anunciada em \ref NRF_HOP_ANNOUNCE 'beacons' antes de
+ * valer:
+ * 
+ * \li [\ref NRF_HOP_BEACON, intervalo (4 bytes), atraso no intervalo em us (2 bytes),
+ * canais excluídos (4 bytes), próximos canais excluídos (4 bytes), intervalo em que passam a
+ * valer (4 bytes)], LSB primeiro
+ * 
+ * O receptor (PRX) é o seguidor: sem sincronismo, permanece no primeiro canal da lista (canal
+ * de encontro, nunca excluído) até receber um 'beacon', e volta a ele após
+ * \ref NRF_HOP_SYNC_TIMEOUT intervalos de sincronização sem 'beacons'.
+ * 
+ * Os dois lados devem utilizar a mesma lista de canais, semente, duração dos intervalos e
+ * intervalo entre 'beacons'.
+ * */
+
+#ifndef NRF_HOPPER_H
+#define NRF_HOPPER_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/** \brief Número máximo de canais na lista */
+#define NRF_HOP_MAX_CHANNELS    32
+/** \brief Nenhum canal (índice na lista) */
+#define NRF_HOP_NO_INDEX        0xFF
+/** \brief Receptor sem confirmações em dois intervalos seguidos */
+#define NRF_HOP_NO_LINK         0xFE
+/** \brief Primeiro byte do 'beacon' */
+#define NRF_HOP_BEACON          0xB7
+/** \brief Tamanho do 'beacon' */
+#define NRF_HOP_BEACON_SIZE     19
+/** \brief 'Beacons' que anunciam uma mudança dos canais excluídos antes de ela valer */
+#define NRF_HOP_ANNOUNCE        4
+/** \brief Intervalos de sincronização sem 'beacon' até a perda do sincronismo */
+#define NRF_HOP_SYNC_TIMEOUT    8
+/** \brief Taxa de perdas de um canal (escala 256) acima da qual ele é excluído, se também
+ * superior ao dobro da média dos canais */
+#define NRF_HOP_LOSS_EXCLUDE    64
+/** \brief Menor número de canais na sequência */
+#define NRF_HOP_MIN_CHANNELS    3
+/** \brief Peso de cada intervalo na taxa de perdas de um canal: 1/NRF_HOP_LOSS_WEIGHT */
+#define NRF_HOP_LOSS_WEIGHT     4
+/** \brief Intervalos entre as readmissões de canais excluídos */
+#define NRF_HOP_READMIT         1024
+
+/**
+ * \brief Salto de frequência sincronizado (ver nrf_hopper.h)
+ * 
+ * Exemplo (mestre):
+ * \code
+ * const uint8_t channels[] = {2, 14, 26, 40, 52, 64, 76, 90};
+ * nrf_hopper hopper(&radio);
+ * hopper.begin(channels, 8, 0x5EED, 10000, true);   // intervalos de 10ms
+ * ...
+ * hopper.poll();
+ * if(hopper.can_transmit()){
+ *     radio.write_tx_payload(buff, length);
+ *     hopper.report(radio.wait_packet_sent());
+ * }
+ * \endcode
+ * 
+ * O seguidor lê os pacotes com \ref read, que consome os 'beacons'. \ref poll deve ser chamada
+ * com frequência: a troca de canal e a medida do instante de chegada dos 'beacons' ocorrem
+ * nas chamadas.
+ * */
+class nrf_hopper{
+public:
+    nrf_hopper(nrf *radio);
+    void begin(const uint8_t *channels, uint8_t count, uint32_t seed, uint32_t slot_us, bool master);
+    void set_beacon_interval(uint8_t slots);
+    void set_guard(uint16_t us);
+    bool poll(void);
+    bool can_transmit(void);
+    bool read(uint8_t *buff, uint8_t *length, uint8_t *pipe=NULL);
+    void report(bool delivered);
+    bool is_synced(void);
+    uint32_t get_slot(void);
+    uint8_t get_channel(void);
+    uint32_t get_excluded(void);
+    uint8_t get_loss(uint8_t index);
+    
+private:
+    nrf *_radio;
+    uint8_t _channels[NRF_HOP_MAX_CHANNELS];
+    uint8_t _loss[NRF_HOP_MAX_CHANNELS]; //taxa de perdas por canal (escala 256)
+    uint8_t _count;
+    uint8_t _index; //canal atual, na lista
+    uint32_t _seed;
+    uint32_t _slot_us;
+    uint32_t _slot;
+    uint32_t _slot_start; //micros() do início do intervalo atual
+    uint32_t _beacon_slot; //último 'beacon' enviado ou recebido
+    uint32_t _excluded; //canais excluídos no intervalo atual
+    uint32_t _next_excluded; //a partir de _apply_slot
+    uint32_t _apply_slot;
+    uint32_t _pending; //próxima mudança (mestre)
+    uint8_t _readmit; //próximo canal readmitido (mestre)
+    uint8_t _slot_sent, _slot_failed; //envios no intervalo atual (mestre)
+    uint8_t _dead_index; //canal do último intervalo sem confirmações
+    uint8_t _beacon_interval;
+    uint16_t _guard_us;
+    bool _master;
+    bool _synced;
+    bool _beacon_due; //'beacon' do intervalo ainda não enviado (mestre)
+    uint8_t channel_index(uint32_t slot);
+    void account(void);
+    void update_loss(uint8_t index, uint8_t loss);
+    void send_beacon(void);
+    void receive_beacon(const uint8_t *buff);
+    void hop(uint8_t index);
+};
+
+#endif
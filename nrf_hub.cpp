@@ -0,0 +1,472 @@
+/**
+ * \file nrf_hub.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do concentrador
+ * */
+
+#include<string.h>
+#include "nrf_hub.h"
+
+/**
+ * \brief Construtor do concentrador, com a tabela de nós vazia
+ * 
+ * \param[in] *radio Rádio do concentrador (ver \ref begin)
+ */
+nrf_hub::nrf_hub(nrf *radio){
+    _radio = radio;
+    memset(_base, 0, sizeof(_base));
+    memset(_nodes, 0, sizeof(_nodes));
+    for(uint8_t i=0; i<6; i++){
+        _pipes[i].node = NRF_HUB_NO_NODE;
+        _pipes[i].received = 0;
+        _pipes[i].dropped = 0;
+        _pipes[i].rotations = 0;
+        _mapped_seq[i] = 0;
+        _head[i] = 0;
+        _tail[i] = 0;
+    }
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++)
+        _nodes[i].pipe = NRF_HUB_NO_PIPE;
+    _seq = 0;
+    _batch_seq = 0;
+    _updating = false;
+    _next_pipe = 0;
+    _next_node = 0;
+    _slot_ms = 0;
+    _slot_start = 0;
+    _rejected = 0;
+}
+
+/**
+ * \brief Configura o rádio como concentrador e o coloca no modo de recepção
+ * 
+ * Utiliza endereços de 5 bytes, payload dinâmico e payloads no ACK em todos os pipes. O pipe 0
+ * recebe as mensagens de controle no endereço de entrada; os pipes 1 a 5 permanecem
+ * desabilitados até a atribuição de um nó. Os demais parâmetros (canal, taxa de dados) devem
+ * ser configurados antes.
+ * 
+ * \param[in] *base Endereço base (5 bytes, LSB primeiro). O primeiro byte é substituído pelo
+ * LSB de cada nó.
+ * \param[in] *join_address Endereço de entrada (5 bytes)
+ * 
+ * \warning O modo de recepção é iniciado sem aguardar a estabilização (ver \ref nrf::begin_mode).
+ */
+void nrf_hub::begin(const uint8_t *base, const uint8_t *join_address){
+    memcpy(_base, base, 5);
+    _radio->begin_mode(NRF_STANDBY);
+    _updating = true;
+    _radio->set_address_width(NRF_AW_5BYTES);
+    _radio->set_rx_address(NRF_PIPE0, (uint8_t*)join_address, 5);
+    _radio->set_rx_address(NRF_PIPE1, _base, 5);     // bytes superiores dos pipes 2 a 5
+    _radio->enable_rx_pipe(NRF_PIPE0, true);
+    for(uint8_t pipe=1; pipe<6; pipe++){
+        _radio->disable_rx_pipe((nrf_address_t)pipe);
+        if(_pipes[pipe].node != NRF_HUB_NO_NODE){
+            _nodes[_pipes[pipe].node].pipe = NRF_HUB_NO_PIPE;
+            _pipes[pipe].node = NRF_HUB_NO_NODE;
+        }
+    }
+    for(uint8_t pipe=0; pipe<6; pipe++)
+        _radio->set_dynamic_payload((nrf_address_t)pipe, true);
+    _radio->enable_ack_payload(true);
+    _radio->flush_ack_payloads();
+    
+    _batch_seq = _seq + 1;
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(_nodes[i].uid && !nrf_hub::place(i))
+            break;
+    }
+    _slot_start = _radio->get_backend()->millis();
+    nrf_hub::end_update();
+}
+
+/**
+ * \brief Configura a troca periódica dos nós nos pipes
+ * 
+ * A cada intervalo, os cinco pipes recebem os próximos nós da tabela. Sem efeito com até cinco
+ * nós.
+ * 
+ * \param[in] slot_ms Intervalo entre as trocas (ms), ou 0 para trocas apenas sob demanda
+ */
+void nrf_hub::set_schedule(uint16_t slot_ms){
+    _slot_ms = slot_ms;
+    _slot_start = _radio->get_backend()->millis();
+}
+
+/**
+ * \brief Adiciona um nó à tabela
+ * 
+ * O nó recebe um pipe imediatamente se houver um pipe livre.
+ * 
+ * \param[in] uid Identificador do nó (diferente de 0)
+ * 
+ * \return Índice do nó (ver \ref get_address), ou -1 com a tabela cheia
+ */
+int16_t nrf_hub::add(uint32_t uid){
+    if(uid == 0)
+        return -1;
+    int16_t node = nrf_hub::find(uid);
+    if(node >= 0)
+        return node;
+    
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(_nodes[i].uid)
+            continue;
+        memset(&_nodes[i], 0, sizeof(nrf_hub_node_t));
+        _nodes[i].uid = uid;
+        _nodes[i].pipe = NRF_HUB_NO_PIPE;
+        for(uint8_t pipe=1; pipe<6; pipe++){
+            if(_pipes[pipe].node == NRF_HUB_NO_NODE)
+                _nodes[i].pending = true;
+        }
+        return i;
+    }
+    return -1;
+}
+
+/**
+ * \brief Remove um nó da tabela e libera o seu pipe
+ */
+void nrf_hub::remove(uint8_t node){
+    if(node >= NRF_HUB_MAX_NODES || !_nodes[node].uid)
+        return;
+    if(_nodes[node].pipe != NRF_HUB_NO_PIPE){
+        nrf_hub::begin_update();
+        nrf_hub::map(_nodes[node].pipe, NRF_HUB_NO_NODE);
+        nrf_hub::end_update();
+    }
+    _nodes[node].uid = 0;
+    _nodes[node].pending = false;
+}
+
+/**
+ * \brief Procura um nó pelo identificador
+ * 
+ * \return Índice do nó, ou -1 se não encontrado
+ */
+int16_t nrf_hub::find(uint32_t uid){
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(uid && _nodes[i].uid == uid)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * \brief Retorna o número de nós na tabela
+ */
+uint8_t nrf_hub::count(void){
+    uint8_t n = 0;
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(_nodes[i].uid)
+            n++;
+    }
+    return n;
+}
+
+/**
+ * \brief Retorna o endereço de um nó
+ * 
+ * \param[in] node Índice do nó
+ * \param[out] *addr Endereço (5 bytes, LSB primeiro)
+ */
+void nrf_hub::get_address(uint8_t node, uint8_t *addr){
+    memcpy(addr, _base, 5);
+    addr[0] = NRF_HUB_FIRST_LSB + node;
+}
+
+/**
+ * \brief Atribui um pipe ao nó imediatamente
+ * 
+ * Sem pipes livres, o nó substitui o nó há mais tempo em um pipe.
+ * 
+ * \param[in] node Índice do nó
+ * 
+ * \return true se o nó está em um pipe
+ */
+bool nrf_hub::activate(uint8_t node){
+    if(node >= NRF_HUB_MAX_NODES || !_nodes[node].uid)
+        return false;
+    if(_nodes[node].pipe != NRF_HUB_NO_PIPE)
+        return true;
+    _batch_seq = _seq + 1;
+    bool placed = nrf_hub::place(node);
+    nrf_hub::end_update();
+    return placed;
+}
+
+/**
+ * \brief Atende o concentrador
+ * 
+ * Não bloqueia. Lê os pacotes recebidos para as filas dos pipes, responde às mensagens de
+ * controle e troca os nós dos pipes conforme o intervalo configurado e os pedidos pendentes.
+ */
+void nrf_hub::poll(void){
+    uint8_t buff[32], length, pipe;
+    if(!_radio->is_ready())
+        return;
+    while(_radio->read_received_payload(buff, &length, &pipe))
+        nrf_hub::receive(buff, length, pipe);
+    
+    _batch_seq = _seq + 1;
+    uint32_t now = _radio->get_backend()->millis();
+    if(_slot_ms && (uint32_t)(now - _slot_start) >= _slot_ms){
+        _slot_start = now;
+        nrf_hub::rotate();
+    }
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(_nodes[i].uid && _nodes[i].pending && !nrf_hub::place(i))
+            break;  // demais pedidos na próxima chamada
+    }
+    nrf_hub::end_update();
+}
+
+/**
+ * \brief Lê o próximo pacote das filas, alternando entre os pipes
+ * 
+ * \param[out] *buff Payload (mínimo de 32 bytes)
+ * \param[out] *length Tamanho do payload
+ * \param[out] *node Nó de origem (\ref NRF_HUB_NO_NODE para mensagens desconhecidas no pipe 0)
+ * 
+ * \return false se todas as filas estão vazias
+ */
+bool nrf_hub::read(uint8_t *buff, uint8_t *length, uint8_t *node){
+    for(uint8_t i=0; i<6; i++){
+        uint8_t pipe = (_next_pipe + i) % 6;
+        if(nrf_hub::read_pipe(pipe, buff, length, node)){
+            _next_pipe = (pipe + 1) % 6;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Lê o próximo pacote da fila de um pipe
+ * 
+ * \param[in] pipe Pipe (0 a 5)
+ * \param[out] *buff Payload (mínimo de 32 bytes)
+ * \param[out] *length Tamanho do payload
+ * \param[out] *node Nó de origem
+ * 
+ * \return false se a fila está vazia
+ */
+bool nrf_hub::read_pipe(uint8_t pipe, uint8_t *buff, uint8_t *length, uint8_t *node){
+    if(pipe > 5 || _head[pipe] == _tail[pipe])
+        return false;
+    nrf_hub_packet_t *packet = &_queue[pipe][_tail[pipe] & (NRF_HUB_QUEUE_SIZE-1)];
+    *length = packet->length;
+    memcpy(buff, packet->data, packet->length);
+    if(node != NULL)
+        *node = packet->node;
+    _tail[pipe]++;
+    return true;
+}
+
+/**
+ * \brief Retorna o estado e as estatísticas de um nó, ou NULL para uma posição livre
+ */
+const nrf_hub_node_t *nrf_hub::get_node(uint8_t node){
+    if(node >= NRF_HUB_MAX_NODES || !_nodes[node].uid)
+        return NULL;
+    return &_nodes[node];
+}
+
+/**
+ * \brief Retorna o estado e as estatísticas de um pipe (0 a 5)
+ */
+const nrf_hub_pipe_t *nrf_hub::get_pipe(uint8_t pipe){
+    return (pipe < 6)? &_pipes[pipe] : NULL;
+}
+
+/**
+ * \brief Retorna o número de mensagens \ref NRF_HUB_JOIN recusadas com a tabela cheia
+ */
+uint16_t nrf_hub::get_rejected(void){
+    return _rejected;
+}
+
+/**
+ * \brief Coloca um pacote recebido na fila do pipe
+ */
+void nrf_hub::receive(const uint8_t *buff, uint8_t length, uint8_t pipe){
+    uint8_t node = NRF_HUB_NO_NODE;
+    if(pipe == 0){
+        if(nrf_hub::control(buff, length))
+            return;
+    }else if(pipe < 6){
+        node = _pipes[pipe].node;
+    }else{
+        return;
+    }
+    
+    _pipes[pipe].received++;
+    if(node != NRF_HUB_NO_NODE){
+        _nodes[node].received++;
+        _nodes[node].last_seen = _radio->get_backend()->millis();
+    }
+    
+    if((uint8_t)(_head[pipe] - _tail[pipe]) >= NRF_HUB_QUEUE_SIZE){
+        _pipes[pipe].dropped++;
+        if(node != NRF_HUB_NO_NODE)
+            _nodes[node].dropped++;
+        return;
+    }
+    nrf_hub_packet_t *packet = &_queue[pipe][_head[pipe] & (NRF_HUB_QUEUE_SIZE-1)];
+    packet->node = node;
+    packet->length = length;
+    memcpy(packet->data, buff, length);
+    _head[pipe]++;
+}
+
+/**
+ * \brief Trata uma mensagem de controle do pipe 0
+ * 
+ * \return false se a mensagem não é de controle
+ */
+bool nrf_hub::control(const uint8_t *buff, uint8_t length){
+    if(length >= 5 && buff[0] == NRF_HUB_JOIN){
+        uint32_t uid = (uint32_t)buff[1] | ((uint32_t)buff[2] << 8) |
+                       ((uint32_t)buff[3] << 16) | ((uint32_t)buff[4] << 24);
+        int16_t node = nrf_hub::add(uid);
+        if(node < 0){
+            if(uid)
+                _rejected++;
+            return true;
+        }
+        if(_nodes[node].pipe == NRF_HUB_NO_PIPE)
+            _nodes[node].pending = true;
+        
+        // resposta no ACK do próximo pacote do pipe 0, apenas para o último pedido
+        uint8_t reply[10];
+        reply[0] = NRF_HUB_ASSIGN;
+        memcpy(&reply[1], &buff[1], 4);
+        nrf_hub::get_address(node, &reply[5]);
+        _radio->flush_ack_payloads();
+        _radio->write_ack_payload(NRF_PIPE0, reply, sizeof(reply));
+        return true;
+    }
+    
+    if(length >= 2 && buff[0] == NRF_HUB_WAKE){
+        uint8_t node = buff[1] - NRF_HUB_FIRST_LSB;
+        if(node < NRF_HUB_MAX_NODES && _nodes[node].uid && _nodes[node].pipe == NRF_HUB_NO_PIPE)
+            _nodes[node].pending = true;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * \brief Escolhe o pipe para um novo nó: um pipe livre ou o nó há mais tempo em um pipe
+ * 
+ * \return \ref NRF_HUB_NO_PIPE se todos os pipes foram trocados na atualização em andamento
+ */
+uint8_t nrf_hub::victim(void){
+    uint8_t pipe = NRF_HUB_NO_PIPE;
+    for(uint8_t i=1; i<6; i++){
+        if(_pipes[i].node == NRF_HUB_NO_NODE)
+            return i;
+        if(pipe == NRF_HUB_NO_PIPE || (int16_t)(_mapped_seq[i] - _mapped_seq[pipe]) < 0)
+            pipe = i;
+    }
+    if((int16_t)(_mapped_seq[pipe] - _batch_seq) >= 0)
+        return NRF_HUB_NO_PIPE;
+    return pipe;
+}
+
+/**
+ * \brief Atribui um pipe ao nó, sem retornar ao modo de recepção (ver \ref end_update)
+ */
+bool nrf_hub::place(uint8_t node){
+    if(_nodes[node].pipe != NRF_HUB_NO_PIPE){
+        _nodes[node].pending = false;
+        return true;
+    }
+    uint8_t pipe = nrf_hub::victim();
+    if(pipe == NRF_HUB_NO_PIPE)
+        return false;
+    nrf_hub::begin_update();
+    nrf_hub::map(pipe, node);
+    return true;
+}
+
+/**
+ * \brief Troca o nó de um pipe, com o rádio em 'standby' (ver \ref begin_update)
+ * 
+ * Nos pipes 2 a 5, apenas o LSB do endereço é escrito.
+ */
+void nrf_hub::map(uint8_t pipe, uint8_t node){
+    uint8_t previous = _pipes[pipe].node;
+    if(previous != NRF_HUB_NO_NODE)
+        _nodes[previous].pipe = NRF_HUB_NO_PIPE;
+    _pipes[pipe].node = node;
+    _pipes[pipe].rotations++;
+    _mapped_seq[pipe] = ++_seq;
+    
+    if(node == NRF_HUB_NO_NODE){
+        _radio->disable_rx_pipe((nrf_address_t)pipe);
+        return;
+    }
+    _nodes[node].pipe = pipe;
+    _nodes[node].pending = false;
+    
+    uint8_t addr[5];
+    nrf_hub::get_address(node, addr);
+    _radio->set_rx_address((nrf_address_t)pipe, addr, (pipe == 1)? 5 : 1);
+    if(previous == NRF_HUB_NO_NODE)
+        _radio->enable_rx_pipe((nrf_address_t)pipe, true);
+}
+
+/**
+ * \brief Coloca o rádio em 'standby' e lê os pacotes restantes antes das trocas
+ * 
+ * Os pacotes no FIFO de recepção são atribuídos aos nós pelo número do pipe; a leitura antes
+ * da troca evita a atribuição ao novo nó.
+ */
+void nrf_hub::begin_update(void){
+    uint8_t buff[32], length, pipe;
+    if(_updating)
+        return;
+    _updating = true;
+    _radio->begin_mode(NRF_STANDBY);
+    while(_radio->read_received_payload(buff, &length, &pipe))
+        nrf_hub::receive(buff, length, pipe);
+}
+
+/**
+ * \brief Retorna ao modo de recepção após as trocas, sem aguardar a estabilização
+ */
+void nrf_hub::end_update(void){
+    if(!_updating)
+        return;
+    _updating = false;
+    _radio->begin_mode(NRF_RX_MODE);
+}
+
+/**
+ * \brief Troca os nós dos pipes pelos próximos nós da tabela
+ */
+void nrf_hub::rotate(void){
+    uint8_t waiting = 0;
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES; i++){
+        if(_nodes[i].uid && _nodes[i].pipe == NRF_HUB_NO_PIPE)
+            waiting++;
+    }
+    if(waiting > 5)
+        waiting = 5;
+    
+    // os nós substituídos voltam à rotação após os que aguardam
+    for(uint8_t i=0; i<NRF_HUB_MAX_NODES && waiting; i++){
+        uint8_t node = _next_node;
+        _next_node = (_next_node + 1) % NRF_HUB_MAX_NODES;
+        if(!_nodes[node].uid || _nodes[node].pipe != NRF_HUB_NO_PIPE)
+            continue;
+        if(!nrf_hub::place(node)){
+            _next_node = node;  // continua deste nó na próxima troca
+            return;
+        }
+        waiting--;
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ * \file nrf_hub.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Concentrador de uma rede em estrela com mais de seis nós
+ * 
+ * O concentrador (PRX) atribui um endereço a cada nó e recebe os pacotes nos pipes 1 a 5, que
+ * compartilham os quatro bytes superiores do endereço e diferem apenas no primeiro byte (LSB).
+ * Com mais de cinco nós, os LSBs dos pipes são trocados periodicamente (ver \ref
+ * nrf_hub::set_schedule) ou sob demanda (ver \ref nrf_hub::activate). Um nó fora dos pipes não
+ * recebe ACK e deve repetir o envio mais tarde.
+ * 
+ * O pipe 0 recebe as mensagens de controle, no endereço de entrada:
+ * 
+ * \li \ref NRF_HUB_JOIN : entrada de um nó, identificado por um número de 32 bits (uid). O
+ * endereço atribuído é enviado no ACK do próximo pacote recebido no pipe 0 (\ref NRF_HUB_ASSIGN),
+ * substituindo respostas anteriores. O nó repete \ref NRF_HUB_JOIN logo em seguida (alguns
+ * milissegundos) até receber a resposta com o seu uid.
+ * \li \ref NRF_HUB_WAKE : pedido de um pipe para o nó, identificado pelo LSB do seu endereço.
+ * 
+ * Com payloads de 10 bytes no ACK, os nós devem utilizar retransmissões a cada 500us ou mais a
+ * 1Mbps (ver \ref nrf::enable_ack_payload).
+ * */
+
+#ifndef NRF_HUB_H
+#define NRF_HUB_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/** \brief LSB do endereço do primeiro nó; o nó n utiliza NRF_HUB_FIRST_LSB + n */
+#define NRF_HUB_FIRST_LSB   0x10
+/** \brief Nenhum nó */
+#define NRF_HUB_NO_NODE     0xFF
+/** \brief Nó fora dos pipes de recepção */
+#define NRF_HUB_NO_PIPE     0xFF
+
+/** \brief Mensagem de entrada (nó): [NRF_HUB_JOIN, uid (4 bytes, LSB primeiro)] */
+#define NRF_HUB_JOIN        0x01
+/** \brief Pedido de pipe (nó): [NRF_HUB_WAKE, LSB do endereço do nó] */
+#define NRF_HUB_WAKE        0x02
+/** \brief Resposta no ACK (concentrador): [NRF_HUB_ASSIGN, uid (4 bytes), endereço (5 bytes, LSB primeiro)] */
+#define NRF_HUB_ASSIGN      0x81
+
+/**
+ * \brief Nó da tabela do concentrador
+ * */
+typedef struct{
+    uint32_t uid;           ///< Identificador do nó (0: posição livre)
+    uint8_t pipe;           ///< Pipe de recepção ou \ref NRF_HUB_NO_PIPE
+    bool pending;           ///< Aguardando um pipe (ver \ref nrf_hub::activate)
+    uint16_t received;      ///< Pacotes recebidos
+    uint16_t dropped;       ///< Pacotes descartados com a fila do pipe cheia
+    uint32_t last_seen;     ///< millis() do último pacote recebido
+}nrf_hub_node_t;
+
+/**
+ * \brief Estado e estatísticas de um pipe do concentrador
+ * */
+typedef struct{
+    uint8_t node;           ///< Nó atribuído ao pipe ou \ref NRF_HUB_NO_NODE
+    uint32_t received;      ///< Pacotes recebidos
+    uint16_t dropped;       ///< Pacotes descartados com a fila cheia
+    uint16_t rotations;     ///< Trocas de nó
+}nrf_hub_pipe_t;
+
+/**
+ * \brief Pacote na fila de um pipe
+ * */
+typedef struct{
+    uint8_t node;           ///< Nó de origem (\ref NRF_HUB_NO_NODE no pipe 0)
+    uint8_t length;
+    uint8_t data[32];
+}nrf_hub_packet_t;
+
+/**
+ * \brief Concentrador de uma rede em estrela (ver nrf_hub.h)
+ * 
+ * Exemplo:
+ * \code
+ * nrf_hub hub(&radio);
+ * hub.begin(base_addr, join_addr);
+ * hub.set_schedule(200);     // cinco nós a cada 200ms
+ * ...
+ * hub.poll();
+ * while(hub.read(buff, &length, &node))
+ *     ...
+ * \endcode
+ * 
+ * O concentrador lê os pacotes do rádio (ver \ref nrf::read_received_payload) e não utiliza
+ * \ref nrf::on_received . A troca dos LSBs é feita no modo 'standby', após a leitura dos pacotes
+ * recebidos, de modo que cada pacote é atribuído ao nó correto.
+ * */
+class nrf_hub{
+public:
+    nrf_hub(nrf *radio);
+    void begin(const uint8_t *base, const uint8_t *join_address);
+    void set_schedule(uint16_t slot_ms);
+    int16_t add(uint32_t uid);
+    void remove(uint8_t node);
+    int16_t find(uint32_t uid);
+    uint8_t count(void);
+    void get_address(uint8_t node, uint8_t *addr);
+    bool activate(uint8_t node);
+    void poll(void);
+    bool read(uint8_t *buff, uint8_t *length, uint8_t *node);
+    bool read_pipe(uint8_t pipe, uint8_t *buff, uint8_t *length, uint8_t *node);
+    const nrf_hub_node_t *get_node(uint8_t node);
+    const nrf_hub_pipe_t *get_pipe(uint8_t pipe);
+    uint16_t get_rejected(void);
+    
+private:
+    nrf *_radio;
+    uint8_t _base[5];
+    nrf_hub_node_t _nodes[NRF_HUB_MAX_NODES];
+    nrf_hub_pipe_t _pipes[6];
+    uint16_t _mapped_seq[6]; //ordem das trocas, para a escolha do pipe substituído
+    uint16_t _seq;
+    uint16_t _batch_seq; //primeira troca da atualização em andamento
+    bool _updating; //rádio em 'standby' para a troca dos LSBs
+    nrf_hub_packet_t _queue[6][NRF_HUB_QUEUE_SIZE];
+    uint8_t _head[6], _tail[6];
+    uint8_t _next_pipe; //primeira fila lida na próxima chamada de read
+    uint8_t _next_node; //próximo nó da rotação
+    uint16_t _slot_ms;
+    uint32_t _slot_start;
+    uint16_t _rejected;
+    void receive(const uint8_t *buff, uint8_t length, uint8_t pipe);
+    bool control(const uint8_t *buff, uint8_t length);
+    uint8_t victim(void);
+    bool place(uint8_t node);
+    void map(uint8_t pipe, uint8_t node);
+    void begin_update(void);
+    void end_update(void);
+    void rotate(void);
+};
+
+#endif
@@ -0,0 +1,310 @@
+/**
+ * \file nrf_link.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do controle adaptativo do enlace
+ * */
+
+#include<string.h>
+#include "nrf_link.h"
+
+/**
+ * \brief Construtor do controle, sem destinos
+ * 
+ * O tempo máximo de envio padrão é de 4ms.
+ * 
+ * \param[in] *radio Rádio (PTX), com auto-ack habilitado no pipe 0
+ */
+nrf_link::nrf_link(nrf *radio){
+    _radio = radio;
+    _count = 0;
+    _selected = 0xFF;
+    _latency_target = 4000;
+    _on_rate_change = NULL;
+}
+
+/**
+ * \brief Adiciona um destino
+ * 
+ * O destino inicia com a taxa de dados atual do rádio e o ARD mínimo.
+ * 
+ * \param[in] *address Endereço (LSB primeiro), com o tamanho configurado no rádio
+ * 
+ * \return Índice do destino, ou -1 se o número máximo de destinos (\ref NRF_LINK_MAX_DESTINATIONS)
+ * foi atingido
+ */
+int8_t nrf_link::add(const uint8_t *address){
+    if(_count >= NRF_LINK_MAX_DESTINATIONS)
+        return -1;
+    nrf_link_dest_t *dest = &_dests[_count];
+    memset(dest, 0, sizeof(nrf_link_dest_t));
+    memcpy(dest->address, address, _radio->get_address_width());
+    dest->datarate = _radio->get_rf_datarate();
+    if(dest->datarate > NRF_2MBPS)
+        dest->datarate = NRF_2MBPS;
+    dest->probe = NRF_LINK_PROBE_MIN;
+    return _count++;
+}
+
+/**
+ * \brief Configura o tempo máximo de um envio, incluindo as retransmissões
+ * 
+ * O número de retransmissões (ARC) de cada envio é o maior cujo pior caso não excede esse tempo.
+ * Com um tempo menor que o de uma transmissão, os pacotes não são retransmitidos.
+ * 
+ * \param[in] us Tempo máximo (us)
+ */
+void nrf_link::set_latency_target(uint16_t us){
+    _latency_target = us;
+}
+
+/**
+ * \brief Habilita o ajuste da taxa de dados
+ * 
+ * Sem a função, a taxa de dados de cada destino não é alterada.
+ * 
+ * \param[in] callback Função chamada antes de cada mudança, ou NULL
+ */
+void nrf_link::on_rate_change(nrf_link_rate_callback_t callback){
+    _on_rate_change = callback;
+}
+
+/**
+ * \brief Envia um pacote ao destino com os parâmetros ajustados e atualiza as médias
+ * 
+ * Bloqueia até a confirmação ou o número máximo de retransmissões. O rádio permanece no modo
+ * 'tx'. Um payload recebido no ACK permanece no FIFO de recepção (ver \ref nrf::read_ack_payload).
+ * 
+ * \param[in] dest Destino (ver \ref add)
+ * \param[in] *buff Payload
+ * \param[in] length Tamanho do payload (até 32 bytes)
+ * 
+ * \return true se o pacote foi confirmado
+ */
+bool nrf_link::send(uint8_t dest, const uint8_t *buff, uint8_t length){
+    if(dest >= _count)
+        return false;
+    nrf_link::select(dest, length);
+    if(!_radio->write_tx_payload((uint8_t*)buff, length))
+        return false;
+    if(_radio->get_current_mode() != NRF_TX_MODE)
+        _radio->set_mode(NRF_TX_MODE);
+    
+    bool delivered = _radio->wait_packet_sent();
+    uint8_t retries = _radio->get_observe_tx() & ARC_CNT;
+    uint8_t ack_width = 0;
+    if(delivered && ((_radio->get_last_status() & RX_P_NO) >> 1) == 0)
+        ack_width = _radio->get_received_payload_width();   // payload no ACK
+    nrf_link::report(dest, delivered, retries, ack_width);
+    return delivered;
+}
+
+/**
+ * \brief Configura o rádio para o destino: endereços, taxa de dados, ARD e ARC
+ * 
+ * Apenas os registradores alterados são escritos. Utilizada por \ref send.
+ * 
+ * \param[in] dest Destino (ver \ref add)
+ * \param[in] length Tamanho do próximo payload, para o cálculo do ARC
+ */
+void nrf_link::select(uint8_t dest, uint8_t length){
+    if(dest >= _count)
+        return;
+    nrf_link_dest_t *d = &_dests[dest];
+    nrf_datarate_t rate = (nrf_datarate_t)d->datarate;
+    
+    uint8_t ard = nrf_link::min_retr_delay(rate, d->ack_width) + d->backoff;
+    if(ard > 15)
+        ard = 15;
+    uint8_t arc = nrf_link::retr_count(rate, ard, length);
+    d->length = length;
+    d->retr_count = arc;
+    d->retr_delay = ard;
+    
+    if(_radio->get_rf_datarate() != rate)
+        _radio->set_rf_datarate(rate);
+    if(_radio->get_retr_param() != (uint8_t)((ard << 4) | arc))
+        _radio->set_retr_param(arc, ard);
+    if(_selected != dest){
+        _radio->set_tx_address(d->address, _radio->get_address_width());
+        _radio->set_rx_address(NRF_PIPE0, d->address, _radio->get_address_width());
+        _selected = dest;
+    }
+}
+
+/**
+ * \brief Informa o resultado de um envio e ajusta os parâmetros do destino
+ * 
+ * \param[in] dest Destino (ver \ref add)
+ * \param[in] delivered Pacote confirmado
+ * \param[in] retries Retransmissões (ARC_CNT, ver \ref nrf::get_observe_tx)
+ * \param[in] ack_width Tamanho do payload recebido no ACK, ou 0
+ */
+void nrf_link::report(uint8_t dest, bool delivered, uint8_t retries, uint8_t ack_width){
+    if(dest >= _count)
+        return;
+    nrf_link_dest_t *d = &_dests[dest];
+    if(ack_width > d->ack_width)
+        d->ack_width = ack_width;   // novo ARD mínimo no próximo envio
+    if(delivered)
+        d->sent++;
+    else
+        d->failed++;
+    
+    if(delivered)
+        d->retries = nrf_link::average(d->retries, retries * NRF_LINK_ONE);  // falhas contam em 'loss'
+    d->loss = nrf_link::average(d->loss, delivered? 0 : NRF_LINK_ONE);
+    if(d->stable < 0xFFFF)
+        d->stable++;
+    d->clean = (delivered && retries == 0)? d->clean + 1 : 0;
+    if(d->samples < NRF_LINK_MIN_SAMPLES){
+        d->samples++;
+        return;
+    }
+    
+    uint8_t rate = d->datarate;
+    uint8_t ard = nrf_link::min_retr_delay((nrf_datarate_t)rate, d->ack_width) + d->backoff;
+    bool can_backoff = d->backoff < NRF_LINK_MAX_BACKOFF && ard < 15 &&
+                       nrf_link::retr_count(rate, ard + 1, d->length) >= NRF_LINK_MIN_RETRIES;
+    bool can_slow = rate > NRF_250KBPS &&
+                    nrf_link::retr_count(rate - 1, nrf_link::min_retr_delay((nrf_datarate_t)(rate - 1), d->ack_width),
+                                         d->length) >= NRF_LINK_MIN_RETRIES;
+    
+    if(d->loss > NRF_LINK_LOSS_HIGH){
+        // perdas: menor taxa (maior sensibilidade) ou tentativas mais espaçadas
+        if(!(can_slow && nrf_link::change_rate(dest, false)) && can_backoff){
+            d->backoff++;
+            d->samples = 0;
+        }
+    }else if(d->retries > NRF_LINK_RETRIES_HIGH){
+        if(can_backoff){
+            d->backoff++;
+            d->samples = 0;
+        }else if(can_slow){
+            nrf_link::change_rate(dest, false);
+        }
+    }else if(d->clean >= d->probe){
+        d->clean = 0;
+        nrf_link::change_rate(dest, true);
+    }else if(d->backoff && (d->retries < NRF_LINK_RETRIES_LOW ||
+                            nrf_link::retr_count(rate, ard, d->length) < NRF_LINK_MIN_RETRIES)){
+        d->backoff--;
+        d->samples = 0;
+    }
+}
+
+/**
+ * \brief Retorna o estado e as estatísticas de um destino, ou NULL
+ */
+const nrf_link_dest_t *nrf_link::get_destination(uint8_t dest){
+    return (dest < _count)? &_dests[dest] : NULL;
+}
+
+/**
+ * \brief Retorna o menor ARD que permite a recepção do ACK (datasheet)
+ * 
+ * \param[in] rate Taxa de dados
+ * \param[in] ack_width Tamanho do payload no ACK (0 sem payload)
+ * 
+ * \return ARD, 250*(1+valor) us (ver \ref nrf::set_retr_param)
+ */
+uint8_t nrf_link::min_retr_delay(nrf_datarate_t rate, uint8_t ack_width){
+    switch(rate){
+        case NRF_2MBPS:
+        return (ack_width > 15)? 1 : 0;
+        case NRF_1MBPS:
+        return (ack_width > 5)? 1 : 0;
+        default:
+        if(ack_width == 0)
+            return 1;   // 500us
+        return 2 + (ack_width - 1) / 8;     // 750us a 1500us
+    }
+}
+
+/**
+ * \brief Atualiza uma média móvel com peso 1/\ref NRF_LINK_WEIGHT
+ * 
+ * A correção é arredondada ao inteiro mais próximo: sem o arredondamento, a divisão truncada
+ * deixaria a média parada até NRF_LINK_WEIGHT-1 acima da amostra.
+ */
+uint16_t nrf_link::average(uint16_t avg, uint16_t sample){
+    int16_t delta = (int16_t)sample - (int16_t)avg;
+    delta += (delta < 0)? -(NRF_LINK_WEIGHT / 2) : (NRF_LINK_WEIGHT / 2);
+    return avg + delta / NRF_LINK_WEIGHT;
+}
+
+/**
+ * \brief Zera as médias após uma mudança da taxa de dados
+ */
+void nrf_link::reset_estimates(nrf_link_dest_t *dest){
+    dest->retries = 0;
+    dest->loss = 0;
+    dest->clean = 0;
+    dest->samples = 0;
+    dest->backoff = 0;
+    dest->stable = 0;
+}
+
+/**
+ * \brief Muda a taxa de dados do destino para a próxima taxa maior ou menor
+ * 
+ * Uma redução antes de \c probe envios na taxa aumentada indica tentativa mal sucedida: o
+ * intervalo até a próxima tentativa é dobrado. Nas demais reduções, ele volta ao mínimo.
+ * 
+ * \return false sem a função de \ref on_rate_change, no limite ou se a mudança foi recusada
+ */
+bool nrf_link::change_rate(uint8_t dest, bool faster){
+    nrf_link_dest_t *d = &_dests[dest];
+    if(_on_rate_change == NULL)
+        return false;
+    if(faster? (d->datarate >= NRF_2MBPS) : (d->datarate <= NRF_250KBPS))
+        return false;
+    
+    uint8_t rate = faster? d->datarate + 1 : d->datarate - 1;
+    if(!_on_rate_change(dest, (nrf_datarate_t)rate)){
+        d->samples = 0;
+        return false;
+    }
+    d->datarate = rate;
+    if(!faster){
+        if(!(d->raised && d->stable < d->probe))
+            d->probe = NRF_LINK_PROBE_MIN;
+        else if(d->probe < NRF_LINK_PROBE_MAX)
+            d->probe *= 2;
+    }
+    d->raised = faster;
+    nrf_link::reset_estimates(d);
+    return true;
+}
+
+/**
+ * \brief Maior ARC cujo pior caso não excede o tempo máximo de envio
+ * 
+ * Pior caso: estabilização, primeira transmissão e ARC tentativas após o ARD.
+ */
+uint8_t nrf_link::retr_count(uint8_t rate, uint8_t ard, uint8_t length){
+    uint16_t first = NRF_SETTLE_DELAY + nrf_link::airtime(rate, length);
+    uint16_t attempt = nrf_link::airtime(rate, length) + 250 * (1 + (uint16_t)ard);
+    if(_latency_target <= first)
+        return 0;
+    uint16_t arc = (_latency_target - first) / attempt;
+    return (arc > 15)? 15 : arc;
+}
+
+/**
+ * \brief Duração de uma transmissão (us)
+ * 
+ * Preâmbulo, endereço, campo de controle (9 bits), payload e CRC.
+ */
+uint16_t nrf_link::airtime(uint8_t rate, uint8_t length){
+    uint16_t bits = 8 * (1 + _radio->get_address_width() + length + _radio->get_crc_mode()) + 9;
+    switch(rate){
+        case NRF_2MBPS:
+        return bits / 2;
+        case NRF_1MBPS:
+        return bits;
+        default:
+        return bits * 4;
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * \file nrf_link.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Controle adaptativo de retransmissões e taxa de dados
+ * 
+ * Após cada envio, o número de retransmissões (ARC_CNT, ver \ref nrf::get_observe_tx) e o
+ * resultado do envio atualizam médias móveis por destino. Os parâmetros de cada destino são
+ * ajustados a partir delas:
+ * 
+ * \li ARD: o mínimo do datasheet para a taxa de dados e o maior payload de ACK observado (ver
+ * \ref nrf_link::min_retr_delay), acrescido de passos de 250us quando as retransmissões são
+ * frequentes, para espaçar as tentativas em interferências longas.
+ * \li ARC: o maior número de retransmissões cujo pior caso cabe no tempo máximo de envio (ver
+ * \ref nrf_link::set_latency_target).
+ * \li Taxa de dados (opcional, ver \ref nrf_link::on_rate_change): reduzida com perdas ou
+ * retransmissões frequentes; aumentada após uma sequência de envios sem retransmissões. O
+ * intervalo entre tentativas de aumento é dobrado quando a taxa aumentada não se mantém e volta
+ * ao mínimo quando a redução ocorre após um período estável.
+ * 
+ * O ARD e a taxa de dados são alterados apenas se o tempo máximo ainda permitir
+ * \ref NRF_LINK_MIN_RETRIES retransmissões.
+ * */
+
+#ifndef NRF_LINK_H
+#define NRF_LINK_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/** \brief Escala das médias móveis (1,0) */
+#define NRF_LINK_ONE            256
+/** \brief Peso das novas amostras nas médias móveis: 1/NRF_LINK_WEIGHT */
+#define NRF_LINK_WEIGHT         8
+/** \brief Média de retransmissões por pacote acima da qual o ARD é aumentado ou a taxa reduzida */
+#define NRF_LINK_RETRIES_HIGH   (2 * NRF_LINK_ONE)
+/** \brief Média de retransmissões por pacote abaixo da qual o ARD é reduzido */
+#define NRF_LINK_RETRIES_LOW    (NRF_LINK_ONE / 2)
+/** \brief Taxa de perdas acima da qual a taxa de dados é reduzida: 3 amostras (3/8), atingida após 4 falhas consecutivas */
+#define NRF_LINK_LOSS_HIGH      (3 * NRF_LINK_ONE / NRF_LINK_WEIGHT)
+/** \brief Envios após um ajuste antes do próximo */
+#define NRF_LINK_MIN_SAMPLES    8
+/** \brief Envios consecutivos sem retransmissões para tentar a taxa de dados seguinte */
+#define NRF_LINK_PROBE_MIN      64
+/** \brief Limite do intervalo entre tentativas de aumento da taxa de dados */
+#define NRF_LINK_PROBE_MAX      4096
+/** \brief Passos máximos de 250us acima do ARD mínimo */
+#define NRF_LINK_MAX_BACKOFF    4
+/** \brief Menor ARC aceito nos ajustes: ARD maior ou taxa menor apenas se o tempo máximo permitir */
+#define NRF_LINK_MIN_RETRIES    3
+
+/**
+ * \brief Função chamada antes da mudança da taxa de dados de um destino
+ * 
+ * O receptor deve passar a utilizar a mesma taxa: a função pode, por exemplo, enviar a nova
+ * taxa ao receptor (ainda na taxa atual) e aguardar a confirmação.
+ * 
+ * \param[in] dest Destino (ver \ref nrf_link::add)
+ * \param[in] rate Nova taxa de dados
+ * 
+ * \return false para manter a taxa atual
+ */
+typedef bool (*nrf_link_rate_callback_t)(uint8_t dest, nrf_datarate_t rate);
+
+/**
+ * \brief Estado e estatísticas de um destino de \ref nrf_link
+ * */
+typedef struct{
+    uint8_t address[5];     ///< Endereço (LSB primeiro)
+    uint8_t datarate;       ///< Taxa de dados (\ref nrf_datarate_t)
+    uint8_t retr_count;     ///< ARC configurado
+    uint8_t retr_delay;     ///< ARD configurado, 250*(1+retr_delay) us
+    uint8_t backoff;        ///< Passos de 250us acima do ARD mínimo
+    uint8_t ack_width;      ///< Maior payload de ACK observado
+    uint8_t length;         ///< Tamanho do último payload
+    uint8_t samples;        ///< Envios desde o último ajuste
+    bool raised;            ///< Última mudança de taxa foi um aumento
+    uint16_t retries;       ///< Média de retransmissões por pacote confirmado (escala \ref NRF_LINK_ONE)
+    uint16_t loss;          ///< Taxa de perdas (escala \ref NRF_LINK_ONE)
+    uint16_t clean;         ///< Envios consecutivos sem retransmissões
+    uint16_t probe;         ///< Envios sem retransmissões para tentar a taxa seguinte
+    uint16_t stable;        ///< Envios desde a última mudança de taxa (satura em 65535)
+    uint32_t sent;          ///< Pacotes confirmados
+    uint32_t failed;        ///< Pacotes não confirmados
+}nrf_link_dest_t;
+
+/**
+ * \brief Controle adaptativo do enlace (ver nrf_link.h)
+ * 
+ * Exemplo:
+ * \code
+ * nrf_link link(&radio);
+ * uint8_t sensor = link.add(sensor_addr);
+ * link.set_latency_target(5000);     // até 5ms por envio
+ * ...
+ * link.send(sensor, buff, length);
+ * \endcode
+ * 
+ * Para envios feitos pela aplicação (por exemplo, com \ref nrf::send_async), informe o
+ * resultado com \ref report e aplique os parâmetros com \ref select antes do envio seguinte.
+ * */
+class nrf_link{
+public:
+    nrf_link(nrf *radio);
+    int8_t add(const uint8_t *address);
+    void set_latency_target(uint16_t us);
+    void on_rate_change(nrf_link_rate_callback_t callback);
+    bool send(uint8_t dest, const uint8_t *buff, uint8_t length);
+    void select(uint8_t dest, uint8_t length);
+    void report(uint8_t dest, bool delivered, uint8_t retries, uint8_t ack_width=0);
+    const nrf_link_dest_t *get_destination(uint8_t dest);
+    static uint8_t min_retr_delay(nrf_datarate_t rate, uint8_t ack_width);
+    
+private:
+    nrf *_radio;
+    nrf_link_dest_t _dests[NRF_LINK_MAX_DESTINATIONS];
+    uint8_t _count;
+    uint8_t _selected; //destino configurado no rádio
+    uint16_t _latency_target;
+    nrf_link_rate_callback_t _on_rate_change;
+    static uint16_t average(uint16_t avg, uint16_t sample);
+    void reset_estimates(nrf_link_dest_t *dest);
+    bool change_rate(uint8_t dest, bool faster);
+    uint8_t retr_count(uint8_t rate, uint8_t ard, uint8_t length);
+    uint16_t airtime(uint8_t rate, uint8_t length);
+};
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * \file nrf_linux.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte do acesso ao hardware no Linux
+ * */
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include<stdio.h>
+#include<errno.h>
+#include<string.h>
+#include<time.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/ioctl.h>
+#include<linux/spi/spidev.h>
+#include<linux/gpio.h>
+#include "nrf_linux.h"
+#include "nordic.h"
+
+/* bytes enviados nos segmentos sem dados de transmissão */
+static uint8_t nop_bytes[255];
+
+nrf_linux_backend::nrf_linux_backend(){
+    _spi_fd = -1;
+    _chip_fd = -1;
+    _ce_fd = -1;
+    _irq_fd = -1;
+    _spi_clock = 0;
+    _ce_level = false;
+    _error = 0;
+}
+
+nrf_linux_backend::~nrf_linux_backend(){
+    nrf_linux_backend::end();
+}
+
+/**
+ * \brief Abre os dispositivos SPI e GPIO
+ * 
+ * \param[in] *spidev Dispositivo SPI (ex.: "/dev/spidev0.0")
+ * \param[in] spi_clock Frequência do clock SPI em Hz (máximo de 10MHz)
+ * \param[in] *gpiochip Controlador GPIO (ex.: "/dev/gpiochip0")
+ * \param[in] ce_line Linha do controlador GPIO ligada ao pino CE
+ * 
+ * \return true ou false
+ * \retval false Falha ao abrir ou configurar algum dispositivo.
+ */
+bool nrf_linux_backend::begin(const char *spidev, uint32_t spi_clock, const char *gpiochip, uint8_t ce_line){
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = 8;
+    
+    memset(nop_bytes, 0xFF, sizeof(nop_bytes));
+    _spi_clock = (spi_clock > 10000000UL)? 10000000UL : spi_clock;
+    
+    _spi_fd = open(spidev, O_RDWR);
+    if(_spi_fd < 0 ||
+       ioctl(_spi_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+       ioctl(_spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+       ioctl(_spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &_spi_clock) < 0){
+        nrf_linux_backend::end();
+        return false;
+    }
+    
+    _chip_fd = open(gpiochip, O_RDWR);
+    if(_chip_fd < 0){
+        nrf_linux_backend::end();
+        return false;
+    }
+    
+    struct gpiohandle_request request;
+    memset(&request, 0, sizeof(request));
+    request.lineoffsets[0] = ce_line;
+    request.lines = 1;
+    request.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    request.default_values[0] = 0;
+    strncpy(request.consumer_label, "nrf-ce", sizeof(request.consumer_label) - 1);
+    if(ioctl(_chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &request) < 0){
+        nrf_linux_backend::end();
+        return false;
+    }
+    _ce_fd = request.fd;
+    _ce_level = false;
+    _error = 0;
+    return true;
+}
+
+/**
+ * \brief Fecha os dispositivos SPI e GPIO
+ */
+void nrf_linux_backend::end(void){
+    if(_irq_fd >= 0)
+        close(_irq_fd);
+    if(_ce_fd >= 0)
+        close(_ce_fd);
+    if(_chip_fd >= 0)
+        close(_chip_fd);
+    if(_spi_fd >= 0)
+        close(_spi_fd);
+    _spi_fd = _chip_fd = _ce_fd = _irq_fd = -1;
+}
+
+/**
+ * \brief Retorna o primeiro erro de transferência desde \ref begin ou \ref clear_error
+ * 
+ * \return Código errno, ou 0 sem erros
+ * \retval E2BIG Transferência com mais de \ref NRF_LINUX_MAX_SEGMENTS segmentos.
+ */
+int nrf_linux_backend::get_error(void){
+    return _error;
+}
+
+/**
+ * \brief Apaga o erro registrado (ver \ref get_error)
+ */
+void nrf_linux_backend::clear_error(void){
+    _error = 0;
+}
+
+/**
+ * \brief Descarta uma transferência não realizada
+ * 
+ * Os bytes recebidos são preenchidos com 0xFF (MISO em repouso), exceto o STATUS, que indica
+ * o FIFO de recepção vazio (RX_P_NO = 111) e nenhum evento. Apenas o primeiro erro é informado
+ * por \ref print, até ser apagado por \ref clear_error.
+ */
+void nrf_linux_backend::fail(const spi_segment_t *segments, uint8_t count, int error){
+    for(uint8_t i=0; i<count; i++)
+        if(segments[i].rx != NULL)
+            memset(segments[i].rx, 0xFF, segments[i].length);
+    if(count > 0 && segments[0].rx != NULL && segments[0].length > 0)
+        segments[0].rx[0] = RX_P_NO;    // STATUS: primeiro byte da transação
+    if(_error == 0){
+        char text[64];
+        snprintf(text, sizeof(text), "nrf_linux: SPI: %s\n", strerror(error));
+        nrf_linux_backend::print(text);
+        _error = error;
+    }
+}
+
+void nrf_linux_backend::transfer(const spi_segment_t *segments, uint8_t count){
+    struct spi_ioc_transfer xfer[NRF_LINUX_MAX_SEGMENTS];
+    if(count == 0)
+        return;
+    if(count > NRF_LINUX_MAX_SEGMENTS){
+        nrf_linux_backend::fail(segments, count, E2BIG);   // CSN não pode ser mantido entre chamadas
+        return;
+    }
+    
+    memset(xfer, 0, sizeof(xfer));
+    for(uint8_t i=0; i<count; i++){
+        xfer[i].tx_buf = (unsigned long)( (segments[i].tx != NULL)? segments[i].tx : nop_bytes );
+        xfer[i].rx_buf = (unsigned long)segments[i].rx;
+        xfer[i].len = segments[i].length;
+        xfer[i].speed_hz = _spi_clock;
+        xfer[i].bits_per_word = 8;
+    }
+    if(ioctl(_spi_fd, SPI_IOC_MESSAGE(count), xfer) < 0)  // CSN permanece em '0' entre os segmentos
+        nrf_linux_backend::fail(segments, count, errno);
+}
+
+void nrf_linux_backend::write_ce(bool high){
+    struct gpiohandle_data data;
+    memset(&data, 0, sizeof(data));
+    data.values[0] = high? 1:0;
+    ioctl(_ce_fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+    _ce_level = high;
+}
+
+bool nrf_linux_backend::read_ce(void){
+    return _ce_level;
+}
+
+bool nrf_linux_backend::set_irq_pin(uint8_t irq){
+    struct gpiohandle_request request;
+    memset(&request, 0, sizeof(request));
+    request.lineoffsets[0] = irq;
+    request.lines = 1;
+    request.flags = GPIOHANDLE_REQUEST_INPUT;
+    strncpy(request.consumer_label, "nrf-irq", sizeof(request.consumer_label) - 1);
+    if(ioctl(_chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &request) < 0)
+        return false;
+    if(_irq_fd >= 0)
+        close(_irq_fd);
+    _irq_fd = request.fd;
+    return true;
+}
+
+bool nrf_linux_backend::read_irq(void){
+    struct gpiohandle_data data;
+    memset(&data, 0, sizeof(data));
+    if(ioctl(_irq_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
+        return false;   // na dúvida, indica evento pendente
+    return data.values[0] != 0;
+}
+
+bool nrf_linux_backend::attach_irq(void (*isr)(void)){
+    (void)isr;
+    return false;
+}
+
+void nrf_linux_backend::detach_irq(void){
+}
+
+void nrf_linux_backend::lock(void){
+}
+
+void nrf_linux_backend::unlock(void){
+}
+
+void nrf_linux_backend::delay_us(uint32_t us){
+    struct timespec t;
+    t.tv_sec = us / 1000000UL;
+    t.tv_nsec = (us % 1000000UL) * 1000UL;
+    while(nanosleep(&t, &t) < 0 && errno == EINTR){
+    }
+}
+
+uint32_t nrf_linux_backend::millis(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000ULL + t.tv_nsec / 1000000UL);
+}
+
+uint32_t nrf_linux_backend::micros(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000000ULL + t.tv_nsec / 1000UL);
+}
+
+void nrf_linux_backend::print(const char *text){
+    fputs(text, stdout);
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * \file nrf_linux.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Acesso ao hardware no Linux (raspberryPi e similares)
+ * */
+
+#ifndef NRF_LINUX_H
+#define NRF_LINUX_H
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "nrf_backend.h"
+
+/** \brief Número máximo de segmentos numa transferência (ver \ref nrf_backend::transfer) */
+#define NRF_LINUX_MAX_SEGMENTS  4
+
+/**
+ * \brief Acesso ao hardware no Linux
+ * 
+ * A interface SPI é acessada pelo dispositivo /dev/spidevX.Y. Todos os segmentos de um comando
+ * são enviados numa única chamada SPI_IOC_MESSAGE. Os pinos CE e IRQ são linhas do GPIO
+ * character device (/dev/gpiochipN).
+ * 
+ * Exemplo:
+ * \code
+ * nrf_linux_backend bus;
+ * if(bus.begin("/dev/spidev0.0", 8000000, "/dev/gpiochip0", 25)){
+ *     nrf radio(&bus);
+ *     ...
+ * }
+ * \endcode
+ * 
+ * Uma transferência com mais de \ref NRF_LINUX_MAX_SEGMENTS segmentos ou com falha na chamada
+ * SPI_IOC_MESSAGE não é realizada: o STATUS recebido indica o FIFO de recepção vazio e nenhum
+ * evento, os demais bytes recebidos são 0xFF e o erro é registrado (ver \ref get_error).
+ * 
+ * \warning A rotina de interrupção não é suportada (ver \ref attach_irq). O pino de IRQ pode
+ * ser consultado pelas funções de espera da classe \ref nrf .
+ * */
+class nrf_linux_backend: public nrf_backend{
+public:
+    nrf_linux_backend();
+    virtual ~nrf_linux_backend();
+    bool begin(const char *spidev, uint32_t spi_clock, const char *gpiochip, uint8_t ce_line);
+    void end(void);
+    int get_error(void);
+    void clear_error(void);
+    
+    virtual void transfer(const spi_segment_t *segments, uint8_t count);
+    virtual void write_ce(bool high);
+    virtual bool read_ce(void);
+    virtual bool set_irq_pin(uint8_t irq);
+    virtual bool read_irq(void);
+    virtual bool attach_irq(void (*isr)(void));
+    virtual void detach_irq(void);
+    virtual void lock(void);
+    virtual void unlock(void);
+    virtual void delay_us(uint32_t us);
+    virtual uint32_t millis(void);
+    virtual uint32_t micros(void);
+    virtual void print(const char *text);
+    
+private:
+    int _spi_fd; //dispositivo spidev
+    int _chip_fd; //dispositivo gpiochip
+    int _ce_fd; //linha de CE
+    int _irq_fd; //linha de IRQ
+    uint32_t _spi_clock;
+    bool _ce_level;
+    int _error; //primeiro erro de transferência (errno), ou 0
+    void fail(const spi_segment_t *segments, uint8_t count, int error);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+/**
+ * \file nrf_listen.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte da recepção com ciclo de trabalho
+ * */
+
+#include "nrf_listen.h"
+
+/**
+ * \brief Construtor, com período de 100ms e janelas de 600us (ver \ref set_timing)
+ * 
+ * \param[in] *radio Rádio
+ */
+nrf_listen::nrf_listen(nrf *radio){
+    _radio = radio;
+    _hold = NRF_LISTEN_HOLD;
+    _state = NRF_LISTEN_IDLE;
+    _next = 0;
+    _since = 0;
+    _until = 0;
+    _rx_time = 0;
+    nrf_listen::set_timing(100000UL, 600);
+}
+
+/**
+ * \brief Configura o período e a duração das janelas de recepção
+ * 
+ * Os dois lados devem utilizar os mesmos valores: o transmissor mantém a rajada por um
+ * período completo (ver \ref get_latency).
+ * 
+ * \param[in] period_us Período das janelas (us): latência máxima, além da partida do chip
+ * \param[in] window_us Duração de cada janela no modo 'rx', após a estabilização (us)
+ * \param[in] deep true para o modo 'power down' entre as janelas (0,9uA, partida de 1,5ms) e
+ * false para o modo 'standby' (26uA, partida de 130us)
+ */
+void nrf_listen::set_timing(uint32_t period_us, uint16_t window_us, bool deep){
+    _period = period_us;
+    _window = window_us;
+    _deep = deep;
+    _startup = (deep? NRF_POWER_UP_DELAY : 0) + NRF_SETTLE_DELAY;   // até a primeira medida
+}
+
+/**
+ * \brief Configura o tempo no modo 'rx' após o último pacote recebido
+ * 
+ * \param[in] hold_us Tempo (us), padrão \ref NRF_LISTEN_HOLD
+ */
+void nrf_listen::set_hold(uint32_t hold_us){
+    _hold = hold_us;
+}
+
+/**
+ * \brief Inicia o ciclo de trabalho do receptor
+ * 
+ * O rádio é desligado e a primeira janela começa após um período.
+ */
+void nrf_listen::listen(void){
+    uint32_t now = _radio->get_backend()->micros();
+    _next = now;
+    nrf_listen::sleep(now);
+}
+
+/**
+ * \brief Encerra o ciclo de trabalho ou a rajada e coloca o rádio no modo 'standby'
+ */
+void nrf_listen::stop(void){
+    if(_state == NRF_LISTEN_WAKING){
+        _radio->flush_tx_fifo();
+        _radio->clear_int_flag(NRF_MAX_RT);
+    }
+    if(_state == NRF_LISTEN_WINDOW || _state == NRF_LISTEN_AWAKE)
+        _rx_time += _radio->get_backend()->micros() - _since;
+    _radio->begin_mode(NRF_STANDBY);
+    _state = NRF_LISTEN_IDLE;
+}
+
+/**
+ * \brief Inicia a rajada que acorda o receptor (transmissor)
+ * 
+ * O pacote é escrito uma única vez e retransmitido até ser confirmado (\ref NRF_LISTEN_WOKEN)
+ * ou até \ref get_latency mais uma janela (\ref NRF_LISTEN_FAILED). Após a confirmação, o
+ * receptor permanece no modo 'rx' (ver \ref set_hold) e pode receber outros pacotes.
+ * 
+ * \param[in] *buff Payload
+ * \param[in] length Tamanho do payload (até 32 bytes)
+ * \return false se há uma rajada em andamento ou se o payload não foi escrito no FIFO de TX
+ * 
+ * \warning O FIFO de TX deve estar vazio e o auto-ack habilitado no PIPE0 e no receptor.
+ * O atraso das retransmissões (ver \ref nrf::set_retr_param) deve ser menor que a
+ * janela do receptor, de preferência o mínimo (250us), com 15 retransmissões.
+ */
+bool nrf_listen::send_wake(const uint8_t *buff, uint8_t length){
+    if(_state == NRF_LISTEN_WAKING)
+        return false;
+    uint32_t now = _radio->get_backend()->micros();
+    _radio->clear_int_flag(NRF_TX_DS);  // eventos de envios anteriores
+    _radio->clear_int_flag(NRF_MAX_RT);
+    if(!_radio->write_tx_payload((uint8_t *)buff, length))
+        return false;   // FIFO de TX cheio ou tamanho inválido
+    _radio->begin_mode(NRF_TX_MODE);    // a transmissão começa após a estabilização
+    _since = now;
+    _until = now + nrf_listen::get_latency() + _window;
+    _state = NRF_LISTEN_WAKING;
+    return true;
+}
+
+/**
+ * \brief Executa o ciclo de trabalho ou a rajada
+ * 
+ * Não bloqueia. Deve ser chamada com frequência maior que a das janelas: o fim de cada
+ * janela é verificado nas chamadas.
+ * 
+ * \return Estado atual (ver \ref nrf_listen_state_t)
+ */
+nrf_listen_state_t nrf_listen::poll(void){
+    uint32_t now = _radio->get_backend()->micros();
+    if(_state == NRF_LISTEN_WAKING)
+        nrf_listen::poll_transmitter(now);
+    else if(_state != NRF_LISTEN_IDLE && _state != NRF_LISTEN_WOKEN && _state != NRF_LISTEN_FAILED)
+        nrf_listen::poll_receiver(now);
+    return (nrf_listen_state_t)_state;
+}
+
+/**
+ * \brief Mantém o receptor no modo 'rx' (após uma janela ou um pacote)
+ * 
+ * \param[in] us Tempo mínimo no modo 'rx' a partir de agora (us)
+ */
+void nrf_listen::stay_awake(uint32_t us){
+    if(_state != NRF_LISTEN_WINDOW && _state != NRF_LISTEN_AWAKE)
+        return;
+    _state = NRF_LISTEN_AWAKE;
+    _until = _radio->get_backend()->micros() + us;
+}
+
+/**
+ * \brief Retorna o estado atual, sem executar o ciclo (ver \ref poll)
+ */
+nrf_listen_state_t nrf_listen::get_state(void){
+    return (nrf_listen_state_t)_state;
+}
+
+/**
+ * \brief Retorna a latência máxima até o receptor estar no modo 'rx' (us)
+ * 
+ * Período mais a partida do chip, medida pelo receptor a cada janela (no transmissor, o valor
+ * do datasheet).
+ */
+uint32_t nrf_listen::get_latency(void){
+    return _period + _startup;
+}
+
+/**
+ * \brief Estima a corrente média do receptor, sem pacotes (nA)
+ * 
+ * Calculada com as correntes do datasheet (\ref NRF_LISTEN_I_RX e demais): janela e
+ * estabilização do PLL no modo 'rx', partida do oscilador e modo 'power down' (ou 'standby')
+ * no restante do período. Não inclui o microcontrolador.
+ */
+uint32_t nrf_listen::get_current(void){
+    uint32_t settle = NRF_SETTLE_DELAY;
+    uint32_t start = (_startup > settle)? _startup - settle : 0;
+    uint32_t rx = settle + _window;
+    uint32_t idle = (_period > rx + start)? _period - rx - start : 0;
+    uint64_t charge = (uint64_t)NRF_LISTEN_I_RX * rx + (uint64_t)NRF_LISTEN_I_START * start +
+                      (uint64_t)(_deep? NRF_LISTEN_I_POWER_DOWN : NRF_LISTEN_I_STANDBY) * idle;
+    return (uint32_t)(charge / (rx + start + idle));
+}
+
+/**
+ * \brief Retorna o tempo acumulado no modo 'rx' pelo receptor desde o construtor (us)
+ * 
+ * Janelas e tempo acordado após os pacotes, sem a estabilização do PLL. Com o tempo
+ * decorrido, mede o ciclo de trabalho efetivo.
+ */
+uint32_t nrf_listen::get_rx_time(void){
+    return _rx_time;
+}
+
+/* desliga o receptor até o próximo período */
+void nrf_listen::sleep(uint32_t now){
+    _radio->begin_mode(_deep? NRF_POWER_DOWN : NRF_STANDBY);
+    _state = NRF_LISTEN_SLEEP;
+    _since = now;
+    _next += _period;
+    if((int32_t)(_next - now) <= 0)
+        _next = now + _period;  // períodos perdidos: o ciclo é reiniciado
+}
+
+/* estados do receptor */
+void nrf_listen::poll_receiver(uint32_t now){
+    switch(_state){
+        case NRF_LISTEN_SLEEP:
+            if((int32_t)(now - _next) < 0)
+                return;
+            _radio->begin_mode(NRF_RX_MODE);
+            _state = NRF_LISTEN_STARTING;
+            _since = now;
+            break;
+        case NRF_LISTEN_STARTING:
+            if(!_radio->is_ready())
+                return;
+            _startup = now - _since;
+            _state = NRF_LISTEN_WINDOW;
+            _since = now;
+            _until = now + _window;
+            break;
+        case NRF_LISTEN_WINDOW:
+        case NRF_LISTEN_AWAKE:
+            if(_radio->available()){
+                _state = NRF_LISTEN_AWAKE;
+                if((int32_t)(now + _hold - _until) > 0)
+                    _until = now + _hold;
+            }else if((int32_t)(now - _until) >= 0){
+                _rx_time += now - _since;
+                nrf_listen::sleep(now);
+            }
+            break;
+    }
+}
+
+/* rajada do transmissor */
+void nrf_listen::poll_transmitter(uint32_t now){
+    uint8_t status = _radio->get_last_status();
+    if(!(status & (TX_DS|MAX_RT))){
+        if(_radio->irq_idle(MASK_TX_DS|MASK_MAX_RT))
+            return;
+        status = _radio->get_status();
+    }
+    if(status & TX_DS){
+        _radio->clear_int_flag(NRF_TX_DS);
+        _state = NRF_LISTEN_WOKEN;
+    }else if(status & MAX_RT){
+        if((int32_t)(now - _until) < 0){
+            _radio->clear_int_flag(NRF_MAX_RT);    // o chip retransmite o mesmo payload
+        }else{
+            _radio->flush_tx_fifo();
+            _radio->clear_int_flag(NRF_MAX_RT);
+            _state = NRF_LISTEN_FAILED;
+        }
+    }
+}
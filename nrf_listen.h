@@ -0,0 +1,114 @@
+/**
+ * \file nrf_listen.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Recepção com ciclo de trabalho ('wake-on-radio')
+ * 
+ * O receptor (PRX) alterna o modo 'power down' (ou 'standby') com janelas curtas no modo 'rx',
+ * uma a cada período. Cada transição é uma escrita de CONFIG e um nível no pino CE (ver
+ * \ref nrf::begin_mode); a estabilização é aguardada sem bloquear, em \ref nrf_listen::poll.
+ * Ao receber um pacote, o receptor permanece no modo 'rx' até \ref nrf_listen::set_hold sem
+ * pacotes.
+ * 
+ * O transmissor (PTX) acorda o receptor com uma rajada: o mesmo pacote é retransmitido até
+ * ser confirmado, por até um período completo (ver \ref nrf_listen::send_wake). Após MAX_RT,
+ * a retransmissão é reiniciada apenas pela limpeza do flag, sem reescrever o payload.
+ * 
+ * O compromisso entre latência e consumo é definido pelos parâmetros de
+ * \ref nrf_listen::set_timing :
+ * \li latência máxima: período + partida do chip (ver \ref nrf_listen::get_latency)
+ * \li corrente média: proporcional à fração do período no modo 'rx' (ver
+ * \ref nrf_listen::get_current)
+ * 
+ * A janela deve ser maior que o intervalo entre as transmissões da rajada: o atraso de
+ * retransmissão (ARD), o tempo no ar do pacote e do ACK e, após cada MAX_RT, a estabilização
+ * do PLL. Com ARD de 250us a 2Mbps, janelas de 600us bastam.
+ * */
+
+#ifndef NRF_LISTEN_H
+#define NRF_LISTEN_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/** \brief Tempo padrão no modo 'rx' após o último pacote recebido (us) */
+#define NRF_LISTEN_HOLD         10000UL
+/** \brief Corrente no modo 'power down' (nA, datasheet) */
+#define NRF_LISTEN_I_POWER_DOWN 900UL
+/** \brief Corrente no modo 'standby-I' (nA, datasheet) */
+#define NRF_LISTEN_I_STANDBY    26000UL
+/** \brief Corrente média durante a partida do oscilador (nA, datasheet) */
+#define NRF_LISTEN_I_START      400000UL
+/** \brief Corrente no modo 'rx' a 2Mbps (nA, datasheet) */
+#define NRF_LISTEN_I_RX         13500000UL
+
+/**
+ * \brief Estado do ciclo de trabalho (ver \ref nrf_listen::poll)
+ * */
+typedef enum{
+    NRF_LISTEN_IDLE,        ///< Parado: sem ciclo de trabalho nem rajada
+    NRF_LISTEN_SLEEP,       ///< Receptor desligado até o próximo período
+    NRF_LISTEN_STARTING,    ///< Receptor aguardando a estabilização do chip
+    NRF_LISTEN_WINDOW,      ///< Janela de recepção
+    NRF_LISTEN_AWAKE,       ///< Pacote recebido: receptor no modo 'rx' até 'hold' sem pacotes
+    NRF_LISTEN_WAKING,      ///< Transmissor: rajada em andamento
+    NRF_LISTEN_WOKEN,       ///< Transmissor: rajada confirmada
+    NRF_LISTEN_FAILED       ///< Transmissor: rajada não confirmada após um período
+}nrf_listen_state_t;
+
+/**
+ * \brief Recepção com ciclo de trabalho (ver nrf_listen.h)
+ * 
+ * Exemplo (receptor, latência de até 100ms):
+ * \code
+ * nrf_listen listen(&radio);
+ * listen.set_timing(100000, 600);
+ * listen.listen();
+ * ...
+ * if(listen.poll() == NRF_LISTEN_AWAKE){
+ *     while(radio.read_received_payload(buff, &length))
+ *         ...
+ * }
+ * \endcode
+ * 
+ * Exemplo (transmissor, com os mesmos parâmetros):
+ * \code
+ * listen.send_wake(buff, length);
+ * while(listen.poll() == NRF_LISTEN_WAKING)
+ *     ;   // ou outras tarefas
+ * \endcode
+ * */
+class nrf_listen{
+public:
+    nrf_listen(nrf *radio);
+    void set_timing(uint32_t period_us, uint16_t window_us, bool deep=true);
+    void set_hold(uint32_t hold_us);
+    void listen(void);
+    void stop(void);
+    bool send_wake(const uint8_t *buff, uint8_t length);
+    nrf_listen_state_t poll(void);
+    void stay_awake(uint32_t us);
+    nrf_listen_state_t get_state(void);
+    uint32_t get_latency(void);
+    uint32_t get_current(void);
+    uint32_t get_rx_time(void);
+
+private:
+    nrf *_radio;
+    uint32_t _period; //período das janelas (us)
+    uint16_t _window; //duração das janelas no modo 'rx' (us)
+    bool _deep; //'power down' entre as janelas ('standby' se false)
+    uint32_t _hold; //tempo no modo 'rx' após o último pacote
+    uint32_t _startup; //partida do chip até o modo 'rx', medida a cada janela
+    uint8_t _state;
+    uint32_t _next; //micros() do início do próximo período
+    uint32_t _since; //micros() do início do estado atual
+    uint32_t _until; //micros() do fim da janela ou da rajada
+    uint32_t _rx_time; //tempo acumulado no modo 'rx' (us)
+    void sleep(uint32_t now);
+    void poll_receiver(uint32_t now);
+    void poll_transmitter(uint32_t now);
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * \file nrf_transport.cpp
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief código-fonte da camada de transporte
+ * */
+
+#include<string.h>
+#include "nrf_transport.h"
+
+/**
+ * \brief Construtor da camada de transporte
+ * 
+ * \param[in] *radio Dispositivo já configurado (endereços, canal, payload dinâmico)
+ */
+nrf_transport::nrf_transport(nrf *radio){
+    _radio = radio;
+    _id = 0;
+    _timeout = NRF_TRANSPORT_TIMEOUT;
+    _dropped = 0;
+    memset(_pipes, 0, sizeof(_pipes));
+}
+
+/**
+ * \brief Configura o buffer de remontagem de um pipe
+ * 
+ * Fragmentos recebidos em pipes sem buffer são descartados.
+ * 
+ * \param[in] pipe Pipe de recepção
+ * \param[in] *buff Buffer de remontagem. Deve permanecer válido enquanto a classe for utilizada.
+ * \param[in] size Tamanho do buffer (maior mensagem aceita no pipe)
+ */
+void nrf_transport::set_buffer(nrf_address_t pipe, uint8_t *buff, uint16_t size){
+    reassembly_t *r = &_pipes[(uint8_t)pipe];
+    r->buff = buff;
+    r->size = size;
+    r->next = 0;
+}
+
+/**
+ * \brief Configura o tempo máximo entre fragmentos de uma mensagem
+ * 
+ * \param[in] timeout Tempo em milissegundos (padrão: \ref NRF_TRANSPORT_TIMEOUT)
+ */
+void nrf_transport::set_timeout(uint16_t timeout){
+    _timeout = timeout;
+}
+
+/**
+ * \brief Envia uma mensagem
+ * 
+ * A mensagem é dividida em fragmentos de até \ref NRF_TRANSPORT_FRAGMENT bytes, enviados
+ * para o endereço de transmissão (ver \ref nrf::set_tx_address).
+ * 
+ * \param[in] *msg Mensagem
+ * \param[in] length Tamanho da mensagem (até 3840 bytes)
+ * 
+ * \return true ou false
+ * \retval true Todos os fragmentos foram confirmados
+ * \retval false Mensagem muito grande ou fragmento não confirmado (o receptor descarta a
+ * mensagem incompleta)
+ * 
+ * \warning Ao final, o dispositivo é colocado no modo 'standby'.
+ */
+bool nrf_transport::send(const uint8_t *msg, uint16_t length){
+    uint16_t fragments = (length + NRF_TRANSPORT_FRAGMENT - 1) / NRF_TRANSPORT_FRAGMENT;
+    if(fragments == 0)
+        fragments = 1;  // mensagem vazia: apenas o cabeçalho
+    if(fragments > NRF_TRANSPORT_MAX_FRAGMENTS)
+        return false;
+    
+    uint8_t frame[32];
+    bool sent = true;
+    _id++;
+    _radio->set_mode(NRF_TX_MODE);
+    for(uint16_t i=0; i<fragments && sent; i++){
+        uint16_t offset = i * NRF_TRANSPORT_FRAGMENT;
+        uint8_t size = (length - offset < NRF_TRANSPORT_FRAGMENT)? length - offset : NRF_TRANSPORT_FRAGMENT;
+        frame[0] = _id;
+        frame[1] = i | ((i == fragments - 1)? NRF_TRANSPORT_LAST : 0);
+        memcpy(&frame[NRF_TRANSPORT_HEADER], msg + offset, size);
+        if(!_radio->write_tx_payload(frame, size + NRF_TRANSPORT_HEADER)){
+            // FIFO cheio: aguarda o envio dos fragmentos anteriores
+            sent = _radio->wait_packet_sent() &&
+                   _radio->write_tx_payload(frame, size + NRF_TRANSPORT_HEADER);
+        }
+    }
+    if(sent)
+        sent = _radio->wait_packet_sent();
+    _radio->set_mode(NRF_STANDBY);
+    return sent;
+}
+
+/**
+ * \brief Processa os pacotes recebidos
+ * 
+ * Lê todos os pacotes disponíveis e retorna ao completar uma mensagem. A mensagem fica no
+ * buffer do pipe (ver \ref set_buffer) até a próxima chamada desta função.
+ * 
+ * \param[out] *pipe Pipe em que a mensagem foi recebida
+ * \param[out] *length Tamanho da mensagem
+ * 
+ * \return true se uma mensagem foi completada
+ * 
+ * \warning Antes de executar essa função coloque o dispositivo no modo recepção.
+ */
+bool nrf_transport::receive(uint8_t *pipe, uint16_t *length){
+    uint8_t frame[32], size, p;
+    nrf_transport::expire();
+    while(_radio->read_received_payload(frame, &size, &p)){
+        if(p < 6 && nrf_transport::fragment(p, frame, size)){
+            *pipe = p;
+            *length = _pipes[p].length;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Retorna o número de mensagens incompletas descartadas
+ * 
+ * Inclui mensagens com fragmentos perdidos, fora de ordem, maiores que o buffer do pipe
+ * ou que excederam o tempo máximo (ver \ref set_timeout).
+ */
+uint16_t nrf_transport::get_dropped(void){
+    return _dropped;
+}
+
+/* acrescenta um fragmento à mensagem do pipe. Retorna true se a mensagem foi completada */
+bool nrf_transport::fragment(uint8_t pipe, const uint8_t *frame, uint8_t length){
+    reassembly_t *r = &_pipes[pipe];
+    if(r->buff == NULL || length < NRF_TRANSPORT_HEADER)
+        return false;
+    
+    uint8_t index = frame[1] & ~NRF_TRANSPORT_LAST;
+    uint8_t size = length - NRF_TRANSPORT_HEADER;
+    if(index == 0){
+        if(r->next != 0)
+            _dropped++;     // mensagem anterior incompleta
+        r->id = frame[0];
+        r->length = 0;
+    }else if(r->next == 0 || frame[0] != r->id || index != r->next){
+        if(r->next != 0){
+            _dropped++;     // fragmento perdido
+            r->next = 0;
+        }
+        return false;
+    }
+    
+    if(r->length + size > r->size){
+        _dropped++;
+        r->next = 0;
+        return false;
+    }
+    memcpy(r->buff + r->length, &frame[NRF_TRANSPORT_HEADER], size);
+    r->length += size;
+    r->last_time = _radio->get_backend()->millis();
+    
+    if(frame[1] & NRF_TRANSPORT_LAST){
+        r->next = 0;
+        return true;
+    }
+    r->next = index + 1;
+    return false;
+}
+
+/* descarta as mensagens incompletas há mais de _timeout ms */
+void nrf_transport::expire(void){
+    uint32_t now = _radio->get_backend()->millis();
+    for(uint8_t i=0; i<6; i++){
+        reassembly_t *r = &_pipes[i];
+        if(r->next != 0 && (now - r->last_time) > _timeout){
+            _dropped++;
+            r->next = 0;
+        }
+    }
+}
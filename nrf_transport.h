@@ -0,0 +1,82 @@
+/**
+ * \file nrf_transport.h
+ * \author Khyale
+ * \version 1.0
+ * 
+ * \brief Camada de transporte: fragmentação e remontagem de mensagens
+ * 
+ * Mensagens maiores que 32 bytes são divididas em pacotes com um cabeçalho de 2 bytes:
+ * 
+ * \li byte 0: identificador da mensagem
+ * \li byte 1: índice do fragmento (bits 0 a 6) e flag de último fragmento (bit 7)
+ * 
+ * Cada pacote transporta até 30 bytes da mensagem, e uma mensagem tem no máximo 128
+ * fragmentos (3840 bytes). O receptor deve utilizar payload dinâmico.
+ * */
+
+#ifndef NRF_TRANSPORT_H
+#define NRF_TRANSPORT_H
+
+#include<stdint.h>
+#include "nrf.h"
+
+/** \brief Tamanho do cabeçalho de cada fragmento */
+#define NRF_TRANSPORT_HEADER    2
+/** \brief Bytes da mensagem em cada fragmento */
+#define NRF_TRANSPORT_FRAGMENT  (32 - NRF_TRANSPORT_HEADER)
+/** \brief Número máximo de fragmentos de uma mensagem */
+#define NRF_TRANSPORT_MAX_FRAGMENTS 128
+/** \brief Flag de último fragmento (byte 1 do cabeçalho) */
+#define NRF_TRANSPORT_LAST      0x80
+
+/**
+ * \brief Camada de transporte sobre a classe \ref nrf
+ * 
+ * As mensagens são remontadas em buffers fornecidos pela aplicação, um por pipe (ver
+ * \ref set_buffer), sem alocação dinâmica. Os fragmentos de uma mensagem devem chegar em
+ * ordem, o que é garantido pelo auto-ack com um único transmissor por pipe. Uma mensagem
+ * incompleta é descartada se o próximo fragmento não chegar em \ref NRF_TRANSPORT_TIMEOUT
+ * milissegundos.
+ * 
+ * Exemplo:
+ * \code
+ * nrf_transport link(&rfmodule);
+ * uint8_t buff[256];
+ * link.set_buffer(NRF_PIPE0, buff, sizeof(buff));
+ * ...
+ * uint8_t pipe;
+ * uint16_t length;
+ * if(link.receive(&pipe, &length))
+ *     process(buff, length);
+ * \endcode
+ * */
+class nrf_transport{
+public:
+    nrf_transport(nrf *radio);
+    void set_buffer(nrf_address_t pipe, uint8_t *buff, uint16_t size);
+    void set_timeout(uint16_t timeout);
+    bool send(const uint8_t *msg, uint16_t length);
+    bool receive(uint8_t *pipe, uint16_t *length);
+    uint16_t get_dropped(void);
+    
+private:
+    typedef struct{
+        uint8_t *buff;      // buffer de remontagem (fornecido pela aplicação)
+        uint16_t size;
+        uint16_t length;    // bytes já recebidos
+        uint8_t id;         // identificador da mensagem em remontagem
+        uint8_t next;       // próximo fragmento esperado (0: nenhuma mensagem em remontagem)
+        uint32_t last_time; // chegada do último fragmento (ms)
+    }reassembly_t;
+    
+    nrf *_radio;
+    uint8_t _id;
+    uint16_t _timeout;
+    uint16_t _dropped;
+    reassembly_t _pipes[6];
+    
+    bool fragment(uint8_t pipe, const uint8_t *frame, uint8_t length);
+    void expire(void);
+};
+
+#endif
@@ -1,31 +1,93 @@
-/**
- * \file spidrv.cpp
- * \author Khyale
- * \version 1.0
- * \date 24/12/2013
- * 
- * \brief código-fonte do driver SPI
- * */
-
-#include<Arduino.h>
-#include <SPI.h>
-#include "spidrv.h"
-
-void spi_begin(int spi_device){
-    pinMode(SCK, OUTPUT);
-    pinMode(MOSI, OUTPUT);
-    pinMode(MISO, INPUT);
-    pinMode(spi_device,OUTPUT);
-    digitalWrite(spi_device,HIGH);
-    SPI.setDataMode(SPI_MODE0);
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setClockDivider(SPI_CLOCK_DIV2); // 8MHz
-    SPI.begin();	
-}
-
-void spi_transfer(int spi_device, uint8_t *data, uint8_t length){
-    digitalWrite(spi_device, LOW);
-    while(length-->0)
-        *data++ = SPI.transfer(*data);
-    digitalWrite(spi_device, HIGH);
-}
+/**
+ * \file spidrv.cpp
+ * \author Khyale
+ * \version 1.0
+ * \date 24/12/2013
+ * 
+ * \brief código-fonte do driver SPI
+ * */
+
+#if defined(ARDUINO)
+
+#include<Arduino.h>
+#include <SPI.h>
+#include "spidrv.h"
+
+void spi_shift(const uint8_t *tx, uint8_t *rx, uint8_t length){
+    if(length == 0)
+        return;
+#if defined(__AVR__)
+    SPDR = (tx != NULL)? *tx++ : 0xFF;
+    while(--length > 0){
+        uint8_t out = (tx != NULL)? *tx++ : 0xFF;
+        while(!(SPSR & _BV(SPIF))){
+        }
+        uint8_t in = SPDR;
+        SPDR = out;
+        if(rx != NULL)
+            *rx++ = in;
+    }
+    while(!(SPSR & _BV(SPIF))){
+    }
+    uint8_t in = SPDR;
+    if(rx != NULL)
+        *rx = in;
+#else
+    if(tx != NULL && tx == rx){
+        SPI.transfer(rx, length);   // transferência em bloco, no próprio buffer
+        return;
+    }
+    for(uint8_t i=0; i<length; i++){
+        uint8_t in = SPI.transfer( (tx != NULL)? tx[i] : 0xFF );
+        if(rx != NULL)
+            rx[i] = in;
+    }
+#endif
+}
+
+void spi_pin_init(spi_pin_t *p, uint8_t pin){
+    p->pin = pin;
+#if defined(__AVR__)
+    p->port = portOutputRegister(digitalPinToPort(pin));
+    p->mask = digitalPinToBitMask(pin);
+#endif
+    pinMode(pin, OUTPUT);
+}
+
+void spi_begin(spi_device_t *device, uint8_t csn, uint32_t clock){
+    if(clock > SPI_MAX_CLOCK)
+        clock = SPI_MAX_CLOCK;
+    device->settings = SPISettings(clock, MSBFIRST, SPI_MODE0);
+    spi_pin_init(&device->csn, csn);
+    spi_pin_write(&device->csn, true);
+    
+    // vários dispositivos podem compartilhar a interface
+    static bool started = false;
+    if(!started){
+        SPI.begin();
+        started = true;
+    }
+}
+
+void spi_transfer(const spi_device_t *device, uint8_t *data, uint8_t length){
+    SPI.beginTransaction(device->settings);
+    spi_pin_write(&device->csn, false);
+    spi_shift(data, data, length);
+    spi_pin_write(&device->csn, true);
+    SPI.endTransaction();
+}
+
+void spi_transfer_segments(const spi_device_t *device, const spi_segment_t *segments, uint8_t count){
+    SPI.beginTransaction(device->settings);
+    spi_pin_write(&device->csn, false);
+    for(; count>0; count--, segments++)
+        spi_shift(segments->tx, segments->rx, segments->length);
+    spi_pin_write(&device->csn, true);
+    SPI.endTransaction();
+}
+
+void spi_using_interrupt(uint8_t interrupt_number){
+    SPI.usingInterrupt(interrupt_number);
+}
+
+#endif
@@ -1,32 +1,144 @@
-/**
- * \file spidrv.h
- * \author Khyale
- * \version 1.0
- * \date 24/12/2013
- * 
- * \brief arquivo de definições do driver SPI
- * */
-
-#ifndef SPIDRV_H
-#define SPIDRV_H
-
-#include<stdint.h>
-/** 
- * \brief Configura e inicia interface SPI
- * 
- * \param [in] spi_device Pino associado ao Serial Select (SS) do dispositivo escravo.
- * */
-void spi_begin(int spi_device);
-
-/**
- * Envia/Recebe dados da inteface SPI
- * 
- * Utilize esta função para ler ou escrever em dispositivo através da intervace SPI.
- * 
- * @param[in] spi_device Pinagem atribuida ao chip select do dispositivo escravo.
- * @param[in,out] *data Ponteiro de leitura e escrida dos dados. Os dados são sobrescritos.
- * @param[in] length Tamanho do buffer.
- * 
- * */
-void spi_transfer(int spi_device, uint8_t *data, uint8_t length);
-#endif
+/**
+ * \file spidrv.h
+ * \author Khyale
+ * \version 1.0
+ * \date 24/12/2013
+ * 
+ * \brief arquivo de definições do driver SPI
+ * */
+
+#ifndef SPIDRV_H
+#define SPIDRV_H
+
+#include<stdint.h>
+#include<Arduino.h>
+#include<SPI.h>
+#include "nrf_backend.h"
+
+/** \brief Frequência máxima do clock SPI suportada pelo nRF24L01+ (Hz) */
+#define SPI_MAX_CLOCK   10000000UL
+
+/**
+ * \brief Pino de saída com acesso direto ao registrador da porta
+ * 
+ * Nos microcontroladores AVR, o registrador de saída e a máscara do pino são obtidos uma única
+ * vez, em \ref spi_pin_init . Nas demais plataformas é utilizado digitalWrite.
+ * */
+typedef struct{
+    uint8_t pin;                ///< Pino do Arduino
+#if defined(__AVR__)
+    volatile uint8_t *port;     ///< Registrador de saída da porta
+    uint8_t mask;               ///< Máscara do pino na porta
+#endif
+}spi_pin_t;
+
+/**
+ * \brief Dispositivo escravo SPI
+ * */
+typedef struct{
+    spi_pin_t csn;          ///< Pino de chip select
+    SPISettings settings;   ///< Clock, ordem dos bits e modo SPI
+}spi_device_t;
+
+/**
+ * \brief Configura pino de saída
+ * 
+ * \param [out] *p Descritor do pino
+ * \param [in] pin Pino do Arduino
+ * */
+void spi_pin_init(spi_pin_t *p, uint8_t pin);
+
+/**
+ * \brief Altera o nível lógico do pino de saída
+ * 
+ * \param [in] *p Descritor do pino (ver \ref spi_pin_init)
+ * \param [in] high Nível lógico
+ * */
+static inline void spi_pin_write(const spi_pin_t *p, bool high){
+#if defined(__AVR__)
+    uint8_t sreg = SREG;    // a escrita na porta não é atômica
+    cli();
+    if(high)
+        *p->port |= p->mask;
+    else
+        *p->port &= ~p->mask;
+    SREG = sreg;
+#else
+    digitalWrite(p->pin, high? HIGH:LOW);
+#endif
+}
+
+/**
+ * \brief Retorna o nível lógico escrito no pino de saída
+ * 
+ * \param [in] *p Descritor do pino (ver \ref spi_pin_init)
+ * */
+static inline bool spi_pin_is_high(const spi_pin_t *p){
+#if defined(__AVR__)
+    return (*p->port & p->mask) != 0;
+#else
+    return digitalRead(p->pin) == HIGH;
+#endif
+}
+
+/**
+ * \brief Configura e inicia interface SPI
+ * 
+ * Pode ser chamada para vários dispositivos no mesmo barramento: a interface é iniciada uma única
+ * vez e cada dispositivo mantém seu próprio clock (aplicado a cada transação).
+ * 
+ * \param [out] *device Descritor do dispositivo escravo
+ * \param [in] csn Pino associado ao Serial Select (SS) do dispositivo escravo.
+ * \param [in] clock Frequência do clock SPI em Hz (limitada a \ref SPI_MAX_CLOCK).
+ * */
+void spi_begin(spi_device_t *device, uint8_t csn, uint32_t clock);
+
+/**
+ * Envia/Recebe dados da inteface SPI
+ * 
+ * Utilize esta função para ler ou escrever em dispositivo através da intervace SPI.
+ * 
+ * @param[in] *device Descritor do dispositivo escravo (ver \ref spi_begin).
+ * @param[in,out] *data Ponteiro de leitura e escrida dos dados. Os dados são sobrescritos.
+ * @param[in] length Tamanho do buffer.
+ * 
+ * */
+void spi_transfer(const spi_device_t *device, uint8_t *data, uint8_t length);
+
+/**
+ * Envia/Recebe vários segmentos de dados numa única seleção do dispositivo escravo
+ * 
+ * Utilize esta função para transferir um comando e seus dados diretamente de/para buffers
+ * distintos, sem cópias intermediárias.
+ * 
+ * @param[in] *device Descritor do dispositivo escravo (ver \ref spi_begin).
+ * @param[in] *segments Vetor de segmentos, transferidos em sequência.
+ * @param[in] count Número de segmentos.
+ * 
+ * */
+void spi_transfer_segments(const spi_device_t *device, const spi_segment_t *segments, uint8_t count);
+
+/**
+ * \brief Transfere um bloco de dados, com o dispositivo escravo já selecionado
+ * 
+ * Nos microcontroladores AVR, o próximo byte é carregado enquanto o byte
+ * atual é deslocado no registrador SPDR. Utilizada por drivers que controlam o pino de
+ * CSN diretamente (ver \ref nrf_fixed_backend).
+ * 
+ * @param[in] *tx Dados enviados ou NULL (envia 0xFF).
+ * @param[out] *rx Dados recebidos ou NULL (descartados). Pode ser igual a 'tx'.
+ * @param[in] length Tamanho do bloco.
+ * 
+ * */
+void spi_shift(const uint8_t *tx, uint8_t *rx, uint8_t length);
+
+/**
+ * \brief Registra interrupção externa que acessa a interface SPI
+ * 
+ * Utilize esta função quando uma rotina de interrupção realizar transferências SPI. A interrupção
+ * é mascarada durante as transferências realizadas fora dela (ver SPI.usingInterrupt).
+ * 
+ * @param[in] interrupt_number Número da interrupção externa (ver digitalPinToInterrupt).
+ * */
+void spi_using_interrupt(uint8_t interrupt_number);
+#endif
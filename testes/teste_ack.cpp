@@ -0,0 +1,55 @@
+/*
+ * Payloads no ACK: resposta do PRX no ACK do pacote recebido.
+ */
+#include "testes.h"
+
+void test_ack_payload(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t buff[32], length, pipe;
+
+    printf("payload no ACK\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    ptx.enable_ack_payload(true);
+    prx.enable_ack_payload(true);
+    prx.set_mode(NRF_RX_MODE);
+
+    // o PTX envia ao endereco do pipe 1 do PRX
+    CHECK(prx.write_ack_payload(NRF_PIPE1, (const uint8_t*)"resposta", 8));
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+
+    CHECK(ptx.read_ack_payload(buff, &length));
+    CHECK(length == 8 && memcmp(buff, "resposta", 8) == 0);
+    CHECK(!ptx.read_ack_payload(buff, &length));
+    CHECK(prx.read_received_payload(buff, &length, &pipe));
+    CHECK(length == 6 && pipe == NRF_PIPE1 && memcmp(buff, "pedido", 6) == 0);
+
+    // sem payload pendente, o ACK e vazio
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+    CHECK(!ptx.read_ack_payload(buff, &length));
+
+    // payloads descartados nao sao enviados
+    CHECK(prx.write_ack_payload(NRF_PIPE1, (const uint8_t*)"antigo", 6));
+    prx.flush_ack_payloads();
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+    CHECK(!ptx.read_ack_payload(buff, &length));
+
+    // o payload de outro pipe nao e enviado; o FIFO de ACK tem tres niveis
+    while(prx.read_received_payload(buff, &length));
+    CHECK(prx.write_ack_payload(NRF_PIPE0, (const uint8_t*)"pipe0", 5));
+    CHECK(prx.write_ack_payload(NRF_PIPE1, (const uint8_t*)"a", 1));
+    CHECK(prx.write_ack_payload(NRF_PIPE1, (const uint8_t*)"b", 1));
+    CHECK(!prx.write_ack_payload(NRF_PIPE1, (const uint8_t*)"c", 1));
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+    CHECK(ptx.read_ack_payload(buff, &length) && length == 1 && buff[0] == 'a');
+    while(prx.read_received_payload(buff, &length));
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+    CHECK(ptx.read_ack_payload(buff, &length) && length == 1 && buff[0] == 'b');
+    while(prx.read_received_payload(buff, &length));
+    CHECK(send_packet(&ptx, (const uint8_t*)"pedido", 6));
+    CHECK(!ptx.read_ack_payload(buff, &length));
+}
@@ -0,0 +1,74 @@
+/*
+ * send_async/poll: janela de envios assincronos com funcoes de retorno.
+ */
+#include "testes.h"
+
+static uint8_t async_sent[8], async_sent_count;
+static uint8_t async_failed[8], async_failed_retries[8], async_failed_count;
+
+static void async_on_sent(uint8_t handle){
+    if(async_sent_count < sizeof(async_sent))
+        async_sent[async_sent_count++] = handle;
+}
+
+static void async_on_failed(uint8_t handle, uint8_t retries){
+    if(async_failed_count < sizeof(async_failed)){
+        async_failed_retries[async_failed_count] = retries;
+        async_failed[async_failed_count++] = handle;
+    }
+}
+
+static void async_wait(nrf_air *air, nrf *ptx, uint8_t events){
+    for(uint16_t i=0; i<10000 && async_sent_count + async_failed_count < events; i++){
+        ptx->poll();
+        air->advance(10);
+    }
+}
+
+void test_send_async(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t buff[32], length;
+
+    printf("send_async/poll\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    ptx.on_sent(async_on_sent);
+    ptx.on_failed(async_on_failed);
+    prx.set_mode(NRF_RX_MODE);
+
+    async_sent_count = 0;
+    async_failed_count = 0;
+    int16_t first = ptx.send_async((const uint8_t*)"um", 2);
+    int16_t second = ptx.send_async((const uint8_t*)"dois", 4);
+    CHECK(first != NRF_NO_HANDLE);
+    CHECK(second != NRF_NO_HANDLE && second != first);
+    CHECK(ptx.send_async((const uint8_t*)"tres", 4) == NRF_NO_HANDLE);    // NRF_TX_WINDOW
+
+    async_wait(&air, &ptx, 2);
+    CHECK(async_sent_count == 2);
+    CHECK(async_failed_count == 0);
+    CHECK(async_sent[0] == (uint8_t)first && async_sent[1] == (uint8_t)second);
+
+    CHECK(prx.read_received_payload(buff, &length) && length == 2 && memcmp(buff, "um", 2) == 0);
+    CHECK(prx.read_received_payload(buff, &length) && length == 4 && memcmp(buff, "dois", 4) == 0);
+    CHECK(!prx.read_received_payload(buff, &length));
+
+    // sem receptor: o primeiro payload atinge MAX_RT e o seguinte e descartado sem transmissao
+    prx.set_mode(NRF_STANDBY);
+    async_sent_count = 0;
+    async_failed_count = 0;
+    first = ptx.send_async((const uint8_t*)"um", 2);
+    second = ptx.send_async((const uint8_t*)"dois", 4);
+    async_wait(&air, &ptx, 2);
+    CHECK(async_sent_count == 0);
+    CHECK(async_failed_count == 2);
+    CHECK(async_failed[0] == (uint8_t)first && async_failed_retries[0] == 15);
+    CHECK(async_failed[1] == (uint8_t)second && async_failed_retries[1] == 0);
+
+    // a janela e liberada apos a falha
+    CHECK(ptx.send_async((const uint8_t*)"um", 2) != NRF_NO_HANDLE);
+}
@@ -0,0 +1,57 @@
+/*
+ * Beacon: payload reutilizado (REUSE_TX_PL), um pulso de CE por envio.
+ */
+#include "testes.h"
+
+void test_beacon(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t payload[8] = {1,2,3,4,5,6,7,8};
+    uint8_t buff[32], length;
+
+    printf("beacon\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    prx.set_mode(NRF_RX_MODE);
+
+    // intervalo menor que a estabilizacao do PLL (130us) somada a transmissao
+    CHECK(!ptx.start_beacon(payload, 8, 5, 150));
+    CHECK(!ptx.get_tx_reuse());
+    ptx.set_settle_times(NRF_POWER_UP_DELAY, 20);
+    CHECK(ptx.start_beacon(payload, 8, 5, 150));
+    ptx.stop_beacon();
+    ptx.set_settle_times(NRF_POWER_UP_DELAY, NRF_SETTLE_DELAY);
+
+    // cinco envios sem transferencias SPI entre eles; o pino de IRQ permanece inativo
+    ptx.set_irq_pin(2);
+    CHECK(ptx.start_beacon(payload, 8, 5, 1000));
+    CHECK(ptx.get_tx_reuse());
+    uint32_t transactions = ptx_chip.get_transactions();
+    int received = 0;
+    bool irq = false;
+    while(ptx.poll_beacon()){
+        air.advance(100);
+        if(!ptx_chip.read_irq())
+            irq = true;
+        while(prx.read_received_payload(buff, &length)){
+            if(length == 8 && memcmp(buff, payload, 8) == 0)
+                received++;
+        }
+    }
+    CHECK(received == 5);
+    CHECK(!irq);
+    CHECK(ptx_chip.get_transactions() - transactions <= 4);    // apenas stop_beacon
+    CHECK(!ptx.get_tx_reuse());
+
+    // apos o beacon, TX_DS volta a acionar o pino de IRQ
+    ptx.write_tx_payload(payload, 8);
+    ptx.set_mode(NRF_TX_MODE);
+    air.advance(1000);
+    CHECK(!ptx_chip.read_irq());
+    ptx.set_mode(NRF_STANDBY);
+    ptx.clear_all_int_flags();
+    CHECK(ptx_chip.read_irq());
+}
@@ -0,0 +1,56 @@
+/*
+ * Emulador: entrega no meio de transmissao, perdas, pacotes duplicados e FIFO de recepcao.
+ */
+#include "testes.h"
+
+void test_emulator(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t buff[32], length, pipe;
+    int sent = 0, received = 0, wrong = 0;
+
+    printf("emulador\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    prx.set_mode(NRF_RX_MODE);
+
+    // com perdas (dados e ACKs), cada pacote confirmado e recebido uma unica vez, em ordem
+    air.set_loss(25, 20);
+    for(int i=0; i<100; i++){
+        length = sprintf((char*)buff, "pacote %d", i);
+        if(send_packet(&ptx, buff, length))
+            sent++;
+        while(prx.read_received_payload(buff, &length, &pipe)){
+            buff[length] = 0;
+            char expected[16];
+            sprintf(expected, "pacote %d", received);
+            if(pipe != NRF_PIPE1 || strcmp((char*)buff, expected) != 0)
+                wrong++;
+            received++;
+        }
+    }
+    CHECK(sent == 100);
+    CHECK(received == 100);
+    CHECK(wrong == 0);
+
+    // outro canal: nada e recebido
+    air.set_loss(25, 0);
+    prx.set_rf_channel(30);
+    prx.set_mode(NRF_RX_MODE);
+    CHECK(!send_packet(&ptx, (const uint8_t*)"x", 1));
+    CHECK(!prx.available());
+
+    // FIFO de recepcao com tres niveis: o quarto pacote nao e confirmado
+    prx.set_rf_channel(25);
+    prx.set_mode(NRF_RX_MODE);
+    for(uint8_t i=0; i<3; i++)
+        CHECK(send_packet(&ptx, &i, 1));
+    uint8_t fourth = 3;
+    CHECK(!send_packet(&ptx, &fourth, 1));
+    for(uint8_t i=0; i<3; i++)
+        CHECK(prx.read_received_payload(buff, &length) && length == 1 && buff[0] == i);
+    CHECK(!prx.read_received_payload(buff, &length));
+}
@@ -0,0 +1,78 @@
+/*
+ * nrf_hopper: sincronizacao por beacon e saltos de canal.
+ */
+#include "testes.h"
+#include "nrf_hopper.h"
+
+static const uint8_t hop_channels[8] = {2, 14, 26, 40, 52, 64, 76, 90};
+
+static void hop_configure(nrf *radio){
+    radio->set_rf_datarate(NRF_2MBPS);
+    radio->set_address_width(NRF_AW_5BYTES);
+    radio->set_retr_param(3, 0);
+    radio->enable_rx_pipe(NRF_PIPE0, true);
+    radio->set_dynamic_payload(NRF_PIPE0, true);
+    radio->set_rx_address(NRF_PIPE0, (uint8_t*)prx_addr, 5);
+    radio->set_tx_address((uint8_t*)prx_addr, 5);
+}
+
+void test_hopper(void){
+    nrf_air air;
+    nrf_emu master_chip(&air), follower_chip(&air);
+    nrf master_radio(&master_chip), follower_radio(&follower_chip);
+    nrf_hopper master(&master_radio), follower(&follower_radio);
+    uint8_t buff[32], length;
+
+    printf("nrf_hopper\n");
+    wait_ready(&air, &master_radio);
+    wait_ready(&air, &follower_radio);
+    hop_configure(&master_radio);
+    hop_configure(&follower_radio);
+    master.begin(hop_channels, 8, 0x5EED, 10000, true);
+    follower.begin(hop_channels, 8, 0x5EED, 10000, false);
+    CHECK(master.is_synced());
+    CHECK(!follower.is_synced());
+    CHECK(follower.get_channel() == hop_channels[0]);
+
+    // o seguidor aguarda um 'beacon' no canal de encontro
+    for(uint16_t i=0; i<20000 && !follower.is_synced(); i++){
+        master.poll();
+        follower.poll();
+        follower.read(buff, &length);
+        air.advance(50);
+    }
+    CHECK(follower.is_synced());
+
+    // sincronizados: mesmo intervalo e mesmo canal
+    uint16_t delivered = 0, received = 0, mismatches = 0;
+    uint32_t last_slot = master.get_slot();
+    for(uint16_t i=0; i<4000; i++){
+        master.poll();
+        follower.poll();
+        // o seguidor le os 'beacons' logo apos a recepcao: o atraso da leitura atrasa o relogio
+        while(follower.read(buff, &length)){
+            if(length == 5 && memcmp(buff, "dados", 5) == 0)
+                received++;
+        }
+        if(master.get_slot() != last_slot && master.can_transmit()){
+            last_slot = master.get_slot();
+            if(master.get_slot() != follower.get_slot() || master.get_channel() != follower.get_channel())
+                mismatches++;
+            CHECK(master_radio.write_tx_payload((uint8_t*)"dados", 5));
+            bool sent = master_radio.wait_packet_sent();
+            master.report(sent);
+            if(sent)
+                delivered++;
+        }
+        air.advance(50);
+    }
+    while(follower.read(buff, &length)){
+        if(length == 5 && memcmp(buff, "dados", 5) == 0)
+            received++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(delivered >= 10);
+    CHECK(received == delivered);
+    CHECK(follower.is_synced());
+    CHECK(master.get_excluded() == 0);
+}
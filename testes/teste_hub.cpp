@@ -0,0 +1,97 @@
+/*
+ * nrf_hub: entrada de nos, leitura por no e troca de pipes.
+ */
+#include "testes.h"
+#include "nrf_hub.h"
+
+static const uint8_t hub_base[5] = {0x00,0xC2,0xC2,0xC2,0xC2};
+static const uint8_t hub_join[5] = {0xE7,0xE7,0xE7,0xE7,0xE7};
+
+/* envia um pacote ao endereco, com auto-ack (o pipe0 recebe o ACK) */
+static bool node_send(nrf *node, const uint8_t *addr, const uint8_t *buff, uint8_t length){
+    node->set_tx_address((uint8_t*)addr, 5);
+    node->set_rx_address(NRF_PIPE0, (uint8_t*)addr, 5);
+    if(!node->write_tx_payload((uint8_t*)buff, length))
+        return false;
+    node->set_mode(NRF_TX_MODE);
+    bool sent = node->wait_packet_sent();
+    node->set_mode(NRF_STANDBY);
+    return sent;
+}
+
+void test_hub(void){
+    nrf_air air;
+    nrf_emu hub_chip(&air), node_chip(&air);
+    nrf radio(&hub_chip), node(&node_chip);
+    nrf_hub hub(&radio);
+    uint8_t buff[32], length, reply[32], reply_length, id;
+    uint8_t addr[5];
+    const uint32_t uid = 0x7A000001UL;
+
+    printf("nrf_hub\n");
+    wait_ready(&air, &radio);
+    wait_ready(&air, &node);
+    radio.set_rf_datarate(NRF_1MBPS);
+    radio.set_rf_channel(40);
+    hub.begin(hub_base, hub_join);
+
+    node.set_rf_datarate(NRF_1MBPS);
+    node.set_rf_channel(40);
+    node.set_address_width(NRF_AW_5BYTES);
+    node.set_retr_param(5, 1);
+    node.enable_rx_pipe(NRF_PIPE0, true);
+    node.set_dynamic_payload(NRF_PIPE0, true);
+    node.enable_ack_payload(true);
+
+    // entrada: o endereco chega no ACK de um pedido seguinte
+    uint8_t request[5] = {NRF_HUB_JOIN, (uint8_t)uid, (uint8_t)(uid >> 8), (uint8_t)(uid >> 16), (uint8_t)(uid >> 24)};
+    bool joined = false;
+    for(uint8_t i=0; i<10 && !joined; i++){
+        if(node_send(&node, hub_join, request, sizeof(request))){
+            while(node.read_ack_payload(reply, &reply_length)){
+                if(reply_length == 10 && reply[0] == NRF_HUB_ASSIGN && !memcmp(&reply[1], &request[1], 4)){
+                    memcpy(addr, &reply[5], 5);
+                    joined = true;
+                }
+            }
+        }
+        hub.poll();
+        air.advance(2000);
+    }
+    CHECK(joined);
+    int16_t index = hub.find(uid);
+    CHECK(index >= 0);
+    CHECK(hub.count() == 1);
+    CHECK(hub.get_node(index) != NULL && hub.get_node(index)->pipe != NRF_HUB_NO_PIPE);
+    CHECK(addr[0] == NRF_HUB_FIRST_LSB + index && memcmp(&addr[1], &hub_base[1], 4) == 0);
+
+    CHECK(node_send(&node, addr, (const uint8_t*)"leitura", 7));
+    hub.poll();
+    CHECK(hub.read(buff, &length, &id));
+    CHECK(length == 7 && id == index && memcmp(buff, "leitura", 7) == 0);
+    CHECK(hub.get_node(index)->received == 1);
+    while(node.read_ack_payload(reply, &reply_length));
+
+    // com mais de cinco nos, o ultimo fica fora dos pipes ate pedir um pipe
+    for(uint32_t i=2; i<=6; i++){
+        CHECK(hub.add(0x7A000000UL + i) >= 0);
+        hub.poll();
+    }
+    int16_t last = hub.find(0x7A000006UL);
+    CHECK(hub.count() == 6);
+    CHECK(hub.get_node(last)->pipe == NRF_HUB_NO_PIPE);
+
+    hub.get_address(last, addr);
+    CHECK(!node_send(&node, addr, (const uint8_t*)"fora", 4));
+    uint8_t wake[2] = {NRF_HUB_WAKE, addr[0]};
+    CHECK(node_send(&node, hub_join, wake, 2));
+    hub.poll();
+    CHECK(hub.get_node(last)->pipe != NRF_HUB_NO_PIPE);
+    air.advance(1000);     // estabilizacao do modo 'rx' apos a troca
+
+    CHECK(node_send(&node, addr, (const uint8_t*)"dentro", 6));
+    hub.poll();
+    CHECK(hub.read(buff, &length, &id));
+    CHECK(length == 6 && id == last && memcmp(buff, "dentro", 6) == 0);
+    CHECK(!hub.read(buff, &length, &id));
+}
@@ -0,0 +1,46 @@
+/*
+ * Recepcao por interrupcao: buffer circular preenchido pela rotina do pino de IRQ.
+ */
+#include "testes.h"
+
+void test_rx_interrupt(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t buff[32], length, pipe;
+
+    printf("recepcao por interrupcao\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    CHECK(!prx.enable_rx_interrupt());      // sem pino de IRQ
+    prx.set_irq_pin(2);
+    prx.set_mode(NRF_RX_MODE);
+    CHECK(prx.enable_rx_interrupt());
+
+    // mais pacotes que o FIFO do chip: a rotina os copia para o buffer circular
+    for(uint8_t i=0; i<NRF_RX_RING_SIZE; i++)
+        CHECK(send_packet(&ptx, &i, 1));
+    for(uint8_t i=0; i<NRF_RX_RING_SIZE; i++){
+        CHECK(prx.available());
+        CHECK(prx.read_received_payload(buff, &length, &pipe));
+        CHECK(length == 1 && buff[0] == i && pipe == NRF_PIPE1);
+    }
+    CHECK(!prx.available());
+    CHECK(prx.get_rx_overruns() == 0);
+
+    // buffer cheio: os pacotes seguintes sao confirmados e descartados
+    for(uint8_t i=0; i<NRF_RX_RING_SIZE + 2; i++)
+        CHECK(send_packet(&ptx, &i, 1));
+    CHECK(prx.get_rx_overruns() == 2);
+    for(uint8_t i=0; i<NRF_RX_RING_SIZE; i++)
+        CHECK(prx.read_received_payload(buff, &length) && buff[0] == i);
+    CHECK(!prx.read_received_payload(buff, &length));
+
+    // sem interrupcao, os pacotes voltam a ser lidos do FIFO do chip
+    prx.disable_rx_interrupt();
+    uint8_t value = 0x5A;
+    CHECK(send_packet(&ptx, &value, 1));
+    CHECK(prx.read_received_payload(buff, &length) && length == 1 && buff[0] == 0x5A);
+}
@@ -0,0 +1,84 @@
+/*
+ * nrf_link: ajuste do ARD e da taxa de dados a partir de resultados sinteticos (report).
+ */
+#include "testes.h"
+#include "nrf_link.h"
+
+static uint8_t link_changes;
+static nrf_datarate_t link_rate;
+
+static bool link_on_rate(uint8_t dest, nrf_datarate_t rate){
+    (void)dest;
+    link_changes++;
+    link_rate = rate;
+    return true;
+}
+
+/* informa 'count' envios iguais; retorna o numero de envios ate a primeira mudanca de taxa */
+static uint16_t link_report(nrf_link *link, uint8_t dest, uint16_t count, bool delivered, uint8_t retries){
+    uint8_t changes = link_changes;
+    for(uint16_t i=0; i<count; i++){
+        link->report(dest, delivered, retries);
+        if(link_changes != changes)
+            return i + 1;
+    }
+    return count;
+}
+
+void test_link(void){
+    nrf_air air;
+    nrf_emu chip(&air);
+    nrf radio(&chip);
+    nrf_link link(&radio);
+
+    printf("nrf_link\n");
+    wait_ready(&air, &radio);
+    configure(&radio, ptx_addr, prx_addr);
+    link.set_latency_target(10000);
+    int8_t dest = link.add(prx_addr);
+    CHECK(dest == 0);
+    link.select(dest, 32);
+    const nrf_link_dest_t *d = link.get_destination(dest);
+    CHECK(d->datarate == NRF_2MBPS && d->backoff == 0 && d->probe == NRF_LINK_PROBE_MIN);
+
+    // retransmissoes frequentes: o ARD cresce ate o limite; sem retransmissoes, volta ao minimo
+    link_report(&link, dest, 200, true, 5);
+    CHECK(d->backoff == NRF_LINK_MAX_BACKOFF);
+    CHECK(d->datarate == NRF_2MBPS);    // sem on_rate_change
+    link.select(dest, 32);
+    CHECK(radio.get_retr_param() >> 4 == NRF_LINK_MAX_BACKOFF);
+    link_report(&link, dest, 200, true, 0);
+    CHECK(d->backoff == 0);
+    link.select(dest, 32);
+    CHECK(radio.get_retr_param() >> 4 == 0);
+
+    // perdas: a taxa e reduzida apos quatro falhas consecutivas
+    link.on_rate_change(link_on_rate);
+    link_changes = 0;
+    link_report(&link, dest, NRF_LINK_MIN_SAMPLES, true, 1);
+    CHECK(link_report(&link, dest, 10, false, 0) == 4);
+    CHECK(link_changes == 1 && link_rate == NRF_1MBPS);
+    CHECK(d->datarate == NRF_1MBPS && d->loss == 0 && d->backoff == 0);
+    CHECK(d->probe == NRF_LINK_PROBE_MIN);
+    link.select(dest, 32);
+    CHECK(radio.get_rf_datarate() == NRF_1MBPS);
+
+    // sem retransmissoes, a taxa seguinte e tentada apos 'probe' envios
+    CHECK(link_report(&link, dest, 1000, true, 0) == NRF_LINK_PROBE_MIN);
+    CHECK(link_rate == NRF_2MBPS && d->raised);
+
+    // a taxa aumentada nao se mantem: o intervalo entre tentativas dobra
+    link_report(&link, dest, NRF_LINK_MIN_SAMPLES, true, 0);
+    link_report(&link, dest, 10, false, 0);
+    CHECK(link_rate == NRF_1MBPS && d->probe == 2 * NRF_LINK_PROBE_MIN);
+    CHECK(link_report(&link, dest, 1000, true, 0) == 2 * NRF_LINK_PROBE_MIN);
+    link_report(&link, dest, NRF_LINK_MIN_SAMPLES, true, 0);
+    link_report(&link, dest, 10, false, 0);
+    CHECK(d->probe == 4 * NRF_LINK_PROBE_MIN);
+
+    // reducao apos um periodo estavel na taxa aumentada: o intervalo volta ao minimo
+    CHECK(link_report(&link, dest, 1000, true, 0) == 4 * NRF_LINK_PROBE_MIN);
+    link_report(&link, dest, 4 * NRF_LINK_PROBE_MIN, true, 0);
+    link_report(&link, dest, 10, false, 0);
+    CHECK(link_rate == NRF_1MBPS && d->probe == NRF_LINK_PROBE_MIN);
+}
@@ -0,0 +1,81 @@
+/*
+ * nrf_listen: receptor com ciclo de trabalho acordado pela rajada do transmissor.
+ */
+#include "testes.h"
+#include "nrf_listen.h"
+
+/* executa a rajada ate o fim; retorna a duracao (us) */
+static uint32_t listen_wake(nrf_air *air, nrf_listen *ptx, nrf_listen *prx, const char *text){
+    uint64_t start = air->now_ns();
+    if(!ptx->send_wake((const uint8_t*)text, strlen(text)))
+        return 0;
+    for(uint32_t i=0; i<100000 && ptx->poll() == NRF_LISTEN_WAKING; i++){
+        prx->poll();
+        air->advance(10);
+    }
+    return (uint32_t)((air->now_ns() - start) / 1000);
+}
+
+void test_listen(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    nrf_listen waker(&ptx), listener(&prx);
+    uint8_t buff[32], length;
+
+    printf("nrf_listen\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    ptx.set_retr_param(15, 0);
+    waker.set_timing(20000, 600);
+    listener.set_timing(20000, 600);
+
+    // sem rajada: o receptor fica no modo 'rx' apenas nas janelas
+    listener.listen();
+    for(uint32_t i=0; i<10000; i++){
+        listener.poll();
+        air.advance(10);
+    }
+    CHECK(listener.get_rx_time() > 4 * 600 && listener.get_rx_time() < 6 * 700);
+    CHECK(listener.get_state() != NRF_LISTEN_AWAKE);
+
+    // a rajada iniciada em qualquer ponto do ciclo acorda o receptor em ate get_latency()
+    uint32_t worst = 0;
+    bool woken = true, received = true;
+    for(uint8_t i=0; i<5; i++){
+        for(uint32_t t=0; t<(uint32_t)i * 370; t += 10){
+            listener.poll();
+            air.advance(10);
+        }
+        uint32_t elapsed = listen_wake(&air, &waker, &listener, "acorde");
+        if(elapsed > worst)
+            worst = elapsed;
+        woken = woken && waker.get_state() == NRF_LISTEN_WOKEN;
+        received = received && listener.poll() == NRF_LISTEN_AWAKE &&
+                   prx.read_received_payload(buff, &length) && length == 6 &&
+                   memcmp(buff, "acorde", 6) == 0;
+        while(prx.read_received_payload(buff, &length));
+        // o receptor volta ao ciclo apos 'hold' sem pacotes
+        for(uint32_t t=0; t<NRF_LISTEN_HOLD + 1000; t += 10){
+            listener.poll();
+            air.advance(10);
+        }
+    }
+    CHECK(woken);
+    CHECK(received);
+    CHECK(worst > 0 && worst <= waker.get_latency());
+    CHECK(listener.get_state() != NRF_LISTEN_AWAKE);
+    waker.stop();
+
+    // receptor parado: a rajada falha apos um periodo e o FIFO de TX e descarregado
+    listener.stop();
+    prx.set_mode(NRF_POWER_DOWN);
+    uint32_t elapsed = listen_wake(&air, &waker, &listener, "acorde");
+    CHECK(waker.get_state() == NRF_LISTEN_FAILED);
+    CHECK(elapsed >= waker.get_latency());
+    CHECK(!prx.available());
+    CHECK(waker.send_wake((const uint8_t*)"x", 1));
+    waker.stop();
+}
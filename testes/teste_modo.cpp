@@ -0,0 +1,64 @@
+/*
+ * Transicoes de modo sem bloqueio: begin_mode, is_ready e set_settle_times.
+ */
+#include "testes.h"
+
+/* tempo ate o dispositivo ficar pronto, em passos de 10us */
+static uint32_t time_to_ready(nrf_air *air, nrf *radio){
+    uint64_t start = air->now_ns();
+    while(!radio->is_ready())
+        air->advance(10);
+    return (uint32_t)((air->now_ns() - start) / 1000);
+}
+
+void test_begin_mode(void){
+    nrf_air air;
+    nrf_emu chip(&air);
+    nrf radio(&chip);
+
+    printf("begin_mode\n");
+
+    // nenhum acesso SPI antes do fim do 'power on reset'
+    CHECK(!radio.is_ready());
+    CHECK(chip.get_transactions() == 0);
+    uint32_t elapsed = time_to_ready(&air, &radio);
+    CHECK(elapsed + 10 >= NRF_POR_DELAY && elapsed <= NRF_POR_DELAY + 1000);  // e a inicializacao
+    CHECK(chip.get_transactions() > 0);
+    CHECK(radio.get_current_mode() == NRF_POWER_DOWN);
+
+    // 'power down' -> 'standby': partida do oscilador, sem bloquear
+    uint64_t start = air.now_ns();
+    radio.begin_mode(NRF_STANDBY);
+    CHECK(air.now_ns() - start < 100000ULL);
+    CHECK(!radio.is_ready());
+    elapsed = time_to_ready(&air, &radio);
+    CHECK(elapsed + 10 >= NRF_POWER_UP_DELAY && elapsed <= NRF_POWER_UP_DELAY + 20);
+
+    // 'standby' -> 'rx': estabilizacao do PLL
+    radio.begin_mode(NRF_RX_MODE);
+    CHECK(radio.get_current_mode() == NRF_RX_MODE);
+    CHECK(!radio.is_ready());
+    elapsed = time_to_ready(&air, &radio);
+    CHECK(elapsed + 10 >= NRF_SETTLE_DELAY && elapsed <= NRF_SETTLE_DELAY + 20);
+
+    // mesma configuracao: nenhuma escrita em CONFIG
+    uint32_t transactions = chip.get_transactions();
+    radio.begin_mode(NRF_RX_MODE);
+    CHECK(chip.get_transactions() == transactions);
+    time_to_ready(&air, &radio);
+
+    // tempos configurados: 'power down' -> 'tx' soma partida e estabilizacao
+    radio.set_settle_times(500, 300);
+    radio.begin_mode(NRF_POWER_DOWN);
+    CHECK(radio.is_ready());
+    radio.begin_mode(NRF_TX_MODE);
+    elapsed = time_to_ready(&air, &radio);
+    CHECK(elapsed + 10 >= 800 && elapsed <= 820);
+
+    // set_mode bloqueia pelo mesmo tempo
+    radio.set_mode(NRF_STANDBY);
+    start = air.now_ns();
+    radio.set_mode(NRF_RX_MODE);
+    CHECK(radio.is_ready());
+    CHECK(air.now_ns() - start >= 300000ULL);
+}
@@ -0,0 +1,56 @@
+/*
+ * Envio sem ACK (W_TX_PAYLOAD_NOACK): difusao para varios receptores no mesmo endereco.
+ */
+#include "testes.h"
+
+static uint16_t broadcast_sent;
+
+static void broadcast_callback(uint16_t frame, bool delivered){
+    (void)frame;
+    if(delivered)
+        broadcast_sent++;
+}
+
+void test_no_ack(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), rx1_chip(&air), rx2_chip(&air);
+    nrf ptx(&ptx_chip), rx1(&rx1_chip), rx2(&rx2_chip);
+    uint8_t data[90], buff[32], length;
+
+    printf("envio sem ACK\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &rx1);
+    wait_ready(&air, &rx2);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&rx1, prx_addr, ptx_addr);
+    configure(&rx2, prx_addr, ptx_addr);
+    for(uint8_t i=0; i<sizeof(data); i++)
+        data[i] = 0xA0 ^ i;
+
+    // sem receptor: o pacote e informado como enviado ao final da transmissao
+    CHECK(ptx.write_tx_payload((uint8_t*)"x", 1, false));
+    ptx.set_mode(NRF_TX_MODE);
+    CHECK(ptx.wait_packet_sent());
+    ptx.set_mode(NRF_STANDBY);
+    CHECK((ptx.get_observe_tx() & ARC_CNT) == 0);
+
+    // os dois receptores recebem todos os pacotes; nenhum deles envia ACK
+    rx1.set_mode(NRF_RX_MODE);
+    rx2.set_mode(NRF_RX_MODE);
+    broadcast_sent = 0;
+    CHECK(ptx.send_stream(data, sizeof(data), 30, broadcast_callback, false) == 3);
+    CHECK(broadcast_sent == 3);
+    nrf *receivers[2] = {&rx1, &rx2};
+    for(uint8_t r=0; r<2; r++){
+        for(uint8_t i=0; i<3; i++){
+            CHECK(receivers[r]->read_received_payload(buff, &length));
+            CHECK(length == 30 && memcmp(buff, &data[30 * i], 30) == 0);
+        }
+        CHECK(!receivers[r]->read_received_payload(buff, &length));
+    }
+
+    // com auto-ack, o envio seguinte volta a aguardar o ACK
+    rx2.set_mode(NRF_STANDBY);
+    CHECK(send_packet(&ptx, (const uint8_t*)"ack", 3));
+    CHECK(rx1.read_received_payload(buff, &length) && length == 3);
+}
@@ -0,0 +1,107 @@
+/*
+ * apply_profile: configuracao completa com escrita apenas dos registradores alterados.
+ */
+#include "testes.h"
+
+static const nrf_profile_t ptx_profile = {
+    76, NRF_1MBPS, NRF_0DBM, NRF_AW_5BYTES, NRF_CRC_2BYTES,
+    5, 1,
+    0, EN_DYN_ACK,
+    prx_addr,
+    { {true, true, 0, prx_addr}, {true, true, 0, ptx_addr} }
+};
+
+static const uint8_t pipe2_lsb[1] = {0x33};
+
+static const nrf_profile_t prx_profile = {
+    76, NRF_1MBPS, NRF_0DBM, NRF_AW_5BYTES, NRF_CRC_2BYTES,
+    5, 1,
+    0, 0,
+    ptx_addr,
+    { {true, true, 0, ptx_addr}, {true, true, 0, prx_addr}, {true, true, 0, pipe2_lsb} }
+};
+
+static const nrf_profile_t late_profile = {
+    76, NRF_1MBPS, NRF_0DBM, NRF_AW_5BYTES, NRF_CRC_2BYTES,
+    5, 1,
+    0, 0,
+    ptx_addr,
+    { {true, true, 0, ptx_addr}, {true, true, 0, prx_addr}, {true, true, 0, NULL} }
+};
+
+void test_apply_profile(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t buff[32], length, pipe;
+
+    printf("apply_profile\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    ptx.apply_profile(&ptx_profile);
+    prx.apply_profile(&prx_profile);
+
+    CHECK(ptx.get_rf_channel() == 76);
+    CHECK(ptx.get_rf_datarate() == NRF_1MBPS);
+    CHECK(ptx.get_crc_mode() == 2);
+    CHECK(ptx.get_retr_param() == ((1 << 4) | 5));
+    CHECK(ptx.verify_registers());
+    CHECK(prx.verify_registers());
+
+    // o perfil ja aplicado nao e escrito novamente
+    uint32_t before = ptx_chip.get_transactions();
+    ptx.apply_profile(&ptx_profile);
+    CHECK(ptx_chip.get_transactions() == before);
+    CHECK(ptx.verify_registers());
+
+    prx.set_mode(NRF_RX_MODE);
+    CHECK(ptx.write_tx_payload((uint8_t*)"perfil", 6));
+    ptx.set_mode(NRF_TX_MODE);
+    CHECK(ptx.wait_packet_sent());
+    ptx.set_mode(NRF_STANDBY);
+    CHECK(prx.read_received_payload(buff, &length, &pipe));
+    CHECK(length == 6 && pipe == NRF_PIPE1 && memcmp(buff, "perfil", 6) == 0);
+
+    // pipe 2: bytes superiores do pipe 1 e LSB do perfil
+    uint8_t addr[5];
+    memcpy(addr, prx_addr, 5);
+    addr[0] = pipe2_lsb[0];
+    ptx.set_tx_address(addr, 5);
+    ptx.set_rx_address(NRF_PIPE0, addr, 5);
+    CHECK(ptx.write_tx_payload((uint8_t*)"pipe2", 5));
+    ptx.set_mode(NRF_TX_MODE);
+    CHECK(ptx.wait_packet_sent());
+    ptx.set_mode(NRF_STANDBY);
+    CHECK(prx.read_received_payload(buff, &length, &pipe));
+    CHECK(length == 5 && pipe == NRF_PIPE2);
+
+    // o perfil restaura os enderecos alterados
+    ptx.apply_profile(&ptx_profile);
+    CHECK(ptx.verify_registers());
+    CHECK(ptx.write_tx_payload((uint8_t*)"perfil", 6));
+    ptx.set_mode(NRF_TX_MODE);
+    CHECK(ptx.wait_packet_sent());
+    ptx.set_mode(NRF_STANDBY);
+    CHECK(prx.read_received_payload(buff, &length, &pipe) && pipe == NRF_PIPE1);
+
+    // perfil aplicado antes do fim do 'power on reset': a inicializacao e concluida antes,
+    // e o LSB do pipe 2 (nao informado) mantem o valor padrao do chip (0xC3)
+    nrf_emu late_chip(&air);
+    nrf late(&late_chip);
+    prx.set_mode(NRF_POWER_DOWN);
+    CHECK(!late.is_ready());
+    late.apply_profile(&late_profile);
+    CHECK(late.is_ready());
+    CHECK(late.verify_registers());
+    CHECK(late.get_rf_channel() == 76);
+    CHECK(late.get_crc_mode() == 2);
+    late.set_mode(NRF_RX_MODE);
+    addr[0] = 0xC3;
+    ptx.set_tx_address(addr, 5);
+    ptx.set_rx_address(NRF_PIPE0, addr, 5);
+    CHECK(ptx.write_tx_payload((uint8_t*)"padrao", 6));
+    ptx.set_mode(NRF_TX_MODE);
+    CHECK(ptx.wait_packet_sent());
+    ptx.set_mode(NRF_STANDBY);
+    CHECK(late.read_received_payload(buff, &length, &pipe) && pipe == NRF_PIPE2);
+}
@@ -0,0 +1,47 @@
+/*
+ * scan_channels: histograma de RPD por canal, com ruido emulado.
+ */
+#include "testes.h"
+
+void test_scan_channels(void){
+    nrf_air air;
+    nrf_emu chip(&air);
+    nrf radio(&chip);
+    uint8_t hist[126];
+
+    printf("scan_channels\n");
+    wait_ready(&air, &radio);
+    configure(&radio, ptx_addr, prx_addr);
+    radio.set_mode(NRF_STANDBY);
+
+    // ruido apenas nos canais 40 e 41
+    air.set_noise(40, true);
+    air.set_noise(41, true);
+    memset(hist, 0xAA, sizeof(hist));
+    radio.scan_channels(hist, 3, 0, 125);
+    uint8_t noisy = 0, wrong = 0;
+    for(uint8_t ch=0; ch<=125; ch++){
+        if(ch == 40 || ch == 41)
+            noisy += (hist[ch] == 3);
+        else if(hist[ch] != 0)
+            wrong++;
+    }
+    CHECK(noisy == 2);
+    CHECK(wrong == 0);
+
+    // faixa parcial: hist[0] corresponde ao primeiro canal; demais posicoes intactas
+    memset(hist, 0xAA, sizeof(hist));
+    radio.scan_channels(hist, 2, 38, 42);
+    CHECK(hist[0] == 0 && hist[1] == 0 && hist[2] == 2 && hist[3] == 2 && hist[4] == 0);
+    CHECK(hist[5] == 0xAA);
+
+    // canal e modo restaurados
+    CHECK(radio.get_rf_channel() == 25);
+    CHECK(radio.get_current_mode() == NRF_STANDBY);
+    CHECK(radio.verify_registers());
+
+    // primeiro canal apos o ultimo: nada e alterado
+    memset(hist, 0xAA, sizeof(hist));
+    radio.scan_channels(hist, 1, 50, 40);
+    CHECK(hist[0] == 0xAA);
+}
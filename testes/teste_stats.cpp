@@ -0,0 +1,52 @@
+/*
+ * Estatisticas de enlace (NRF_STATS): contadores por destino e por pipe.
+ *
+ * Compilar com -DNRF_STATS=1; caso contrario, o teste e ignorado.
+ */
+#include "testes.h"
+
+void test_stats(void){
+#if NRF_STATS
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    nrf_stats_t stats;
+    uint8_t addr[5], buff[32], length;
+
+    printf("estatisticas\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    ptx.set_retr_param(1, 0);
+
+    // sem receptor: perdas alem da saturacao de PLOS_CNT (15) continuam sendo contadas
+    for(uint8_t i=0; i<40; i++)
+        CHECK(!send_packet(&ptx, &i, 1));
+    CHECK(ptx.get_destination_stats(0, &stats, addr));
+    CHECK(memcmp(addr, prx_addr, 5) == 0);
+    CHECK(stats.lost == 40);
+    CHECK(stats.failures == 40);
+    CHECK(stats.packets == 0 && stats.success == 0);
+    CHECK(ptx.get_rf_channel() == 25);
+    CHECK((ptx.get_observe_tx() & PLOS_CNT) >> 4 < 15);
+
+    // com receptor
+    ptx.set_retr_param(15, 1);
+    prx.set_mode(NRF_RX_MODE);
+    for(uint8_t i=0; i<5; i++){
+        CHECK(send_packet(&ptx, &i, 1));
+        while(prx.read_received_payload(buff, &length));
+    }
+    CHECK(ptx.get_destination_stats(0, &stats, NULL, true));
+    CHECK(stats.packets == 5 && stats.lost == 40 && stats.bytes == 45);
+    CHECK(ptx.get_destination_stats(0, &stats));
+    CHECK(stats.packets == 0 && stats.lost == 0);
+    CHECK(!ptx.get_destination_stats(1, &stats));
+
+    prx.get_pipe_stats(NRF_PIPE1, &stats);
+    CHECK(stats.packets == 5 && stats.bytes == 5 && stats.failures == 0);
+#else
+    printf("estatisticas: ignorado (NRF_STATS=0)\n");
+#endif
+}
@@ -0,0 +1,77 @@
+/*
+ * Envio continuo (send_stream): FIFO de TX completado a cada pacote, resultado por pacote.
+ */
+#include "testes.h"
+
+static nrf *stream_rx;
+static uint8_t stream_data[200];
+static uint16_t stream_length;
+static uint16_t stream_delivered, stream_failed;
+static uint16_t stream_frame;      // proximo pacote esperado pela funcao de retorno
+static bool stream_in_order;
+
+/* o FIFO de recepcao tem tres niveis: o receptor e lido a cada pacote */
+static void stream_callback(uint16_t frame, bool delivered){
+    uint8_t buff[32], length;
+    if(frame != stream_frame++)
+        stream_in_order = false;
+    if(delivered)
+        stream_delivered++;
+    else
+        stream_failed++;
+    while(stream_rx->read_received_payload(buff, &length)){
+        memcpy(&stream_data[stream_length], buff, length);
+        stream_length += length;
+    }
+}
+
+void test_send_stream(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    uint8_t data[150];
+    uint8_t buff[32], length;
+
+    printf("send_stream\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    prx.set_mode(NRF_RX_MODE);
+    air.set_loss(25, 10);
+
+    for(uint8_t i=0; i<sizeof(data); i++)
+        data[i] = i * 7;
+    stream_rx = &prx;
+    stream_length = 0;
+    stream_delivered = 0;
+    stream_failed = 0;
+    stream_frame = 0;
+    stream_in_order = true;
+
+    // 150 bytes em pacotes de 32: o ultimo pacote tem 22 bytes
+    uint16_t delivered = ptx.send_stream(data, sizeof(data), 32, stream_callback);
+    while(prx.read_received_payload(buff, &length)){
+        memcpy(&stream_data[stream_length], buff, length);
+        stream_length += length;
+    }
+
+    CHECK(delivered == 5);
+    CHECK(stream_delivered == 5);
+    CHECK(stream_failed == 0);
+    CHECK(stream_in_order);
+    CHECK(stream_length == sizeof(data));
+    CHECK(memcmp(stream_data, data, sizeof(data)) == 0);
+    CHECK(ptx.get_current_mode() == NRF_STANDBY);
+
+    // sem receptor: todos os pacotes sao descartados apos MAX_RT
+    prx.set_mode(NRF_STANDBY);
+    stream_delivered = 0;
+    stream_failed = 0;
+    stream_frame = 0;
+    delivered = ptx.send_stream(data, 64, 32, stream_callback);
+    CHECK(delivered == 0);
+    CHECK(stream_delivered == 0);
+    CHECK(stream_failed == 2);
+    CHECK(stream_in_order);
+}
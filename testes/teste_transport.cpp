@@ -0,0 +1,81 @@
+/*
+ * Camada de transporte: fragmentacao, remontagem e descarte de mensagens incompletas.
+ */
+#include "testes.h"
+#include "nrf_transport.h"
+
+/* escreve um fragmento diretamente, sem a camada de transporte */
+static bool send_fragment(nrf *ptx, uint8_t id, uint8_t index, const uint8_t *data, uint8_t size){
+    uint8_t frame[32];
+    frame[0] = id;
+    frame[1] = index;
+    memcpy(&frame[NRF_TRANSPORT_HEADER], data, size);
+    return send_packet(ptx, frame, size + NRF_TRANSPORT_HEADER);
+}
+
+void test_transport(void){
+    nrf_air air;
+    nrf_emu ptx_chip(&air), prx_chip(&air);
+    nrf ptx(&ptx_chip), prx(&prx_chip);
+    nrf_transport tx(&ptx), rx(&prx);
+    uint8_t message[80], buff[64], pipe;
+    uint16_t length;
+
+    printf("nrf_transport\n");
+    wait_ready(&air, &ptx);
+    wait_ready(&air, &prx);
+    configure(&ptx, ptx_addr, prx_addr);
+    configure(&prx, prx_addr, ptx_addr);
+    prx.set_mode(NRF_RX_MODE);
+    for(uint8_t i=0; i<sizeof(message); i++)
+        message[i] = i + 1;
+
+    // sem buffer no pipe, os fragmentos sao ignorados
+    CHECK(tx.send(message, 20));
+    CHECK(!rx.receive(&pipe, &length));
+    CHECK(rx.get_dropped() == 0);
+
+    // tres fragmentos (30 + 30 + 4 bytes), remontados no buffer do pipe 1
+    rx.set_buffer(NRF_PIPE1, buff, sizeof(buff));
+    CHECK(tx.send(message, 64));
+    CHECK(rx.receive(&pipe, &length));
+    CHECK(pipe == NRF_PIPE1 && length == 64);
+    CHECK(memcmp(buff, message, 64) == 0);
+    CHECK(!rx.receive(&pipe, &length));
+
+    // mensagem de um fragmento e mensagem vazia
+    CHECK(tx.send(message, 5));
+    CHECK(rx.receive(&pipe, &length) && length == 5 && memcmp(buff, message, 5) == 0);
+    CHECK(tx.send(message, 0));
+    CHECK(rx.receive(&pipe, &length) && length == 0);
+    CHECK(rx.get_dropped() == 0);
+
+    // fragmento do meio perdido: a mensagem e descartada
+    CHECK(send_fragment(&ptx, 0x40, 0, message, 30));
+    CHECK(send_fragment(&ptx, 0x40, 2 | NRF_TRANSPORT_LAST, &message[60], 4));
+    CHECK(!rx.receive(&pipe, &length));
+    CHECK(rx.get_dropped() == 1);
+
+    // maior que o buffer do pipe
+    CHECK(tx.send(message, 80));
+    CHECK(!rx.receive(&pipe, &length));
+    CHECK(rx.get_dropped() == 2);
+
+    // fragmento seguinte apos o tempo maximo
+    rx.set_timeout(20);
+    CHECK(send_fragment(&ptx, 0x41, 0, message, 30));
+    CHECK(!rx.receive(&pipe, &length));
+    air.advance(10000);
+    CHECK(!rx.receive(&pipe, &length));
+    CHECK(rx.get_dropped() == 2);       // ainda dentro do tempo
+    air.advance(15000);
+    CHECK(!rx.receive(&pipe, &length));
+    CHECK(rx.get_dropped() == 3);
+    CHECK(send_fragment(&ptx, 0x41, 1 | NRF_TRANSPORT_LAST, &message[30], 4));
+    CHECK(!rx.receive(&pipe, &length));
+
+    // a mensagem seguinte e recebida normalmente
+    CHECK(tx.send(message, 40));
+    CHECK(rx.receive(&pipe, &length) && length == 40 && memcmp(buff, message, 40) == 0);
+    CHECK(rx.get_dropped() == 3);
+}
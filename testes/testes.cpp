@@ -0,0 +1,68 @@
+// Testes da biblioteca com chips emulados (ver nrf_emu.h), sem hardware.
+//
+// Compilar e executar na pasta da biblioteca:
+//   g++ -I. *.cpp testes/*.cpp -o testes_nrf
+//   ./testes_nrf
+//
+// As estatisticas de enlace sao verificadas apenas com -DNRF_STATS=1.
+// Os arquivos especificos de Arduino e Linux sao ignorados pelo pre-processador. Retorna 0 se
+// todas as verificacoes passarem.
+#include "testes.h"
+
+int checks = 0, failures = 0;
+
+const uint8_t ptx_addr[5] = {12,48,68,99,14};
+const uint8_t prx_addr[5] = {17,11,22,134,192};
+
+/* aguarda o 'power on reset' do chip (relogio virtual) */
+void wait_ready(nrf_air *air, nrf *radio){
+    while(!radio->is_ready())
+        air->advance(1000);
+}
+
+/* canal 25, 2Mbps, payload dinamico nos pipes 0 e 1, 15 retransmissoes */
+void configure(nrf *radio, const uint8_t *own, const uint8_t *peer){
+    radio->set_rf_datarate(NRF_2MBPS);
+    radio->set_rf_channel(25);
+    radio->set_address_width(NRF_AW_5BYTES);
+    radio->enable_rx_pipe(NRF_PIPE0, true);
+    radio->enable_rx_pipe(NRF_PIPE1, true);
+    radio->set_dynamic_payload(NRF_PIPE0, true);
+    radio->set_dynamic_payload(NRF_PIPE1, true);
+    radio->set_retr_param(15, 1);
+    radio->set_rx_address(NRF_PIPE0, (uint8_t*)peer, 5);
+    radio->set_rx_address(NRF_PIPE1, (uint8_t*)own, 5);
+    radio->set_tx_address((uint8_t*)peer, 5);
+}
+
+/* envio bloqueante de um pacote, com retorno ao modo 'standby' */
+bool send_packet(nrf *ptx, const uint8_t *buff, uint8_t length){
+    if(!ptx->write_tx_payload((uint8_t*)buff, length))
+        return false;
+    ptx->set_mode(NRF_TX_MODE);
+    bool sent = ptx->wait_packet_sent();
+    ptx->set_mode(NRF_STANDBY);
+    return sent;
+}
+
+int main(void){
+    printf("<< Testes com chips emulados >>\n\n");
+    test_emulator();
+    test_rx_interrupt();
+    test_send_stream();
+    test_transport();
+    test_ack_payload();
+    test_no_ack();
+    test_beacon();
+    test_apply_profile();
+    test_begin_mode();
+    test_send_async();
+    test_hub();
+    test_link();
+    test_scan_channels();
+    test_hopper();
+    test_stats();
+    test_listen();
+    printf("\n%d verificacoes, %d falhas\n", checks, failures);
+    return failures? 1 : 0;
+}
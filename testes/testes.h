@@ -0,0 +1,51 @@
+/*
+ * Testes da biblioteca com chips emulados (ver nrf_emu.h), sem hardware.
+ *
+ * Cada arquivo testes/teste_*.cpp verifica um recurso da biblioteca. As funcoes de teste sao
+ * declaradas aqui e chamadas por main (testes.cpp).
+ */
+#ifndef TESTES_H
+#define TESTES_H
+
+#include<stdio.h>
+#include<string.h>
+#include "nrf.h"
+#include "nrf_emu.h"
+
+extern int checks, failures;
+
+/* registra uma verificacao; em caso de falha, informa o arquivo e a linha */
+#define CHECK(cond) do{ \
+    checks++; \
+    if(!(cond)){ \
+        failures++; \
+        printf("  FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+}while(0)
+
+/* device addresses */
+extern const uint8_t ptx_addr[5];
+extern const uint8_t prx_addr[5];
+
+void wait_ready(nrf_air *air, nrf *radio);
+void configure(nrf *radio, const uint8_t *own, const uint8_t *peer);
+bool send_packet(nrf *ptx, const uint8_t *buff, uint8_t length);
+
+void test_emulator(void);
+void test_rx_interrupt(void);
+void test_send_stream(void);
+void test_transport(void);
+void test_ack_payload(void);
+void test_no_ack(void);
+void test_beacon(void);
+void test_apply_profile(void);
+void test_begin_mode(void);
+void test_send_async(void);
+void test_hub(void);
+void test_link(void);
+void test_scan_channels(void);
+void test_hopper(void);
+void test_stats(void);
+void test_listen(void);
+
+#endif